@@ -0,0 +1,363 @@
+/**
+    @file
+
+    Micro-benchmarks of the PIDL engine.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include <washer/shell/pidl.hpp> // apidl_t, cpidl_t, raw_pidl
+#include <washer/shell/pidl_iterator.hpp> // pidl iterators
+
+#define BOOST_CHRONO_HEADER_ONLY
+#include <boost/chrono/duration.hpp> // duration_cast, nanoseconds
+#include <boost/chrono/system_clocks.hpp> // steady_clock
+#include <boost/lexical_cast.hpp> // lexical_cast
+
+#include <cstddef> // size_t
+#include <cstdio> // printf
+#include <cstring> // memcpy
+#include <exception>
+#include <iostream> // cerr
+#include <string>
+#include <vector>
+
+using namespace washer::shell::pidl;
+
+using boost::chrono::duration_cast;
+using boost::chrono::nanoseconds;
+using boost::chrono::steady_clock;
+using boost::lexical_cast;
+
+using std::size_t;
+using std::string;
+using std::vector;
+
+namespace {
+
+    /**
+     * Result of benchmarked operations is accumulated here so the compiler
+     * can't optimise the operations away.
+     */
+    volatile size_t sink = 0;
+
+    /**
+     * The kinds of PIDL the shell commonly hands out.
+     */
+    struct pidl_shape
+    {
+        const char* name;
+        size_t depth; ///< Number of items
+        size_t item_size; ///< Size of each item in bytes, including cb
+    };
+
+    const pidl_shape shapes[] = {
+        // Control Panel and friends: a couple of GUID-sized root items
+        { "virtual-root", 2, 20 },
+        // C:\Users\me\Documents\project\file.txt: file-system items carry
+        // the short name, attributes, dates and a Unicode extension block
+        { "filesystem", 6, 90 },
+        // Deep source trees and build directories
+        { "deep-filesystem", 24, 90 },
+        // Namespace extensions that stash a lot of metadata in each item
+        { "fat-items", 4, 400 }
+    };
+
+    /**
+     * Fill a buffer with deterministic but irregular bytes.
+     */
+    class byte_source
+    {
+    public:
+        explicit byte_source(unsigned int seed) : m_state(seed) {}
+
+        BYTE next()
+        {
+            m_state = m_state * 1103515245U + 12345U;
+            return static_cast<BYTE>(m_state >> 16);
+        }
+
+    private:
+        unsigned int m_state;
+    };
+
+    /**
+     * Write an item of the given size, including its cb field, filled with
+     * bytes from the source.
+     */
+    void fill_item(BYTE* item, size_t item_size, byte_source& source)
+    {
+        USHORT cb = static_cast<USHORT>(item_size);
+        std::memcpy(item, &cb, sizeof(cb));
+
+        for (size_t i = sizeof(cb); i < item_size; ++i)
+        {
+            item[i] = source.next();
+        }
+    }
+
+    /**
+     * Absolute PIDL of the given shape.
+     *
+     * PIDLs made from the same seed are identical except for the very last
+     * byte of their last item, the worst case for comparisons.
+     */
+    apidl_t make_pidl(const pidl_shape& shape, BYTE last_byte)
+    {
+        size_t item_bytes = shape.depth * shape.item_size;
+        vector<BYTE> bytes(item_bytes + sizeof(USHORT));
+        byte_source source(42);
+
+        for (size_t i = 0; i < shape.depth; ++i)
+        {
+            fill_item(&bytes[i * shape.item_size], shape.item_size, source);
+        }
+
+        bytes.at(item_bytes - 1) = last_byte;
+        return apidl_t(reinterpret_cast<PCIDLIST_ABSOLUTE>(&bytes[0]));
+    }
+
+    /**
+     * Child PIDL with a single item of the shape's item size.
+     */
+    cpidl_t make_child(const pidl_shape& shape)
+    {
+        vector<BYTE> bytes(shape.item_size + sizeof(USHORT));
+        byte_source source(7);
+
+        fill_item(&bytes[0], shape.item_size, source);
+
+        return cpidl_t(reinterpret_cast<PCUITEMID_CHILD>(&bytes[0]));
+    }
+
+    /**
+     * The PIDLs each operation is run against.
+     */
+    struct subject
+    {
+        subject(const pidl_shape& shape) :
+            pidl(make_pidl(shape, 1)), sibling(make_pidl(shape, 2)),
+            child(make_child(shape)) {}
+
+        apidl_t pidl;
+        apidl_t sibling;
+        cpidl_t child;
+    };
+
+    /**
+     * @name Benchmarked operations
+     *
+     * Each performs the operation once and feeds something that depends on
+     * its result into the sink.
+     */
+    // @{
+
+    void clone(const subject& s)
+    {
+        apidl_t copy(s.pidl);
+        sink += copy.get()->mkid.cb;
+    }
+
+    void combine(const subject& s)
+    {
+        apidl_t combined = s.pidl + s.child;
+        sink += combined.get()->mkid.cb;
+    }
+
+    void parent(const subject& s)
+    {
+        apidl_t parent = s.pidl.parent();
+        sink += parent.get()->mkid.cb;
+    }
+
+    void view_parent(const subject& s)
+    {
+        sink += apidl_view(s.pidl).parent().item_bytes();
+    }
+
+    void last_item(const subject& s)
+    {
+        cpidl_t item = s.pidl.last_item();
+        sink += item.get()->mkid.cb;
+    }
+
+    void size(const subject& s)
+    {
+        sink += s.pidl.size();
+    }
+
+    void raw_iteration(const subject& s)
+    {
+        for (raw_pidl_iterator it(s.pidl.get()); it != raw_pidl_iterator();
+             ++it)
+        {
+            sink += (*it)->mkid.cb;
+        }
+    }
+
+    void view_iteration(const subject& s)
+    {
+        for (pidl_view_iterator it(s.pidl); it != pidl_view_iterator(); ++it)
+        {
+            sink += it->item_bytes();
+        }
+    }
+
+    void cloning_iteration(const subject& s)
+    {
+        for (pidl_iterator it(s.pidl); it != pidl_iterator(); ++it)
+        {
+            sink += it->get()->mkid.cb;
+        }
+    }
+
+    void equality(const subject& s)
+    {
+        sink += (s.pidl == s.sibling);
+    }
+
+    void ordering(const subject& s)
+    {
+        sink += raw_pidl::compare(s.pidl.get(), s.sibling.get()) < 0;
+    }
+
+    void prefix(const subject& s)
+    {
+        sink += raw_pidl::common_prefix_length(s.pidl.get(), s.sibling.get());
+    }
+
+    void hash(const subject& s)
+    {
+        sink += hash_value(s.pidl);
+    }
+
+    // @}
+
+    typedef void (*operation_function)(const subject&);
+
+    struct operation
+    {
+        const char* name;
+        operation_function run;
+    };
+
+    const operation operations[] = {
+        { "clone", clone },
+        { "combine", combine },
+        { "parent", parent },
+        { "view-parent", view_parent },
+        { "last_item", last_item },
+        { "size", size },
+        { "raw-iteration", raw_iteration },
+        { "view-iteration", view_iteration },
+        { "cloning-iteration", cloning_iteration },
+        { "equality", equality },
+        { "ordering", ordering },
+        { "common-prefix", prefix },
+        { "hash", hash }
+    };
+
+    template<typename T, size_t N>
+    size_t count_of(const T (&)[N])
+    {
+        return N;
+    }
+
+    /**
+     * Average time taken by one run of the operation in nanoseconds.
+     *
+     * The number of runs is doubled until a batch takes at least
+     * @a min_time so that short operations aren't swamped by the cost of
+     * reading the clock.
+     */
+    double time_operation(
+        operation_function run, const subject& s, nanoseconds min_time)
+    {
+        for (size_t runs = 1; ; runs *= 2)
+        {
+            steady_clock::time_point start = steady_clock::now();
+            for (size_t i = 0; i < runs; ++i)
+            {
+                run(s);
+            }
+            nanoseconds elapsed =
+                duration_cast<nanoseconds>(steady_clock::now() - start);
+
+            if (elapsed >= min_time)
+                return static_cast<double>(elapsed.count()) / runs;
+        }
+    }
+}
+
+/**
+ * Times each operation against each shape of PIDL and prints a table of
+ * nanoseconds per operation.
+ *
+ * Usage: pidl_bench [milliseconds per measurement] [operation filter]
+ *
+ * Only operations whose name contains the filter are run.
+ */
+int main(int argc, char* argv[])
+{
+    try
+    {
+        nanoseconds min_time = boost::chrono::milliseconds(
+            (argc > 1) ? lexical_cast<int>(argv[1]) : 100);
+        string filter = (argc > 2) ? argv[2] : "";
+
+        std::printf("%-18s", "operation (ns)");
+        for (size_t i = 0; i < count_of(shapes); ++i)
+        {
+            std::printf(" %16s", shapes[i].name);
+        }
+        std::printf("\n");
+
+        vector<subject> subjects(shapes, shapes + count_of(shapes));
+
+        for (size_t op = 0; op < count_of(operations); ++op)
+        {
+            if (string(operations[op].name).find(filter) == string::npos)
+                continue;
+
+            std::printf("%-18s", operations[op].name);
+            for (size_t i = 0; i < subjects.size(); ++i)
+            {
+                std::printf(
+                    " %16.1f",
+                    time_operation(operations[op].run, subjects[i], min_time));
+                std::fflush(stdout);
+            }
+            std::printf("\n");
+        }
+
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,147 @@
+/**
+    @file
+
+    Sharing interface pointers between apartments through the GIT.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_COM_GLOBAL_INTERFACE_TABLE_HPP
+#define WASHER_COM_GLOBAL_INTERFACE_TABLE_HPP
+#pragma once
+
+#include <comet/error.h> // com_error
+#include <comet/ptr.h> // com_ptr
+
+#include <boost/exception/errinfo_api_function.hpp> // errinfo_api_function
+#include <boost/exception/info.hpp> // errinfo
+#include <boost/noncopyable.hpp> // noncopyable
+#include <boost/throw_exception.hpp> // BOOST_THROW_EXCEPTION
+
+#include <objbase.h> // CoCreateInstance
+#include <ObjIdl.h> // IGlobalInterfaceTable
+
+namespace washer {
+namespace com {
+
+/**
+ * The process's Global Interface Table.
+ *
+ * The table is free-threaded so, unlike the interfaces registered in it,
+ * this pointer can be used from any apartment.
+ */
+inline comet::com_ptr<IGlobalInterfaceTable> global_interface_table()
+{
+    comet::com_ptr<IGlobalInterfaceTable> table;
+    HRESULT hr = ::CoCreateInstance(
+        CLSID_StdGlobalInterfaceTable, NULL, CLSCTX_INPROC_SERVER,
+        IID_IGlobalInterfaceTable, reinterpret_cast<void**>(table.out()));
+    if (FAILED(hr))
+        BOOST_THROW_EXCEPTION(
+            boost::enable_error_info(comet::com_error(hr)) <<
+            boost::errinfo_api_function("CoCreateInstance"));
+
+    return table;
+}
+
+/**
+ * Interface registered in the Global Interface Table, as usable in the
+ * calling apartment.
+ *
+ * The result is the original pointer if the calling apartment is the one it
+ * was registered from, or if the object is free-threaded, and a proxy
+ * otherwise.
+ */
+template<typename T>
+inline comet::com_ptr<T> interface_from_global(DWORD cookie)
+{
+    comet::com_ptr<T> object;
+    HRESULT hr = global_interface_table()->GetInterfaceFromGlobal(
+        cookie, object.iid(), reinterpret_cast<void**>(object.out()));
+    if (FAILED(hr))
+        BOOST_THROW_EXCEPTION(
+            boost::enable_error_info(comet::com_error(hr)) <<
+            boost::errinfo_api_function("GetInterfaceFromGlobal"));
+
+    return object;
+}
+
+/**
+ * Registration of an interface pointer in the Global Interface Table.
+ *
+ * While the registration lasts, any apartment can get its own usable copy
+ * of the interface with get(), or with interface_from_global() given the
+ * cookie.  The interface is revoked from the table when the registration is
+ * destroyed.
+ */
+template<typename T>
+class global_interface : private boost::noncopyable
+{
+public:
+
+    /**
+     * Register an interface pointer belonging to the calling apartment.
+     */
+    explicit global_interface(const comet::com_ptr<T>& object)
+        : m_table(global_interface_table()), m_cookie(0)
+    {
+        HRESULT hr = m_table->RegisterInterfaceInGlobal(
+            object.get(), object.iid(), &m_cookie);
+        if (FAILED(hr))
+            BOOST_THROW_EXCEPTION(
+                boost::enable_error_info(comet::com_error(hr)) <<
+                boost::errinfo_api_function("RegisterInterfaceInGlobal"));
+    }
+
+    ~global_interface() throw()
+    {
+        m_table->RevokeInterfaceFromGlobal(m_cookie);
+    }
+
+    /**
+     * Identifies the interface in the table.
+     */
+    DWORD cookie() const
+    {
+        return m_cookie;
+    }
+
+    /**
+     * The interface as usable in the calling apartment.
+     */
+    comet::com_ptr<T> get() const
+    {
+        return interface_from_global<T>(m_cookie);
+    }
+
+private:
+    comet::com_ptr<IGlobalInterfaceTable> m_table;
+    DWORD m_cookie;
+};
+
+}} // namespace washer::com
+
+#endif
@@ -0,0 +1,254 @@
+/**
+    @file
+
+    Read-only memory-mapped files.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_DETAIL_FILE_MAPPING_HPP
+#define WASHER_DETAIL_FILE_MAPPING_HPP
+#pragma once
+
+#include <boost/exception/info.hpp> // errinfo
+#include <boost/exception/errinfo_api_function.hpp> // errinfo_api_function
+#include <boost/exception/errinfo_file_name.hpp> // errinfo_file_name
+#include <boost/filesystem/path.hpp> // path
+#include <boost/noncopyable.hpp> // noncopyable
+#include <boost/system/system_error.hpp> // system_error
+#include <boost/throw_exception.hpp> // BOOST_THROW_EXCEPTION
+
+#include <cstddef> // size_t
+#include <limits> // numeric_limits
+#include <stdexcept> // length_error
+
+#ifdef _WIN32
+#include "washer/error.hpp" // last_error
+
+#include <Windows.h> // CreateFile, CreateFileMapping, MapViewOfFile
+#else
+#include <cerrno> // errno
+
+#include <fcntl.h> // open
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h> // close
+#endif
+
+namespace washer {
+namespace detail {
+
+/**
+ * A whole file mapped read-only into memory.
+ *
+ * Uses the native mapping API of the platform, so it works the same on
+ * Windows and POSIX systems.  The mapping stays valid for the lifetime of
+ * this object even if the file is renamed or deleted.
+ *
+ * Empty files cannot be mapped so they give a NULL data pointer and a size
+ * of zero.
+ */
+class read_only_file_mapping : private boost::noncopyable
+{
+public:
+
+    explicit read_only_file_mapping(const boost::filesystem::path& file)
+        : m_data(NULL), m_size(0)
+#ifdef _WIN32
+        , m_file(INVALID_HANDLE_VALUE), m_mapping(NULL)
+#endif
+    {
+        try
+        {
+            map(file);
+        }
+        catch (...)
+        {
+            unmap();
+            throw;
+        }
+    }
+
+    ~read_only_file_mapping() throw()
+    {
+        unmap();
+    }
+
+    /**
+     * Start of the file's contents.
+     */
+    const unsigned char* data() const
+    {
+        return m_data;
+    }
+
+    /**
+     * Size of the file in bytes.
+     */
+    std::size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+
+#ifdef _WIN32
+
+    void map(const boost::filesystem::path& file)
+    {
+        m_file = ::CreateFileW(
+            file.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (m_file == INVALID_HANDLE_VALUE)
+            BOOST_THROW_EXCEPTION(
+                boost::enable_error_info(washer::last_error()) <<
+                boost::errinfo_api_function("CreateFile") <<
+                boost::errinfo_file_name(file.string()));
+
+        LARGE_INTEGER size;
+        if (!::GetFileSizeEx(m_file, &size))
+            BOOST_THROW_EXCEPTION(
+                boost::enable_error_info(washer::last_error()) <<
+                boost::errinfo_api_function("GetFileSizeEx") <<
+                boost::errinfo_file_name(file.string()));
+
+        check_size(size.QuadPart);
+        if (size.QuadPart == 0)
+            return;
+
+        m_mapping = ::CreateFileMappingW(
+            m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!m_mapping)
+            BOOST_THROW_EXCEPTION(
+                boost::enable_error_info(washer::last_error()) <<
+                boost::errinfo_api_function("CreateFileMapping") <<
+                boost::errinfo_file_name(file.string()));
+
+        const void* view = ::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!view)
+            BOOST_THROW_EXCEPTION(
+                boost::enable_error_info(washer::last_error()) <<
+                boost::errinfo_api_function("MapViewOfFile") <<
+                boost::errinfo_file_name(file.string()));
+
+        m_data = static_cast<const unsigned char*>(view);
+        m_size = static_cast<std::size_t>(size.QuadPart);
+    }
+
+    void unmap() throw()
+    {
+        if (m_data)
+            ::UnmapViewOfFile(m_data);
+        if (m_mapping)
+            ::CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE)
+            ::CloseHandle(m_file);
+
+        m_data = NULL;
+        m_size = 0;
+        m_mapping = NULL;
+        m_file = INVALID_HANDLE_VALUE;
+    }
+
+#else
+
+    void map(const boost::filesystem::path& file)
+    {
+        int fd = ::open(file.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw_last_error("open", file);
+
+        try
+        {
+            struct stat status;
+            if (::fstat(fd, &status) != 0)
+                throw_last_error("fstat", file);
+
+            check_size(status.st_size);
+            if (status.st_size > 0)
+            {
+                void* view = ::mmap(
+                    NULL, static_cast<std::size_t>(status.st_size),
+                    PROT_READ, MAP_SHARED, fd, 0);
+                if (view == MAP_FAILED)
+                    throw_last_error("mmap", file);
+
+                m_data = static_cast<const unsigned char*>(view);
+                m_size = static_cast<std::size_t>(status.st_size);
+            }
+        }
+        catch (...)
+        {
+            ::close(fd);
+            throw;
+        }
+
+        // The mapping holds its own reference to the file
+        ::close(fd);
+    }
+
+    void unmap() throw()
+    {
+        if (m_data)
+            ::munmap(const_cast<unsigned char*>(m_data), m_size);
+
+        m_data = NULL;
+        m_size = 0;
+    }
+
+    static void throw_last_error(
+        const char* function, const boost::filesystem::path& file)
+    {
+        BOOST_THROW_EXCEPTION(
+            boost::enable_error_info(
+                boost::system::system_error(
+                    errno, boost::system::system_category())) <<
+            boost::errinfo_api_function(function) <<
+            boost::errinfo_file_name(file.string()));
+    }
+
+#endif
+
+    template<typename Size>
+    static void check_size(Size size)
+    {
+        if (static_cast<unsigned long long>(size) >
+            (std::numeric_limits<std::size_t>::max)())
+            BOOST_THROW_EXCEPTION(
+                std::length_error("File too large to map into memory"));
+    }
+
+    const unsigned char* m_data;
+    std::size_t m_size;
+#ifdef _WIN32
+    HANDLE m_file;
+    HANDLE m_mapping;
+#endif
+};
+
+}} // namespace washer::detail
+
+#endif
@@ -0,0 +1,106 @@
+/**
+    @file
+
+    Stand-ins for the Windows SDK's shell item ID types on other platforms.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_DETAIL_PORTABLE_SHELL_TYPES_HPP
+#define WASHER_DETAIL_PORTABLE_SHELL_TYPES_HPP
+#pragma once
+
+/*
+ * The PIDL classes only ever manipulate the bytes of item ID lists so,
+ * other than the memory allocator, they need nothing from Windows except
+ * the type definitions.  This header supplies those definitions, laid out
+ * exactly as in <ShTypes.h> with STRICT_TYPED_ITEMIDS, so the PIDL engine
+ * can be built, tested and profiled on other platforms.
+ *
+ * CoTaskMemAlloc and CoTaskMemFree are replaced by malloc and free, which
+ * is what the COM task allocator amounts to for our purposes.  Nothing
+ * that talks to the shell itself is available.
+ *
+ * Windows builds must use the real SDK headers.
+ */
+
+#ifdef _WIN32
+#error Use the Windows SDK headers on Windows
+#endif
+
+#include <cstddef> // size_t
+#include <cstdlib> // malloc, free
+
+#ifndef __unaligned
+#define __unaligned
+#endif
+
+typedef unsigned char BYTE;
+typedef unsigned short USHORT;
+typedef unsigned int UINT;
+
+#pragma pack(push, 1)
+
+typedef struct _SHITEMID
+{
+    USHORT cb;
+    BYTE abID[1];
+} SHITEMID;
+
+typedef struct _ITEMIDLIST
+{
+    SHITEMID mkid;
+} ITEMIDLIST;
+
+typedef struct _ITEMIDLIST_RELATIVE : ITEMIDLIST {} ITEMIDLIST_RELATIVE;
+typedef struct _ITEMID_CHILD : ITEMIDLIST_RELATIVE {} ITEMID_CHILD;
+typedef struct _ITEMIDLIST_ABSOLUTE : ITEMIDLIST_RELATIVE {}
+    ITEMIDLIST_ABSOLUTE;
+
+#pragma pack(pop)
+
+typedef ITEMIDLIST_ABSOLUTE* PIDLIST_ABSOLUTE;
+typedef const ITEMIDLIST_ABSOLUTE* PCIDLIST_ABSOLUTE;
+typedef const ITEMIDLIST_ABSOLUTE __unaligned* PCUIDLIST_ABSOLUTE;
+typedef ITEMIDLIST_RELATIVE* PIDLIST_RELATIVE;
+typedef ITEMIDLIST_RELATIVE __unaligned* PUIDLIST_RELATIVE;
+typedef const ITEMIDLIST_RELATIVE __unaligned* PCUIDLIST_RELATIVE;
+typedef ITEMID_CHILD* PITEMID_CHILD;
+typedef ITEMID_CHILD __unaligned* PUITEMID_CHILD;
+typedef const ITEMID_CHILD __unaligned* PCUITEMID_CHILD;
+typedef const PCUITEMID_CHILD* PCUITEMID_CHILD_ARRAY;
+
+inline void* CoTaskMemAlloc(std::size_t size)
+{
+    return std::malloc(size);
+}
+
+inline void CoTaskMemFree(void* mem)
+{
+    std::free(mem);
+}
+
+#endif
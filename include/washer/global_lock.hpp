@@ -1,7 +1,7 @@
 /**
     @file
 
-    Manage Windows global memory locks.
+    Manage Windows global memory and its locks.
 
     @if license
 
@@ -38,11 +38,115 @@
 #include <boost/exception/errinfo_api_function.hpp> // errinfo_api_function
 #include <boost/exception/info.hpp> // errinfo
 #include <boost/throw_exception.hpp> // BOOST_THROW_EXCEPTION
+#include <boost/version.hpp>
+#if (BOOST_VERSION >= 104800)
+#include <boost/move/move.hpp> // BOOST_RV_REF, BOOST_MOVABLE_BUT_NOT_COPYABLE
+#endif
+
+#include <algorithm> // swap
 
-#include <Windows.h> // GlobalLock/Unlock, HGLOBAL, GetLastError
+#include <Windows.h> // GlobalAlloc/Free, GlobalLock/Unlock, HGLOBAL,
+                     // GetLastError
 
 namespace washer {
 
+/**
+ * Sole owner of a block of global memory.
+ *
+ * The memory can be handed on with release(), for instance into an
+ * STGMEDIUM whose receiver frees it with ReleaseStgMedium.  Otherwise the
+ * memory is freed when the owner is destroyed.
+ *
+ * Owners can be moved but not copied.  Without Boost.Move (before Boost
+ * 1.48), copying an owner moves it instead, as with std::auto_ptr.
+ */
+class unique_hglobal
+{
+public:
+
+    unique_hglobal() : m_hglobal(NULL) {}
+
+    /**
+     * Take ownership of memory allocated with GlobalAlloc.
+     */
+    explicit unique_hglobal(HGLOBAL memory) : m_hglobal(memory) {}
+
+#if (BOOST_VERSION >= 104800)
+
+    unique_hglobal(BOOST_RV_REF(unique_hglobal) other) throw()
+        : m_hglobal(other.release()) {}
+
+    unique_hglobal& operator=(BOOST_RV_REF(unique_hglobal) other) throw()
+    {
+        unique_hglobal moved(boost::move(other));
+        swap(moved);
+        return *this;
+    }
+
+#else
+
+    unique_hglobal(const unique_hglobal& other) throw()
+        : m_hglobal(const_cast<unique_hglobal&>(other).release()) {}
+
+    unique_hglobal& operator=(const unique_hglobal& other) throw()
+    {
+        unique_hglobal moved(other);
+        swap(moved);
+        return *this;
+    }
+
+#endif
+
+    ~unique_hglobal() throw()
+    {
+        if (m_hglobal)
+            ::GlobalFree(m_hglobal);
+    }
+
+    HGLOBAL get() const
+    {
+        return m_hglobal;
+    }
+
+    /**
+     * Give up ownership of the memory without freeing it.
+     */
+    HGLOBAL release() throw()
+    {
+        HGLOBAL memory = m_hglobal;
+        m_hglobal = NULL;
+        return memory;
+    }
+
+    void swap(unique_hglobal& other) throw()
+    {
+        std::swap(m_hglobal, other.m_hglobal);
+    }
+
+private:
+#if (BOOST_VERSION >= 104800)
+    BOOST_MOVABLE_BUT_NOT_COPYABLE(unique_hglobal)
+#endif
+
+    HGLOBAL m_hglobal;
+};
+
+/**
+ * Allocate global memory with a single owner.
+ *
+ * @throws system_error if allocation fails.
+ */
+inline unique_hglobal unique_global_alloc(UINT flags, SIZE_T size)
+{
+    HGLOBAL memory = ::GlobalAlloc(flags, size);
+    if (memory == NULL)
+        BOOST_THROW_EXCEPTION(
+            boost::enable_error_info(last_error()) <<
+            boost::errinfo_api_function("GlobalAlloc"));
+
+    return unique_hglobal(memory);
+}
+
 /**
  * Resource-management (RAII) container handling locking on an HGLOBAL.
  *
@@ -143,8 +247,7 @@ private:
      *
      * This operation cannot fail and offers the strong guarantee.
      */
-    template<typename U>
-    inline friend void swap(global_lock<U>& lhs, global_lock<U>& rhs) throw()
+    inline friend void swap(global_lock& lhs, global_lock& rhs) throw()
     {
         std::swap(lhs.m_hglobal, rhs.m_hglobal);
         std::swap(lhs.m_mem, rhs.m_mem);
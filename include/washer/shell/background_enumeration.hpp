@@ -0,0 +1,555 @@
+/**
+    @file
+
+    Enumerating a folder's items on a worker thread.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_BACKGROUND_ENUMERATION_HPP
+#define WASHER_SHELL_BACKGROUND_ENUMERATION_HPP
+#pragma once
+
+#include <washer/com/global_interface_table.hpp> // global_interface
+#include <washer/dynamic_link.hpp> // load_function
+#include <washer/shell/enum_items.hpp> // enum_items
+#include <washer/shell/pidl.hpp> // cpidl_t, apidl_t
+#include <washer/shell/shell.hpp> // bind_to_handler_object
+
+#include <comet/error.h> // com_error
+#include <comet/ptr.h> // com_ptr
+
+#include <boost/bind.hpp> // bind
+#include <boost/detail/scoped_enum_emulation.hpp> // BOOST_SCOPED_ENUM
+#include <boost/exception/errinfo_api_function.hpp> // errinfo_api_function
+#include <boost/exception/info.hpp> // errinfo
+#include <boost/exception_ptr.hpp> // exception_ptr, current_exception,
+                                    // copy_exception
+#include <boost/function.hpp> // function
+#include <boost/make_shared.hpp> // make_shared
+#include <boost/noncopyable.hpp> // noncopyable
+#include <boost/scoped_ptr.hpp> // scoped_ptr
+#include <boost/shared_ptr.hpp> // shared_ptr
+#include <boost/thread/condition_variable.hpp> // condition_variable
+#include <boost/thread/locks.hpp> // unique_lock, lock_guard
+#include <boost/thread/mutex.hpp> // mutex
+#include <boost/thread/thread.hpp> // thread
+#include <boost/throw_exception.hpp> // BOOST_THROW_EXCEPTION
+
+#include <algorithm> // max
+#include <cassert> // assert
+#include <cstddef> // size_t
+#include <deque>
+#include <exception> // exception
+#include <vector>
+
+#include <objbase.h> // CoInitializeEx
+#include <ShObjIdl.h> // IShellFolder
+
+namespace washer {
+namespace shell {
+
+namespace detail {
+
+    /**
+     * Bounded queue of item batches passed from the enumerating thread to
+     * the consumer.
+     *
+     * The producer waits while the queue is full so a consumer that falls
+     * behind stops the enumeration rather than letting the queue grow without
+     * limit.  The consumer never has to wait: try_pop() only takes what is
+     * already there.
+     */
+    class prefetch_queue : private boost::noncopyable
+    {
+    public:
+        typedef std::vector<pidl::cpidl_t> batch;
+
+        prefetch_queue(
+            std::size_t max_batches, const boost::function<void()>& ready)
+            :
+        m_max_batches((std::max)(max_batches, std::size_t(1))),
+        m_ready(ready), m_cancelled(false), m_finished(false) {}
+
+        /**
+         * Hand a batch to the consumer, waiting while the queue is full.
+         *
+         * On success, @a items is left empty.
+         *
+         * @returns  false if the consumer cancelled, in which case the items
+         *           stay with the caller.
+         */
+        bool push(batch& items)
+        {
+            {
+                boost::unique_lock<boost::mutex> lock(m_mutex);
+
+                while (m_batches.size() >= m_max_batches && !m_cancelled)
+                    m_not_full.wait(lock);
+
+                if (m_cancelled)
+                    return false;
+
+                m_batches.push_back(batch());
+                m_batches.back().swap(items);
+            }
+
+            m_not_empty.notify_all();
+            notify_ready();
+            return true;
+        }
+
+        /**
+         * Mark the end of the batches, and why they ended if it was an
+         * error.
+         */
+        void finish(boost::exception_ptr error=boost::exception_ptr())
+        {
+            {
+                boost::lock_guard<boost::mutex> lock(m_mutex);
+                m_finished = true;
+                m_error = error;
+            }
+
+            m_not_empty.notify_all();
+            notify_ready();
+        }
+
+        /**
+         * Stop accepting batches, releasing a producer waiting for space.
+         */
+        void cancel()
+        {
+            {
+                boost::lock_guard<boost::mutex> lock(m_mutex);
+                m_cancelled = true;
+            }
+
+            m_not_full.notify_all();
+        }
+
+        bool cancelled() const
+        {
+            boost::lock_guard<boost::mutex> lock(m_mutex);
+            return m_cancelled;
+        }
+
+        bool finished() const
+        {
+            boost::lock_guard<boost::mutex> lock(m_mutex);
+            return m_finished && m_batches.empty();
+        }
+
+        bool try_pop(batch& items)
+        {
+            boost::unique_lock<boost::mutex> lock(m_mutex);
+            return pop_front(items, lock);
+        }
+
+        bool pop(batch& items)
+        {
+            boost::unique_lock<boost::mutex> lock(m_mutex);
+
+            while (m_batches.empty() && !m_finished)
+                m_not_empty.wait(lock);
+
+            return pop_front(items, lock);
+        }
+
+    private:
+
+        /**
+         * Take the oldest batch, or report the producer's error once all
+         * batches have been taken.
+         */
+        bool pop_front(batch& items, boost::unique_lock<boost::mutex>& lock)
+        {
+            if (!m_batches.empty())
+            {
+                items.swap(m_batches.front());
+                m_batches.pop_front();
+                lock.unlock();
+
+                m_not_full.notify_one();
+                return true;
+            }
+            else if (m_error)
+            {
+                boost::rethrow_exception(m_error);
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        void notify_ready()
+        {
+            if (m_ready)
+                m_ready();
+        }
+
+        const std::size_t m_max_batches;
+        const boost::function<void()> m_ready;
+
+        mutable boost::mutex m_mutex;
+        boost::condition_variable m_not_full;
+        boost::condition_variable m_not_empty;
+        std::deque<batch> m_batches;
+        bool m_cancelled;
+        bool m_finished;
+        boost::exception_ptr m_error;
+    };
+
+    /**
+     * Push a folder's items into the queue a batch at a time.
+     *
+     * Cancellation is checked before each item is taken from the enumerator
+     * so, whether the enumerator returns a whole batch per call to Next() or
+     * one item at a time, no further call is made once it is noticed.  A
+     * call already in progress can't be interrupted.
+     */
+    inline void prefetch_items(
+        prefetch_queue& queue, const comet::com_ptr<IShellFolder>& folder,
+        SHCONTF flags, std::size_t batch_size)
+    {
+        if (queue.cancelled())
+            return;
+
+        prefetch_queue::batch items;
+        items.reserve(batch_size);
+
+        boost::iterator_range<enum_item_iterator> range =
+            enum_items(folder, flags, NULL, batch_size);
+        for (enum_item_iterator it = range.begin(); it != range.end(); ++it)
+        {
+            items.push_back(pidl::cpidl_t());
+            items.back().swap(*it);
+
+            if (items.size() >= batch_size)
+            {
+                if (!queue.push(items))
+                    return;
+
+                items.reserve(batch_size);
+            }
+            else if (queue.cancelled())
+            {
+                return;
+            }
+        }
+
+        if (!items.empty())
+            queue.push(items);
+    }
+
+    /**
+     * Body of the enumerating thread.
+     *
+     * Every COM object the thread uses is released before the thread leaves
+     * its apartment.  Failures, including failing to join an apartment, are
+     * passed to the consumer through the queue.  A COM error may hold an
+     * IErrorInfo from this apartment, so only its HRESULT is passed on.
+     */
+    inline void enumerate_in_background(
+        boost::shared_ptr<prefetch_queue> queue,
+        boost::function<comet::com_ptr<IShellFolder>()> folder_source,
+        SHCONTF flags, std::size_t batch_size, DWORD apartment)
+    {
+        bool initialised = false;
+        try
+        {
+            HRESULT hr = ::CoInitializeEx(NULL, apartment);
+            if (FAILED(hr))
+                BOOST_THROW_EXCEPTION(
+                    boost::enable_error_info(comet::com_error(hr)) <<
+                    boost::errinfo_api_function("CoInitializeEx"));
+            initialised = true;
+
+            prefetch_items(*queue, folder_source(), flags, batch_size);
+            queue->finish();
+        }
+        catch (const comet::com_error& e)
+        {
+            queue->finish(boost::copy_exception(comet::com_error(e.hr())));
+        }
+        catch (...)
+        {
+            queue->finish(boost::current_exception());
+        }
+
+        if (initialised)
+            ::CoUninitialize();
+    }
+
+    /**
+     * Wait for a thread to end while servicing calls into the calling
+     * thread's apartment.
+     *
+     * CoWaitForMultipleHandles is only in Windows 2000 and later, so it is
+     * looked up in OLE32 at run time.  It fails if the calling thread hasn't
+     * initialised COM, but then there are no calls to service.  In either
+     * case, this returns without waiting and the caller must still join the
+     * thread.
+     */
+    inline void wait_servicing_calls(HANDLE thread)
+    {
+        typedef HRESULT STDAPICALLTYPE co_wait_for_multiple_handles(
+            DWORD, DWORD, ULONG, LPHANDLE, LPDWORD);
+
+        boost::function<HRESULT (DWORD, DWORD, ULONG, LPHANDLE, LPDWORD)>
+            wait;
+        try
+        {
+            wait = washer::load_function<co_wait_for_multiple_handles>(
+                "ole32.dll", "CoWaitForMultipleHandles");
+        }
+        catch (const std::exception&)
+        {
+            return;
+        }
+
+        DWORD index;
+        HRESULT hr = wait(0, INFINITE, 1, &thread, &index);
+        (void) hr;
+        assert(SUCCEEDED(hr) || hr == CO_E_NOTINITIALIZED);
+    }
+
+}
+
+/**
+ * A folder's items, enumerated on a worker thread and collected in batches.
+ *
+ * Enumerating a slow folder, such as one on a network share, blocks in
+ * IEnumIDList::Next.  This class moves that wait off the calling thread:
+ * a worker thread joins its own COM apartment, enumerates the folder and
+ * pushes the items, in batches, into a bounded queue.  The caller takes them
+ * out with try_pop(), which never waits, typically whenever the @c on_ready
+ * callback tells it there is something new.
+ *
+ * When the queue is full, the worker waits for the caller to make room
+ * before fetching any more items.  Cancelling stops the enumeration before
+ * the next call to Next(); a call that is already in progress runs to
+ * completion.
+ *
+ * The folder can be given in two ways:
+ *
+ *  - As a PIDL, in which case the worker binds to the folder itself so
+ *    the folder object lives in the worker's apartment and no calls cross
+ *    apartments.
+ *  - As an IShellFolder, which the worker gets through the Global Interface
+ *    Table.  If the folder is bound to the caller's apartment (most shell
+ *    folders created in an STA are), the worker's calls go through a proxy
+ *    and run in the caller's apartment, so the caller must keep pumping
+ *    messages and must not wait in pop().  Only the waiting moves off the
+ *    calling thread if the folder doesn't marshal by reference.
+ */
+class background_enumeration : private boost::noncopyable
+{
+public:
+
+    typedef detail::prefetch_queue::batch batch;
+
+    /**
+     * The kind of COM apartment the worker thread joins.
+     */
+    BOOST_SCOPED_ENUM_START(apartment)
+    {
+        single_threaded,
+        multithreaded
+    };
+    BOOST_SCOPED_ENUM_END;
+
+    /**
+     * Settings for the enumeration.
+     */
+    struct options
+    {
+        options()
+            :
+        batch_size(enum_item_iterator::default_batch_size),
+        max_queued_batches(4),
+        worker_apartment(apartment::single_threaded) {}
+
+        /**
+         * Maximum number of items to fetch per call to Next(), which is also
+         * the largest batch handed to the caller.
+         */
+        std::size_t batch_size;
+
+        /**
+         * Number of batches the worker may get ahead of the caller before it
+         * waits.
+         */
+        std::size_t max_queued_batches;
+
+        BOOST_SCOPED_ENUM(apartment) worker_apartment;
+
+        /**
+         * Called on the worker thread when a batch is queued and when the
+         * enumeration ends.
+         *
+         * Typically posts a message to the consuming window.  It must not
+         * throw and must not wait for the consumer.
+         */
+        boost::function<void()> on_ready;
+    };
+
+    /**
+     * Start enumerating the folder at the given PIDL.
+     *
+     * The worker binds to the folder in its own apartment.
+     */
+    background_enumeration(
+        const pidl::apidl_t& folder, SHCONTF flags,
+        const options& settings=options())
+        :
+    m_queue(new_queue(settings)),
+    m_thread(
+        boost::bind(
+            &detail::enumerate_in_background, m_queue,
+            boost::function<comet::com_ptr<IShellFolder>()>(
+                boost::bind(&bind_to_handler_object<IShellFolder>, folder)),
+            flags, batch_size(settings), coinit_flags(settings))) {}
+
+    /**
+     * Start enumerating a folder belonging to the calling apartment.
+     *
+     * The folder is marshalled to the worker through the Global Interface
+     * Table.
+     */
+    background_enumeration(
+        const comet::com_ptr<IShellFolder>& folder, SHCONTF flags,
+        const options& settings=options())
+        :
+    m_queue(new_queue(settings)),
+    m_folder(new com::global_interface<IShellFolder>(folder)),
+    m_thread(
+        boost::bind(
+            &detail::enumerate_in_background, m_queue,
+            boost::function<comet::com_ptr<IShellFolder>()>(
+                boost::bind(
+                    &com::interface_from_global<IShellFolder>,
+                    m_folder->cookie())),
+            flags, batch_size(settings), coinit_flags(settings))) {}
+
+    /**
+     * Cancel the enumeration and wait for the worker to stop.
+     *
+     * On Windows 2000 and later, calls into this apartment are serviced
+     * while waiting so a worker in the middle of a call through the
+     * folder's proxy can finish.  Before that, a folder passed as an
+     * IShellFolder must be left to finish enumerating first.
+     */
+    ~background_enumeration() throw()
+    {
+        m_queue->cancel();
+
+        detail::wait_servicing_calls(m_thread.native_handle());
+        m_thread.join();
+    }
+
+    /**
+     * Take the next batch of items if one is ready, without waiting.
+     *
+     * @param[out] items  Replaced by the batch.  Untouched if none is ready.
+     *
+     * @returns  Whether there was a batch.
+     *
+     * @throws  The error that ended the enumeration, once every batch
+     *          queued before it has been taken.
+     */
+    bool try_pop(batch& items)
+    {
+        return m_queue->try_pop(items);
+    }
+
+    /**
+     * Take the next batch of items, waiting for one if necessary.
+     *
+     * Must not be used in the apartment of a folder passed as an
+     * IShellFolder as the worker may need that apartment to make progress.
+     *
+     * @returns  false if the enumeration has ended and every batch has
+     *           been taken.
+     *
+     * @throws  The error that ended the enumeration, once every batch
+     *          queued before it has been taken.
+     */
+    bool pop(batch& items)
+    {
+        return m_queue->pop(items);
+    }
+
+    /**
+     * Has every item been enumerated and taken?
+     *
+     * Once true, try_pop() will not return any more items.  It will throw
+     * if the enumeration failed.
+     */
+    bool finished() const
+    {
+        return m_queue->finished();
+    }
+
+    /**
+     * Stop the enumeration before the next call to Next().
+     *
+     * Batches already queued can still be taken.
+     */
+    void cancel()
+    {
+        m_queue->cancel();
+    }
+
+private:
+
+    static boost::shared_ptr<detail::prefetch_queue> new_queue(
+        const options& settings)
+    {
+        return boost::make_shared<detail::prefetch_queue>(
+            settings.max_queued_batches, settings.on_ready);
+    }
+
+    static std::size_t batch_size(const options& settings)
+    {
+        return (std::max)(settings.batch_size, std::size_t(1));
+    }
+
+    static DWORD coinit_flags(const options& settings)
+    {
+        return (settings.worker_apartment == apartment::multithreaded) ?
+            COINIT_MULTITHREADED : COINIT_APARTMENTTHREADED;
+    }
+
+    boost::shared_ptr<detail::prefetch_queue> m_queue;
+    boost::scoped_ptr< com::global_interface<IShellFolder> > m_folder;
+    boost::thread m_thread;
+};
+
+}} // namespace washer::shell
+
+#endif
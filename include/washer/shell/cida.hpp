@@ -0,0 +1,424 @@
+/**
+    @file
+
+    Zero-copy access to shell ID list arrays (CFSTR_SHELLIDLIST).
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_CIDA_HPP
+#define WASHER_SHELL_CIDA_HPP
+#pragma once
+
+#include <washer/error.hpp> // last_error
+#include <washer/global_lock.hpp> // global_lock, unique_global_alloc,
+                                   // unique_hglobal
+#include <washer/shell/pidl.hpp> // apidl_t, basic_pidl_view, raw_pidl
+#include <washer/shell/pidl_array.hpp> // pidl_array, packed_item
+
+#include <boost/exception/errinfo_api_function.hpp> // errinfo_api_function
+#include <boost/exception/info.hpp> // errinfo
+#include <boost/iterator/iterator_facade.hpp> // iterator_facade
+#include <boost/throw_exception.hpp> // BOOST_THROW_EXCEPTION
+#include <boost/version.hpp>
+#if (BOOST_VERSION >= 104800)
+#include <boost/move/move.hpp> // move
+#endif
+
+#include <cassert> // assert
+#include <climits> // UINT_MAX
+#include <cstddef> // size_t, ptrdiff_t
+#include <cstring> // memcpy
+#include <iterator> // distance
+#include <stdexcept> // invalid_argument, length_error, out_of_range,
+                     // runtime_error
+
+#include <ShlObj.h> // CIDA
+#include <Windows.h> // HGLOBAL, GlobalSize, GMEM_MOVEABLE
+
+namespace washer {
+namespace shell {
+namespace pidl {
+
+namespace detail {
+
+    inline void throw_corrupt_cida()
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Corrupt CIDA"));
+    }
+}
+
+/**
+ * Read access to the PIDLs in a CIDA held in an HGLOBAL.
+ *
+ * A CIDA is the format of CFSTR_SHELLIDLIST, the shell's data object format
+ * for a selection of items: an absolute PIDL of the folder holding the items
+ * followed by the items' PIDLs relative to that folder.
+ *
+ * The view keeps the HGLOBAL locked for its lifetime and hands out views of
+ * (or raw pointers to) the PIDLs in place.  Nothing is copied unless asked
+ * for by absolute() or by converting a view to a basic_pidl.
+ *
+ * As the data may come from another process, the constructor checks that
+ * the offset table and every PIDL it points to lie within the HGLOBAL.  This
+ * walks only the item headers, and means that no PIDL handed out can lead
+ * to reading beyond the end of the block.
+ */
+class cida_view
+{
+public:
+
+    typedef basic_pidl_view<ITEMIDLIST_RELATIVE> value_type;
+
+    class const_iterator : public boost::iterator_facade<
+        const_iterator, value_type, boost::random_access_traversal_tag,
+        value_type>
+    {
+    public:
+
+        const_iterator() : m_cida(NULL), m_position(0) {}
+
+    private:
+        friend class boost::iterator_core_access;
+        friend class cida_view;
+
+        const_iterator(const cida_view* cida, std::size_t position)
+            : m_cida(cida), m_position(position) {}
+
+        value_type dereference() const
+        {
+            return (*m_cida)[m_position];
+        }
+
+        bool equal(const const_iterator& other) const
+        {
+            return m_cida == other.m_cida && m_position == other.m_position;
+        }
+
+        void increment() { ++m_position; }
+        void decrement() { --m_position; }
+        void advance(std::ptrdiff_t n) { m_position += n; }
+
+        std::ptrdiff_t distance_to(const const_iterator& other) const
+        {
+            return static_cast<std::ptrdiff_t>(other.m_position) -
+                static_cast<std::ptrdiff_t>(m_position);
+        }
+
+        const cida_view* m_cida;
+        std::size_t m_position;
+    };
+
+    /**
+     * Lock and check the CIDA in an HGLOBAL.
+     *
+     * @throws system_error if the HGLOBAL can't be locked or measured.
+     * @throws std::runtime_error if the HGLOBAL doesn't hold a valid CIDA.
+     */
+    explicit cida_view(HGLOBAL hglobal)
+        : m_lock(hglobal), m_size(::GlobalSize(hglobal))
+    {
+        if (m_size == 0)
+            BOOST_THROW_EXCEPTION(
+                boost::enable_error_info(last_error()) <<
+                boost::errinfo_api_function("GlobalSize"));
+
+        validate();
+    }
+
+    /**
+     * Check the CIDA held by an existing lock.
+     *
+     * @param lock  Lock on the HGLOBAL holding the CIDA.  It is copied, which
+     *              only increments the HGLOBAL's lock count.
+     * @param size  Number of bytes readable from the start of the CIDA,
+     *              usually the result of GlobalSize.
+     *
+     * @throws std::runtime_error if the memory doesn't hold a valid CIDA.
+     */
+    cida_view(const global_lock<CIDA>& lock, std::size_t size)
+        : m_lock(lock), m_size(size)
+    {
+        validate();
+    }
+
+    /**
+     * Number of items in the CIDA, not counting the parent folder.
+     */
+    std::size_t size() const
+    {
+        return m_lock.get()->cidl;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /**
+     * Null-terminated raw PIDL of the folder holding the items.
+     */
+    PCIDLIST_ABSOLUTE parent_pidl() const
+    {
+        return pidl_at<ITEMIDLIST_ABSOLUTE>(0);
+    }
+
+    /**
+     * View of the folder holding the items.
+     */
+    basic_pidl_view<ITEMIDLIST_ABSOLUTE> parent() const
+    {
+        return basic_pidl_view<ITEMIDLIST_ABSOLUTE>(parent_pidl());
+    }
+
+    /**
+     * Null-terminated raw PIDL of the item at the given position, relative
+     * to the parent folder.
+     */
+    PCUIDLIST_RELATIVE get(std::size_t i) const
+    {
+        assert(i < size());
+        return pidl_at<ITEMIDLIST_RELATIVE>(i + 1);
+    }
+
+    /**
+     * View of the item at the given position, relative to the parent folder.
+     */
+    value_type operator[](std::size_t i) const
+    {
+        return value_type(get(i));
+    }
+
+    /**
+     * View of the item at the given position with bounds checking.
+     */
+    value_type at(std::size_t i) const
+    {
+        if (i >= size())
+            BOOST_THROW_EXCEPTION(
+                std::out_of_range("Position is past the end of the CIDA"));
+
+        return (*this)[i];
+    }
+
+    /**
+     * Copy of the absolute PIDL of the item at the given position.
+     *
+     * The parent and item are joined with a single allocation.
+     */
+    apidl_t absolute(std::size_t i) const
+    {
+        apidl_t pidl;
+        pidl.attach(
+            raw_pidl::combine<cotaskmem_alloc<ITEMIDLIST_ABSOLUTE> >(
+                parent_pidl(), get(i)));
+        return pidl;
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(this, size());
+    }
+
+private:
+
+    const BYTE* data() const
+    {
+        return reinterpret_cast<const BYTE*>(m_lock.get());
+    }
+
+    template<typename T>
+    const T __unaligned* pidl_at(std::size_t entry) const
+    {
+        return reinterpret_cast<const T __unaligned*>(
+            data() + m_lock.get()->aoffset[entry]);
+    }
+
+    /**
+     * Make sure the offset table and each PIDL it points to lie within the
+     * block.
+     */
+    void validate() const
+    {
+        if (m_size < sizeof(UINT))
+            detail::throw_corrupt_cida();
+
+        // The table has an entry for the parent folder as well as each item.
+        // Compare counts of UINTs rather than bytes so nothing can overflow.
+        std::size_t table_capacity = m_size / sizeof(UINT) - 1;
+        std::size_t count = m_lock.get()->cidl;
+        if (count >= table_capacity)
+            detail::throw_corrupt_cida();
+
+        for (std::size_t entry = 0; entry <= count; ++entry)
+        {
+            std::size_t offset = m_lock.get()->aoffset[entry];
+            if (offset >= m_size)
+                detail::throw_corrupt_cida();
+
+            try
+            {
+                raw_pidl::validate(
+                    pidl_at<ITEMIDLIST_RELATIVE>(entry), m_size - offset);
+            }
+            catch (const std::invalid_argument&)
+            {
+                detail::throw_corrupt_cida();
+            }
+        }
+    }
+
+    global_lock<CIDA> m_lock;
+    std::size_t m_size;
+};
+
+namespace detail {
+
+    inline std::size_t add_cida_bytes(std::size_t total, std::size_t bytes)
+    {
+        if (bytes > UINT_MAX - total)
+            BOOST_THROW_EXCEPTION(
+                std::length_error("Too many PIDLs for a CIDA"));
+
+        return total + bytes;
+    }
+
+    template<typename T>
+    std::size_t cida_pidl_bytes(
+        std::size_t total, const basic_pidl_view<T>& pidl)
+    {
+        return add_cida_bytes(
+            add_cida_bytes(total, pidl.item_bytes()), sizeof(USHORT));
+    }
+
+    /**
+     * Copy a PIDL to the given offset and record the offset in the table.
+     *
+     * @returns  Offset of the next PIDL.
+     */
+    template<typename T>
+    std::size_t write_cida_pidl(
+        CIDA* cida, std::size_t entry, std::size_t offset,
+        const basic_pidl_view<T>& pidl)
+    {
+        cida->aoffset[entry] = static_cast<UINT>(offset);
+
+        BYTE* destination = reinterpret_cast<BYTE*>(cida) + offset;
+        std::memcpy(destination, pidl.data(), pidl.item_bytes());
+
+        USHORT terminator = 0;
+        std::memcpy(
+            destination + pidl.item_bytes(), &terminator, sizeof(terminator));
+
+        return offset + pidl.item_bytes() + sizeof(terminator);
+    }
+}
+
+/**
+ * Create a CIDA (CFSTR_SHELLIDLIST) holding a folder and items in it.
+ *
+ * The CIDA is measured first so that it is written into a single allocation
+ * of exactly the right size.  The range of items is therefore traversed
+ * twice and must be made of forward iterators.  The items can be raw PIDLs,
+ * views or any wrapper with a get() method such as basic_pidl.
+ *
+ * @param parent  The folder holding the items.
+ * @param begin   Start of the items, relative to @a parent.
+ * @param end     End of the items.
+ *
+ * @returns  Moveable global memory holding the CIDA, which can be read with
+ *           cida_view.  To place it in an STGMEDIUM, release() it into the
+ *           medium's hGlobal so that only the medium frees it.
+ *
+ * @throws std::length_error if the CIDA would be too large for its 32-bit
+ *         offsets.
+ * @throws system_error if the memory can't be allocated.
+ */
+template<typename It>
+inline unique_hglobal make_cida(
+    const basic_pidl_view<ITEMIDLIST_ABSOLUTE>& parent, It begin, It end)
+{
+    std::size_t count = std::distance(begin, end);
+    if (count >= UINT_MAX / sizeof(UINT) - 1)
+        BOOST_THROW_EXCEPTION(std::length_error("Too many PIDLs for a CIDA"));
+
+    // Offset table has an entry for the parent as well as for each item
+    std::size_t table_bytes = sizeof(UINT) * (count + 2);
+
+    std::size_t bytes = detail::cida_pidl_bytes(table_bytes, parent);
+    for (It it = begin; it != end; ++it)
+    {
+        bytes = detail::cida_pidl_bytes(
+            bytes, detail::packed_item<ITEMIDLIST_RELATIVE>(*it));
+    }
+
+    unique_hglobal memory = unique_global_alloc(GMEM_MOVEABLE, bytes);
+    {
+        global_lock<CIDA> lock(memory.get());
+        CIDA* cida = lock.get();
+
+        cida->cidl = static_cast<UINT>(count);
+
+        std::size_t offset =
+            detail::write_cida_pidl(cida, 0, table_bytes, parent);
+        std::size_t entry = 1;
+        for (It it = begin; it != end; ++it, ++entry)
+        {
+            offset = detail::write_cida_pidl(
+                cida, entry, offset,
+                detail::packed_item<ITEMIDLIST_RELATIVE>(*it));
+        }
+
+        assert(offset == bytes);
+    }
+
+#if (BOOST_VERSION >= 104800)
+    return boost::move(memory);
+#else
+    return memory;
+#endif
+}
+
+/**
+ * Create a CIDA holding a folder and the items in a pidl_array.
+ */
+template<typename T>
+inline unique_hglobal make_cida(
+    const basic_pidl_view<ITEMIDLIST_ABSOLUTE>& parent,
+    const pidl_array<T>& items)
+{
+    return make_cida(
+        parent, items.as_array(), items.as_array() + items.size());
+}
+
+}}} // namespace washer::shell::pidl
+
+#endif
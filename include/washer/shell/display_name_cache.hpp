@@ -0,0 +1,67 @@
+/**
+    @file
+
+    Cache of shell item display names.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_DISPLAY_NAME_CACHE_HPP
+#define WASHER_SHELL_DISPLAY_NAME_CACHE_HPP
+#pragma once
+
+#include <washer/shell/pidl_lru_cache.hpp> // pidl_lru_cache
+
+#include <string>
+
+#include <ShObjIdl.h> // SHGDNF
+
+namespace washer {
+namespace shell {
+
+typedef pidl_lru_cache_statistics display_name_cache_statistics;
+
+/**
+ * Remembers the display names of items, keyed on the item's absolute PIDL
+ * and the SHGDNF flags the name was fetched with.
+ *
+ * Fetching a display name from the shell binds to the item's parent folder
+ * and asks the folder for the name, often touching the disk or network.
+ * Looking it up here instead costs hashing the PIDL.
+ *
+ * The cache holds at most @c capacity names and, when full, forgets the
+ * least recently used name to make room for a new one.  Names do not
+ * expire; call invalidate() when an item is renamed or invalidate_subtree()
+ * when a folder is renamed, moved or deleted, for example in response to
+ * SHChangeNotify events.
+ *
+ * The cache is not thread-safe.
+ */
+typedef pidl_lru_cache<SHGDNF, std::wstring> display_name_cache;
+
+}} // namespace washer::shell
+
+#endif
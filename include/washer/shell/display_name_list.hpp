@@ -0,0 +1,294 @@
+/**
+    @file
+
+    Display names of many items in one folder.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_DISPLAY_NAME_LIST_HPP
+#define WASHER_SHELL_DISPLAY_NAME_LIST_HPP
+#pragma once
+
+#include <washer/shell/pidl.hpp> // apidl_t, basic_pidl_view
+#include <washer/shell/pidl_array.hpp> // packed_item
+#include <washer/shell/shell.hpp> // bind_to_handler_object
+#include <washer/shell/shell_context.hpp> // shell_context
+
+#include <comet/error.h> // com_error, com_error_from_interface
+#include <comet/ptr.h> // com_ptr
+
+#include <boost/exception/errinfo_api_function.hpp> // errinfo_api_function
+#include <boost/exception/info.hpp> // errinfo
+#include <boost/throw_exception.hpp> // BOOST_THROW_EXCEPTION
+
+#include <algorithm> // max
+#include <cassert> // assert
+#include <cstddef> // size_t
+#include <cstring> // memcpy, memset
+#include <cwchar> // wcslen
+#include <iterator> // distance, iterator_traits
+#include <string>
+#include <vector>
+
+#include <ShObjIdl.h> // IShellFolder, SHGDNF
+#include <Shlwapi.h> // StrRetToBuf
+
+namespace washer {
+namespace shell {
+
+namespace detail {
+
+    /**
+     * Make room for an offset per item, plus the end, when the items can be
+     * counted without consuming them.
+     */
+    template<typename It>
+    inline void reserve_offsets(
+        std::vector<std::size_t>& offsets, It begin, It end,
+        std::forward_iterator_tag)
+    {
+        offsets.reserve(std::distance(begin, end) + 1);
+    }
+
+    /**
+     * Items that can only be read once, such as an enumeration, grow the
+     * offsets as they go.
+     */
+    template<typename It>
+    inline void reserve_offsets(
+        std::vector<std::size_t>&, It, It, std::input_iterator_tag)
+    {}
+
+    /**
+     * Raw, null-terminated version of a child item.
+     *
+     * Views that aren't terminated are copied into @a scratch, which is
+     * reused from item to item.
+     */
+    inline PCUITEMID_CHILD terminated_child(
+        const pidl::basic_pidl_view<ITEMID_CHILD>& item,
+        std::vector<BYTE>& scratch)
+    {
+        if (item.is_terminated())
+            return item.get();
+
+        scratch.resize(item.size());
+        std::memcpy(&scratch[0], item.data(), item.item_bytes());
+        std::memset(&scratch[item.item_bytes()], 0, sizeof(USHORT));
+
+        return reinterpret_cast<PCUITEMID_CHILD>(&scratch[0]);
+    }
+
+    /**
+     * Append the string held by a STRRET, and a null-terminator, to
+     * @a names.
+     *
+     * Wide strings are copied straight out of the STRRET and freed.  The
+     * others are converted by StrRetToBuf into @a scratch, which is reused
+     * from item to item, so no conversion needs its own allocation.
+     */
+    inline void append_strret(
+        STRRET& strret, PCUITEMID_CHILD item, std::vector<wchar_t>& names,
+        std::vector<wchar_t>& scratch)
+    {
+        if (strret.uType == STRRET_WSTR)
+        {
+            const wchar_t* name = strret.pOleStr;
+            try
+            {
+                if (name)
+                    names.insert(names.end(), name, name + std::wcslen(name));
+                names.push_back(wchar_t());
+            }
+            catch (...)
+            {
+                ::CoTaskMemFree(strret.pOleStr);
+                throw;
+            }
+
+            ::CoTaskMemFree(strret.pOleStr);
+            return;
+        }
+
+        // A cStr holds at most MAX_PATH characters and a string at an offset
+        // lies within the item so has no more characters than the item has
+        // bytes
+        std::size_t capacity = (std::max)(
+            static_cast<std::size_t>(MAX_PATH),
+            static_cast<std::size_t>(item->mkid.cb));
+        if (scratch.size() < capacity)
+            scratch.resize(capacity);
+
+        HRESULT hr = ::StrRetToBufW(
+            &strret, item, &scratch[0], static_cast<UINT>(scratch.size()));
+        if (FAILED(hr))
+            BOOST_THROW_EXCEPTION(
+                boost::enable_error_info(
+                    comet::com_error(
+                        "Failed to convert STRRET to string", hr,
+                        "StrRetToBuf")) <<
+                boost::errinfo_api_function("StrRetToBuf"));
+
+        scratch[scratch.size() - 1] = wchar_t(); // null-terminate
+        const wchar_t* name = &scratch[0];
+        names.insert(names.end(), name, name + std::wcslen(name) + 1);
+    }
+}
+
+/**
+ * Display names of many items in the same folder.
+ *
+ * Rather than a string per item, the names are stored one after another,
+ * each null-terminated, in a single buffer with a table of where each name
+ * starts.
+ */
+class display_name_list
+{
+public:
+
+    /**
+     * Fetch the names of items in a folder.
+     *
+     * The items can be raw child PIDLs, views or any wrapper with a get()
+     * method such as cpidl_t.  They need only be readable once, so an
+     * enum_items range can be passed straight in.
+     *
+     * @param folder  The folder holding the items.
+     * @param begin   Start of the items.
+     * @param end     End of the items.
+     * @param flags   Type of name to fetch, as for GetDisplayNameOf.
+     */
+    template<typename It>
+    display_name_list(
+        const comet::com_ptr<IShellFolder>& folder, It begin, It end,
+        SHGDNF flags)
+    {
+        detail::reserve_offsets(
+            m_offsets, begin, end,
+            typename std::iterator_traits<It>::iterator_category());
+        m_offsets.push_back(0);
+
+        std::vector<BYTE> item_scratch;
+        std::vector<wchar_t> name_scratch;
+        for (It it = begin; it != end; ++it)
+        {
+            PCUITEMID_CHILD item = detail::terminated_child(
+                pidl::detail::packed_item<ITEMID_CHILD>(*it), item_scratch);
+
+            STRRET strret;
+            HRESULT hr = folder->GetDisplayNameOf(item, flags, &strret);
+            if (FAILED(hr))
+                BOOST_THROW_EXCEPTION(
+                    comet::com_error_from_interface(folder, hr));
+
+            detail::append_strret(strret, item, m_names, name_scratch);
+            m_offsets.push_back(m_names.size());
+        }
+    }
+
+    /**
+     * Number of names.
+     */
+    std::size_t size() const
+    {
+        return m_offsets.size() - 1;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /**
+     * The name of the item at @a index as a null-terminated string.
+     *
+     * The pointer remains valid for the lifetime of the list.
+     */
+    const wchar_t* c_str(std::size_t index) const
+    {
+        assert(index < size() || !"Index out of range");
+        return &m_names[0] + m_offsets[index];
+    }
+
+    /**
+     * Length of the name of the item at @a index, excluding its
+     * null-terminator.
+     */
+    std::size_t length(std::size_t index) const
+    {
+        assert(index < size() || !"Index out of range");
+        return m_offsets[index + 1] - m_offsets[index] - 1;
+    }
+
+    /**
+     * Copy of the name of the item at @a index.
+     */
+    std::wstring operator[](std::size_t index) const
+    {
+        return std::wstring(c_str(index), length(index));
+    }
+
+private:
+    std::vector<wchar_t> m_names;
+    std::vector<std::size_t> m_offsets; ///< Start of each name, then the end
+};
+
+/**
+ * Fetch the display names of many items in the same folder.
+ *
+ * The folder is bound once for all the items, rather than once per item as
+ * pidl_shell_item does, and is taken from the context's folder cache if it
+ * has one.
+ *
+ * @param parent  The folder holding the items.
+ * @param begin   Start of the items: raw child PIDLs, views or wrappers such
+ *                as cpidl_t.
+ * @param end     End of the items.
+ * @param flags   Type of name to fetch, as for GetDisplayNameOf.
+ */
+template<typename It>
+inline display_name_list display_names(
+    const pidl::apidl_t& parent, It begin, It end, SHGDNF flags,
+    const shell_context& context=shell_context())
+{
+    comet::com_ptr<IShellFolder> folder;
+    if (context.folders)
+        folder = context.folders->find(parent);
+
+    if (!folder)
+    {
+        folder = bind_to_handler_object<IShellFolder>(parent);
+        if (context.folders)
+            context.folders->insert(parent.get(), folder);
+    }
+
+    return display_name_list(folder, begin, end, flags);
+}
+
+}} // namespace washer::shell
+
+#endif
@@ -0,0 +1,222 @@
+/**
+    @file
+
+    IEnumIDList implementation over a shared list of PIDLs.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_ENUM_ID_LIST_HPP
+#define WASHER_SHELL_ENUM_ID_LIST_HPP
+#pragma once
+
+#include <washer/com/catch.hpp> // WASHER_COM_CATCH_AUTO_INTERFACE
+#include <washer/shell/enum_items.hpp> // comtype<IEnumIDList>
+#include <washer/shell/pidl.hpp> // raw_pidl
+#include <washer/shell/pidl_array.hpp> // packed_pidl_array
+
+#include <comet/error.h> // com_error
+#include <comet/ptr.h> // com_ptr
+#include <comet/server.h> // simple_object
+
+#include <boost/make_shared.hpp> // make_shared
+#include <boost/shared_ptr.hpp> // shared_ptr
+#include <boost/throw_exception.hpp> // BOOST_THROW_EXCEPTION
+
+#include <algorithm> // min
+#include <cassert> // assert
+#include <cstddef> // size_t
+#include <cstring> // memcpy
+
+#include <ShObjIdl.h> // IEnumIDList
+
+namespace washer {
+namespace shell {
+
+/**
+ * IEnumIDList over a list of child PIDLs that doesn't change.
+ *
+ * Folders can use this rather than writing their own enumerator.  The items
+ * are held in a single packed_pidl_array which is shared, not copied, by
+ * every enumerator over it, including clones.  Each enumerator only adds
+ * its own position in the list, so:
+ *
+ * - Next() hands out as many items as are asked for in one call, copying
+ *   each with a single CoTaskMemAlloc and memcpy.
+ * - Skip() and Reset() just move the position.
+ * - Clone() creates an enumerator at the same position over the same list.
+ *
+ * As the list never changes, enumerators over it can be used by different
+ * threads, but each enumerator must only be used by one thread at a time.
+ */
+class enum_id_list : public comet::simple_object<IEnumIDList>
+{
+public:
+
+    typedef IEnumIDList interface_is;
+    typedef boost::shared_ptr<const pidl::packed_pidl_array> snapshot;
+
+    /**
+     * Enumerator over @a items, starting at @a position.
+     */
+    explicit enum_id_list(snapshot items, std::size_t position=0)
+        : m_items(items), m_position(position)
+    {
+        assert(m_items || !"Enumerator needs a list, even if empty");
+        assert(m_position <= m_items->size() || !"Position past end");
+    }
+
+    virtual IFACEMETHODIMP Next(
+        ULONG celt, PITEMID_CHILD* rgelt, ULONG* pceltFetched)
+    {
+        try
+        {
+            if (pceltFetched)
+                *pceltFetched = 0;
+
+            if (!rgelt)
+                BOOST_THROW_EXCEPTION(comet::com_error(E_POINTER));
+            if (celt > 1 && !pceltFetched)
+                BOOST_THROW_EXCEPTION(comet::com_error(E_INVALIDARG));
+
+            std::size_t count = (std::min)(
+                static_cast<std::size_t>(celt),
+                m_items->size() - m_position);
+
+            copy_items(count, rgelt);
+            m_position += count;
+
+            if (pceltFetched)
+                *pceltFetched = static_cast<ULONG>(count);
+
+            return (count == celt) ? S_OK : S_FALSE;
+        }
+        WASHER_COM_CATCH_AUTO_INTERFACE();
+    }
+
+    virtual IFACEMETHODIMP Skip(ULONG celt)
+    {
+        std::size_t remaining = m_items->size() - m_position;
+        if (celt > remaining)
+        {
+            m_position = m_items->size();
+            return S_FALSE;
+        }
+
+        m_position += celt;
+        return S_OK;
+    }
+
+    virtual IFACEMETHODIMP Reset()
+    {
+        m_position = 0;
+        return S_OK;
+    }
+
+    virtual IFACEMETHODIMP Clone(IEnumIDList** ppenum)
+    {
+        try
+        {
+            if (!ppenum)
+                BOOST_THROW_EXCEPTION(comet::com_error(E_POINTER));
+            *ppenum = NULL;
+
+            comet::com_ptr<IEnumIDList> clone(
+                new enum_id_list(m_items, m_position));
+            *ppenum = clone.detach();
+        }
+        WASHER_COM_CATCH_AUTO_INTERFACE();
+
+        return S_OK;
+    }
+
+private:
+
+    /**
+     * Copy the next @a count items into the caller's array.
+     *
+     * Either every item is copied or, if memory runs out, none are.
+     */
+    void copy_items(std::size_t count, PITEMID_CHILD* destination)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            PCUITEMID_CHILD item = (*m_items)[m_position + i];
+            std::size_t size = pidl::raw_pidl::size(item);
+
+            void* copy = ::CoTaskMemAlloc(size);
+            if (!copy)
+            {
+                for (std::size_t j = 0; j < i; ++j)
+                {
+                    ::CoTaskMemFree(destination[j]);
+                    destination[j] = NULL;
+                }
+
+                BOOST_THROW_EXCEPTION(comet::com_error(E_OUTOFMEMORY));
+            }
+
+            std::memcpy(copy, item, size);
+            destination[i] = static_cast<PITEMID_CHILD>(copy);
+        }
+    }
+
+    snapshot m_items;
+    std::size_t m_position; ///< Index of the next item to hand out
+};
+
+/**
+ * Enumerator over a list of child PIDLs.
+ *
+ * The list is shared, not copied, so a folder can keep it and hand out
+ * many enumerators over it.
+ *
+ * To return the enumerator from folder_base_interface::enum_objects, detach
+ * it from the com_ptr.
+ */
+inline comet::com_ptr<IEnumIDList> make_enum_id_list(
+    const enum_id_list::snapshot& items)
+{
+    return comet::com_ptr<IEnumIDList>(new enum_id_list(items));
+}
+
+/**
+ * Enumerator over a copy of a range of child PIDLs.
+ *
+ * The items are packed into a single block of memory that the enumerator
+ * and its clones share.  They can be raw PIDLs, views or any wrapper with a
+ * get() method such as cpidl_t.
+ */
+template<typename It>
+inline comet::com_ptr<IEnumIDList> make_enum_id_list(It begin, It end)
+{
+    return make_enum_id_list(
+        boost::make_shared<pidl::packed_pidl_array>(begin, end));
+}
+
+}} // namespace washer::shell
+
+#endif
@@ -0,0 +1,311 @@
+/**
+    @file
+
+    Iteration over the items of an IEnumIDList in batches.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_ENUM_ITEMS_HPP
+#define WASHER_SHELL_ENUM_ITEMS_HPP
+#pragma once
+
+#include <washer/shell/folder_error_adapters.hpp> // comtype<IShellFolder>
+#include <washer/shell/pidl.hpp> // cpidl_t
+
+#include <comet/error.h> // com_error_from_interface
+#include <comet/ptr.h> // com_ptr
+
+#include <boost/iterator/iterator_facade.hpp> // iterator_facade
+#include <boost/noncopyable.hpp> // noncopyable
+#include <boost/range/iterator_range.hpp> // iterator_range
+#include <boost/shared_ptr.hpp> // shared_ptr
+#include <boost/throw_exception.hpp> // BOOST_THROW_EXCEPTION
+
+#include <algorithm> // fill, min
+#include <cassert> // assert
+#include <cstddef> // size_t
+#include <stdexcept> // logic_error, range_error
+#include <vector>
+
+#include <ShObjIdl.h> // IEnumIDList, IShellFolder
+
+/**
+ * Comet IID lookup for IEnumIDList.
+ */
+template<> struct comet::comtype<IEnumIDList>
+{
+    static const IID& uuid() throw() { return IID_IEnumIDList; }
+    typedef IUnknown base;
+};
+
+namespace washer {
+namespace shell {
+
+namespace detail {
+
+    /**
+     * Items fetched from an IEnumIDList a batch at a time.
+     *
+     * The PIDLs in the current batch belong to this object until they are
+     * handed out, one at a time, as the current item.  Any still in the
+     * batch when it is destroyed are freed; items the enumerator hasn't yet
+     * returned are the enumerator's to free.
+     */
+    class enum_item_batch : private boost::noncopyable
+    {
+    public:
+
+        enum_item_batch(
+            const comet::com_ptr<IEnumIDList>& items, std::size_t batch_size)
+            :
+        m_items(items), m_batch((batch_size) ? batch_size : 1),
+        m_fetched(0), m_next(0), m_exhausted(false) {}
+
+        ~enum_item_batch() throw()
+        {
+            for (std::size_t i = m_next; i < m_fetched; ++i)
+            {
+                adopt(m_batch[i]);
+            }
+        }
+
+        pidl::cpidl_t& current()
+        {
+            return m_current;
+        }
+
+        /**
+         * Make the next item current.
+         *
+         * @returns  false if there are no more items.
+         */
+        bool advance()
+        {
+            if (m_next == m_fetched && !fetch())
+            {
+                pidl::cpidl_t().swap(m_current);
+                return false;
+            }
+
+            pidl::cpidl_t item = adopt(m_batch[m_next++]);
+            m_current.swap(item);
+            return true;
+        }
+
+    private:
+
+        /**
+         * Take ownership of a PIDL returned by the enumerator.
+         */
+        static pidl::cpidl_t adopt(PITEMID_CHILD raw_item)
+        {
+            pidl::cpidl_t item;
+            if (raw_item)
+                item.attach(raw_item);
+            return item;
+        }
+
+        /**
+         * Replace the spent batch with the next one from the enumerator.
+         *
+         * A request for less than a batch means the enumerator has no more
+         * items so, after that, the enumerator isn't called again.
+         * Enumerators that refuse to return more than one item at a time,
+         * as some old ones do, are asked for one item at a time instead.
+         *
+         * @returns  false if there are no more items.
+         */
+        bool fetch()
+        {
+            assert(m_next == m_fetched);
+
+            m_fetched = 0;
+            m_next = 0;
+
+            if (m_exhausted)
+                return false;
+
+            ULONG fetched = 0;
+            std::fill(m_batch.begin(), m_batch.end(), PITEMID_CHILD());
+            HRESULT hr = m_items->Next(
+                static_cast<ULONG>(m_batch.size()), &m_batch[0], &fetched);
+            if (FAILED(hr) && m_batch.size() > 1)
+            {
+                m_batch.resize(1);
+                fetched = 0;
+                m_batch[0] = NULL;
+                hr = m_items->Next(1, &m_batch[0], &fetched);
+            }
+
+            if (FAILED(hr))
+                BOOST_THROW_EXCEPTION(
+                    comet::com_error_from_interface(m_items, hr));
+
+            m_fetched = (std::min)(
+                static_cast<std::size_t>(fetched), m_batch.size());
+            m_exhausted = (hr != S_OK || m_fetched < m_batch.size());
+
+            return m_fetched > 0;
+        }
+
+        comet::com_ptr<IEnumIDList> m_items;
+        std::vector<PITEMID_CHILD> m_batch;
+        std::size_t m_fetched; ///< Number of PIDLs in the current batch
+        std::size_t m_next; ///< Next PIDL in the batch to hand out
+        bool m_exhausted; ///< Has the enumerator returned its last item?
+        pidl::cpidl_t m_current;
+    };
+}
+
+/**
+ * Input iterator over the child PIDLs returned by an IEnumIDList.
+ *
+ * Rather than calling Next() once per item, the iterator fetches the items
+ * in batches, which saves a virtual call per item and, for enumerators in
+ * another apartment, a round-trip per item.
+ *
+ * The PIDLs the enumerator returns are wrapped as cpidl_t without copying
+ * them.  Dereferencing gives a mutable reference to the current item so
+ * that it can be swapped out of the iterator, rather than copied, to keep.
+ *
+ * The iteration is complete when the iterator is equal to a
+ * default-constructed one.  As with istream_iterator, copies of an
+ * iterator share its position, and advancing one invalidates the others.
+ * Abandoning the iteration early frees the items already fetched but not
+ * yet visited once the last copy of the iterator is destroyed.
+ */
+class enum_item_iterator :
+    public boost::iterator_facade<
+        enum_item_iterator, pidl::cpidl_t, boost::single_pass_traversal_tag>
+{
+public:
+
+    /**
+     * Number of items fetched by each call to Next() unless told otherwise.
+     */
+    static const std::size_t default_batch_size = 256;
+
+    /**
+     * End iterator.
+     */
+    enum_item_iterator() {}
+
+    /**
+     * Iterator at the next item of an enumerator.
+     *
+     * Fetches the first batch of items.
+     *
+     * @param items       Enumerator whose items to visit.  The iterator uses
+     *                    the enumerator from its current position so it
+     *                    should not be used elsewhere while iterating.
+     * @param batch_size  Maximum number of items to ask for at a time.
+     */
+    explicit enum_item_iterator(
+        const comet::com_ptr<IEnumIDList>& items,
+        std::size_t batch_size=default_batch_size)
+    {
+        if (items)
+        {
+            m_batch.reset(new detail::enum_item_batch(items, batch_size));
+            increment();
+        }
+    }
+
+private:
+    friend class boost::iterator_core_access;
+
+    pidl::cpidl_t& dereference() const
+    {
+        if (!m_batch)
+            BOOST_THROW_EXCEPTION(
+                std::logic_error("Dereferencing past the end of the items"));
+
+        return m_batch->current();
+    }
+
+    void increment()
+    {
+        if (!m_batch)
+            BOOST_THROW_EXCEPTION(
+                std::range_error("Cannot increment past end of the items"));
+
+        if (!m_batch->advance())
+            m_batch.reset();
+    }
+
+    bool equal(const enum_item_iterator& other) const
+    {
+        return m_batch == other.m_batch;
+    }
+
+    boost::shared_ptr<detail::enum_item_batch> m_batch;
+};
+
+/**
+ * The remaining items of an enumerator as a single-pass range.
+ *
+ * @see enum_item_iterator
+ */
+inline boost::iterator_range<enum_item_iterator> enum_items(
+    const comet::com_ptr<IEnumIDList>& items,
+    std::size_t batch_size=enum_item_iterator::default_batch_size)
+{
+    return boost::iterator_range<enum_item_iterator>(
+        enum_item_iterator(items, batch_size), enum_item_iterator());
+}
+
+/**
+ * The items of a folder as a single-pass range.
+ *
+ * The items are enumerated by the folder's EnumObjects method.  A folder
+ * that has no items to enumerate may not return an enumerator, which gives
+ * an empty range.
+ *
+ * @param folder      Folder whose items to visit.
+ * @param flags       Which items to include, as for EnumObjects.
+ * @param hwnd        Window the folder may use to show UI, or NULL if it
+ *                    mustn't.
+ * @param batch_size  Maximum number of items to ask for at a time.
+ *
+ * @see enum_item_iterator
+ */
+inline boost::iterator_range<enum_item_iterator> enum_items(
+    const comet::com_ptr<IShellFolder>& folder, SHCONTF flags,
+    HWND hwnd=NULL,
+    std::size_t batch_size=enum_item_iterator::default_batch_size)
+{
+    comet::com_ptr<IEnumIDList> items;
+    HRESULT hr = folder->EnumObjects(hwnd, flags, items.out());
+    if (FAILED(hr))
+        BOOST_THROW_EXCEPTION(comet::com_error_from_interface(folder, hr));
+
+    return enum_items(items, batch_size);
+}
+
+}} // namespace washer::shell
+
+#endif
@@ -0,0 +1,446 @@
+/**
+    @file
+
+    Sorted map keyed by PIDLs packed into a single arena.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_FLAT_PIDL_MAP_HPP
+#define WASHER_SHELL_FLAT_PIDL_MAP_HPP
+#pragma once
+
+#include <washer/shell/flat_pidl_set.hpp> // basic_flat_pidl_set, pidl_less
+#include <washer/shell/pidl.hpp> // basic_pidl, basic_pidl_view
+
+#include <boost/iterator/iterator_facade.hpp> // iterator_facade
+#include <boost/throw_exception.hpp> // BOOST_THROW_EXCEPTION
+#include <boost/type_traits/is_convertible.hpp> // is_convertible
+#include <boost/utility/enable_if.hpp> // enable_if
+
+#include <algorithm> // stable_sort, unique, swap
+#include <cstddef> // ptrdiff_t
+#include <iterator> // distance
+#include <stdexcept> // out_of_range
+#include <vector>
+
+namespace washer {
+namespace shell {
+namespace pidl {
+
+namespace detail {
+
+    /**
+     * Key of a map source item and where the item came from.
+     */
+    template<typename T, typename It>
+    struct flat_map_entry
+    {
+        flat_map_entry(const basic_pidl_view<T>& key, It source)
+            : key(key), source(source) {}
+
+        basic_pidl_view<T> key;
+        It source;
+    };
+
+    template<typename T, typename It, typename Compare>
+    class entry_compare
+    {
+    public:
+        explicit entry_compare(const Compare& compare) : m_compare(compare) {}
+
+        bool operator()(
+            const flat_map_entry<T, It>& lhs,
+            const flat_map_entry<T, It>& rhs) const
+        {
+            return m_compare(lhs.key, rhs.key);
+        }
+
+    private:
+        view_compare<T, Compare> m_compare;
+    };
+
+    template<typename T, typename It, typename Compare>
+    class entry_equivalent
+    {
+    public:
+        explicit entry_equivalent(const Compare& compare)
+            : m_equivalent(compare) {}
+
+        bool operator()(
+            const flat_map_entry<T, It>& lhs,
+            const flat_map_entry<T, It>& rhs) const
+        {
+            return m_equivalent(lhs.key, rhs.key);
+        }
+
+    private:
+        view_equivalent<T, Compare> m_equivalent;
+    };
+
+    /**
+     * What flat PIDL map iterators dereference to: the raw key PIDL and a
+     * reference to its value.
+     *
+     * Has the members of a std::pair but, unlike a std::pair before C++11,
+     * can hold a reference.
+     */
+    template<typename Key, typename Value>
+    struct flat_pidl_map_reference
+    {
+        flat_pidl_map_reference(Key first, Value& second)
+            : first(first), second(second) {}
+
+        Key first;
+        Value& second;
+    };
+
+    /**
+     * Iterator over the keys and values of a flat PIDL map.
+     */
+    template<typename Key, typename Value>
+    class flat_pidl_map_iterator :
+        public boost::iterator_facade<
+            flat_pidl_map_iterator<Key, Value>,
+            flat_pidl_map_reference<Key, Value>,
+            boost::random_access_traversal_tag,
+            flat_pidl_map_reference<Key, Value> >
+    {
+    public:
+
+        flat_pidl_map_iterator() : m_key(NULL), m_value(NULL) {}
+
+        flat_pidl_map_iterator(const Key* key, Value* value)
+            : m_key(key), m_value(value) {}
+
+        /**
+         * Conversion from a mutable to a const iterator.
+         */
+        template<typename OtherValue>
+        flat_pidl_map_iterator(
+            const flat_pidl_map_iterator<Key, OtherValue>& other,
+            typename boost::enable_if<
+                boost::is_convertible<OtherValue*, Value*> >::type* =0)
+            : m_key(other.m_key), m_value(other.m_value) {}
+
+    private:
+        friend class boost::iterator_core_access;
+        template<typename, typename> friend class flat_pidl_map_iterator;
+
+        flat_pidl_map_reference<Key, Value> dereference() const
+        {
+            return flat_pidl_map_reference<Key, Value>(*m_key, *m_value);
+        }
+
+        template<typename OtherValue>
+        bool equal(const flat_pidl_map_iterator<Key, OtherValue>& other) const
+        {
+            return m_key == other.m_key;
+        }
+
+        void increment()
+        {
+            ++m_key;
+            ++m_value;
+        }
+
+        void decrement()
+        {
+            --m_key;
+            --m_value;
+        }
+
+        void advance(std::ptrdiff_t n)
+        {
+            m_key += n;
+            m_value += n;
+        }
+
+        template<typename OtherValue>
+        std::ptrdiff_t distance_to(
+            const flat_pidl_map_iterator<Key, OtherValue>& other) const
+        {
+            return other.m_key - m_key;
+        }
+
+        const Key* m_key;
+        Value* m_value;
+    };
+}
+
+/**
+ * Sorted map from PIDLs to values, with the keys in a single arena.
+ *
+ * The flat counterpart of a std::map keyed by PIDLs.  The keys are held in
+ * a basic_flat_pidl_set, so they share one contiguous block of memory and
+ * are found by a binary search that never allocates, and the values sit in
+ * a parallel vector in the same order.  Lookups take raw PIDLs directly, so
+ * a PCUITEMID_CHILD received from the shell can be looked up without first
+ * wrapping it.
+ *
+ * Iterators dereference to a proxy with @c first, the raw key, and
+ * @c second, a reference to the value.  The keys are fixed once the map is
+ * built but the values can be changed.
+ *
+ * The source range yields pairs (anything with @c first and @c second) of a
+ * terminated PIDL, in any form basic_flat_pidl_set accepts, and a value.
+ * If several keys are equivalent, the first is kept along with its value.
+ */
+template<typename T, typename V, typename Alloc, typename Compare=pidl_less>
+class basic_flat_pidl_map
+{
+public:
+
+    typedef basic_flat_pidl_set<T, Alloc, Compare> key_set_type;
+    typedef typename key_set_type::key_type key_type;
+    typedef V mapped_type;
+    typedef Compare key_compare;
+    typedef detail::flat_pidl_map_reference<key_type, V> reference;
+    typedef detail::flat_pidl_map_reference<key_type, const V>
+        const_reference;
+    typedef detail::flat_pidl_map_iterator<key_type, V> iterator;
+    typedef detail::flat_pidl_map_iterator<key_type, const V> const_iterator;
+
+    /**
+     * An empty map.
+     */
+    explicit basic_flat_pidl_map(const Compare& compare=Compare())
+        : m_keys(compare) {}
+
+    /**
+     * Map of the key-value pairs in the range.
+     *
+     * Each value is copied once, straight into its sorted position.
+     */
+    template<typename It>
+    basic_flat_pidl_map(It begin, It end, const Compare& compare=Compare())
+        : m_keys(compare)
+    {
+        typedef detail::flat_map_entry<T, It> entry;
+
+        std::vector<entry> entries;
+        entries.reserve(std::distance(begin, end));
+        for (It it = begin; it != end; ++it)
+        {
+            entries.push_back(entry(detail::packed_item<T>((*it).first), it));
+        }
+
+        std::stable_sort(
+            entries.begin(), entries.end(),
+            detail::entry_compare<T, It, Compare>(compare));
+        entries.erase(
+            std::unique(
+                entries.begin(), entries.end(),
+                detail::entry_equivalent<T, It, Compare>(compare)),
+            entries.end());
+
+        std::vector< basic_pidl_view<T> > keys;
+        std::vector<V> values;
+        keys.reserve(entries.size());
+        values.reserve(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            keys.push_back(entries[i].key);
+            values.push_back((*entries[i].source).second);
+        }
+
+        key_set_type(
+            ordered_unique_range, keys.begin(), keys.end(), compare).swap(
+                m_keys);
+        m_values.swap(values);
+    }
+
+    iterator begin()
+    {
+        return iterator(m_keys.as_array(), values());
+    }
+
+    iterator end()
+    {
+        return begin() + size();
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(m_keys.as_array(), values());
+    }
+
+    const_iterator end() const
+    {
+        return begin() + size();
+    }
+
+    /**
+     * The keys, in order, as a flat PIDL set.
+     */
+    const key_set_type& keys() const
+    {
+        return m_keys;
+    }
+
+    size_t size() const
+    {
+        return m_keys.size();
+    }
+
+    bool empty() const
+    {
+        return m_keys.empty();
+    }
+
+    key_compare key_comp() const
+    {
+        return m_keys.key_comp();
+    }
+
+    /**
+     * @name Lookup
+     *
+     * O(log n) binary searches that never allocate.
+     */
+    // @{
+
+    iterator find(const T __unaligned* key)
+    {
+        return begin() + m_keys.index_of(key);
+    }
+
+    template<typename AllocU>
+    iterator find(const basic_pidl<T, AllocU>& key)
+    {
+        return find(key.get());
+    }
+
+    const_iterator find(const T __unaligned* key) const
+    {
+        return begin() + m_keys.index_of(key);
+    }
+
+    template<typename AllocU>
+    const_iterator find(const basic_pidl<T, AllocU>& key) const
+    {
+        return find(key.get());
+    }
+
+    size_t count(const T __unaligned* key) const
+    {
+        return m_keys.count(key);
+    }
+
+    template<typename AllocU>
+    size_t count(const basic_pidl<T, AllocU>& key) const
+    {
+        return count(key.get());
+    }
+
+    /**
+     * The value of the given key.
+     *
+     * @throws std::out_of_range if the key is not in the map.
+     */
+    mapped_type& at(const T __unaligned* key)
+    {
+        return m_values[checked_index_of(key)];
+    }
+
+    template<typename AllocU>
+    mapped_type& at(const basic_pidl<T, AllocU>& key)
+    {
+        return at(key.get());
+    }
+
+    const mapped_type& at(const T __unaligned* key) const
+    {
+        return m_values[checked_index_of(key)];
+    }
+
+    template<typename AllocU>
+    const mapped_type& at(const basic_pidl<T, AllocU>& key) const
+    {
+        return at(key.get());
+    }
+
+    // @}
+
+    /**
+     * No-fail swap.
+     */
+    void swap(basic_flat_pidl_map& m) throw()
+    {
+        m_keys.swap(m.m_keys);
+        m_values.swap(m.m_values);
+    }
+
+private:
+
+    V* values()
+    {
+        return (m_values.empty()) ? NULL : &m_values[0];
+    }
+
+    const V* values() const
+    {
+        return (m_values.empty()) ? NULL : &m_values[0];
+    }
+
+    size_t checked_index_of(const T __unaligned* key) const
+    {
+        size_t index = m_keys.index_of(key);
+        if (index == size())
+            BOOST_THROW_EXCEPTION(std::out_of_range("PIDL not in map"));
+
+        return index;
+    }
+
+    key_set_type m_keys;
+    std::vector<V> m_values;
+};
+
+/**
+ * No-fail swap.
+ */
+template<typename T, typename V, typename Alloc, typename Compare>
+inline void swap(
+    basic_flat_pidl_map<T, V, Alloc, Compare>& a,
+    basic_flat_pidl_map<T, V, Alloc, Compare>& b) throw()
+{
+    a.swap(b);
+}
+
+/**
+ * Flat map from child PIDLs, such as the contents of a folder, to values of
+ * type @a V: @c flat_pidl_map<V>::type.
+ */
+template<typename V>
+struct flat_pidl_map
+{
+    typedef basic_flat_pidl_map<
+        ITEMID_CHILD, V, cotaskmem_alloc<ITEMID_CHILD> > type;
+};
+
+}}} // namespace washer::shell::pidl
+
+#endif
@@ -0,0 +1,336 @@
+/**
+    @file
+
+    Sorted, immutable set of PIDLs packed into a single arena.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_FLAT_PIDL_SET_HPP
+#define WASHER_SHELL_FLAT_PIDL_SET_HPP
+#pragma once
+
+#include <washer/shell/pidl.hpp> // basic_pidl, basic_pidl_view, raw_pidl
+#include <washer/shell/pidl_array.hpp> // basic_packed_pidl_array
+
+#include <algorithm> // lower_bound, equal_range, stable_sort, unique, swap
+#include <iterator> // distance
+#include <utility> // pair
+#include <vector>
+
+namespace washer {
+namespace shell {
+namespace pidl {
+
+/**
+ * Orders raw PIDLs bytewise, as raw_pidl::compare does.
+ *
+ * This is the default order of the flat PIDL containers.  It is quick but
+ * is not the order the shell displays items in.  Supply a comparator based
+ * on IShellFolder::CompareIDs for that.
+ */
+struct pidl_less
+{
+    template<typename T, typename U>
+    bool operator()(
+        const T __unaligned* lhs, const U __unaligned* rhs) const
+    {
+        return raw_pidl::less(lhs, rhs);
+    }
+};
+
+/**
+ * Tag telling a flat PIDL container that its source range is already
+ * sorted by the container's comparator and holds no equivalent PIDLs.
+ */
+struct ordered_unique_range_t {};
+
+/**
+ * Tag value for ordered_unique_range_t.
+ */
+const ordered_unique_range_t ordered_unique_range = ordered_unique_range_t();
+
+namespace detail {
+
+    /**
+     * Adapts a raw-PIDL comparator to compare views of terminated PIDLs.
+     */
+    template<typename T, typename Compare>
+    class view_compare
+    {
+    public:
+        explicit view_compare(const Compare& compare) : m_compare(compare) {}
+
+        bool operator()(
+            const basic_pidl_view<T>& lhs, const basic_pidl_view<T>& rhs) const
+        {
+            return m_compare(lhs.get(), rhs.get());
+        }
+
+    private:
+        Compare m_compare;
+    };
+
+    /**
+     * Adapts a raw-PIDL comparator to test views for equivalence.
+     */
+    template<typename T, typename Compare>
+    class view_equivalent
+    {
+    public:
+        explicit view_equivalent(const Compare& compare) : m_compare(compare)
+        {}
+
+        bool operator()(
+            const basic_pidl_view<T>& lhs, const basic_pidl_view<T>& rhs) const
+        {
+            return !m_compare(lhs.get(), rhs.get()) &&
+                !m_compare(rhs.get(), lhs.get());
+        }
+
+    private:
+        Compare m_compare;
+    };
+}
+
+/**
+ * Sorted set of PIDLs held in a single contiguous arena.
+ *
+ * Suits collections that are built in one go and then searched many times,
+ * such as the children of an enumerated folder.  All the PIDLs are copied
+ * into one basic_packed_pidl_array in order, so the set holds one block of
+ * memory however many PIDLs it has, and lookups are a binary search of
+ * its pointer table that never allocate.
+ *
+ * The set is ordered by @a Compare, which takes two raw PIDLs of type
+ * @c const T* and must be a strict weak ordering.  The default orders them
+ * bytewise.  Lookups take raw PIDLs directly, so a PCUITEMID_CHILD received
+ * from the shell can be looked up without first wrapping it.
+ *
+ * The set cannot be modified once built; build a new one instead.  Source
+ * ranges must allow more than one pass (forward iterators) and yield
+ * terminated PIDLs: raw PIDLs, terminated views or wrappers with a get()
+ * method.
+ */
+template<typename T, typename Alloc, typename Compare=pidl_less>
+class basic_flat_pidl_set
+{
+    typedef basic_packed_pidl_array<T, Alloc> storage_type;
+
+public:
+
+    typedef typename storage_type::value_type value_type;
+    typedef value_type key_type;
+    typedef Compare key_compare;
+    typedef typename storage_type::const_iterator const_iterator;
+    typedef const_iterator iterator;
+
+    /**
+     * An empty set.
+     */
+    explicit basic_flat_pidl_set(const Compare& compare=Compare())
+        : m_compare(compare) {}
+
+    /**
+     * Set of the PIDLs in the range.
+     *
+     * The range is sorted and only the first of any equivalent PIDLs is
+     * kept.
+     */
+    template<typename It>
+    basic_flat_pidl_set(It begin, It end, const Compare& compare=Compare())
+        : m_compare(compare)
+    {
+        std::vector< basic_pidl_view<T> > items;
+        items.reserve(std::distance(begin, end));
+        for (It it = begin; it != end; ++it)
+        {
+            items.push_back(detail::packed_item<T>(*it));
+        }
+
+        std::stable_sort(
+            items.begin(), items.end(),
+            detail::view_compare<T, Compare>(m_compare));
+        items.erase(
+            std::unique(
+                items.begin(), items.end(),
+                detail::view_equivalent<T, Compare>(m_compare)),
+            items.end());
+
+        storage_type(items.begin(), items.end()).swap(m_items);
+    }
+
+    /**
+     * Set of the PIDLs in a range that is already sorted and unique.
+     *
+     * Skips sorting; the range is copied as it is.  Passing a range that
+     * is not sorted by @a compare, or that holds equivalent PIDLs, breaks
+     * lookups.
+     */
+    template<typename It>
+    basic_flat_pidl_set(
+        ordered_unique_range_t, It begin, It end,
+        const Compare& compare=Compare())
+        : m_items(begin, end), m_compare(compare) {}
+
+    const_iterator begin() const
+    {
+        return m_items.begin();
+    }
+
+    const_iterator end() const
+    {
+        return m_items.end();
+    }
+
+    /**
+     * The PIDL at the given position in the order.
+     */
+    value_type operator[](size_t i) const
+    {
+        return m_items[i];
+    }
+
+    /**
+     * The PIDLs, in order, as an array of raw PIDLs.
+     *
+     * For child PIDLs this is a PCUITEMID_CHILD_ARRAY.
+     */
+    const value_type* as_array() const
+    {
+        return m_items.as_array();
+    }
+
+    size_t size() const
+    {
+        return m_items.size();
+    }
+
+    bool empty() const
+    {
+        return m_items.empty();
+    }
+
+    key_compare key_comp() const
+    {
+        return m_compare;
+    }
+
+    /**
+     * @name Lookup
+     *
+     * O(log n) binary searches that never allocate.
+     */
+    // @{
+
+    const_iterator find(const T __unaligned* key) const
+    {
+        const_iterator it = lower_bound(key);
+        if (it != end() && !m_compare(key, *it))
+            return it;
+        else
+            return end();
+    }
+
+    template<typename AllocU>
+    const_iterator find(const basic_pidl<T, AllocU>& key) const
+    {
+        return find(key.get());
+    }
+
+    size_t count(const T __unaligned* key) const
+    {
+        return (find(key) != end()) ? 1 : 0;
+    }
+
+    template<typename AllocU>
+    size_t count(const basic_pidl<T, AllocU>& key) const
+    {
+        return count(key.get());
+    }
+
+    const_iterator lower_bound(const T __unaligned* key) const
+    {
+        return std::lower_bound(begin(), end(), key, m_compare);
+    }
+
+    const_iterator upper_bound(const T __unaligned* key) const
+    {
+        return std::upper_bound(begin(), end(), key, m_compare);
+    }
+
+    std::pair<const_iterator, const_iterator> equal_range(
+        const T __unaligned* key) const
+    {
+        return std::equal_range(begin(), end(), key, m_compare);
+    }
+
+    // @}
+
+    /**
+     * Position of the given PIDL in the order, or size() if it is not in
+     * the set.
+     */
+    size_t index_of(const T __unaligned* key) const
+    {
+        return find(key) - begin();
+    }
+
+    /**
+     * No-fail swap.
+     */
+    void swap(basic_flat_pidl_set& s) throw()
+    {
+        m_items.swap(s.m_items);
+        std::swap(m_compare, s.m_compare);
+    }
+
+private:
+
+    storage_type m_items;
+    Compare m_compare;
+};
+
+/**
+ * No-fail swap.
+ */
+template<typename T, typename Alloc, typename Compare>
+inline void swap(
+    basic_flat_pidl_set<T, Alloc, Compare>& a,
+    basic_flat_pidl_set<T, Alloc, Compare>& b) throw()
+{
+    a.swap(b);
+}
+
+/**
+ * Flat set of child PIDLs, such as the contents of a folder.
+ */
+typedef basic_flat_pidl_set<ITEMID_CHILD, cotaskmem_alloc<ITEMID_CHILD> >
+    flat_pidl_set;
+
+}}} // namespace washer::shell::pidl
+
+#endif
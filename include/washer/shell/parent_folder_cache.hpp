@@ -0,0 +1,430 @@
+/**
+    @file
+
+    Cache of bound parent folders.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_PARENT_FOLDER_CACHE_HPP
+#define WASHER_SHELL_PARENT_FOLDER_CACHE_HPP
+#pragma once
+
+#include <washer/dynamic_link.hpp> // load_function
+#include <washer/shell/pidl.hpp> // apidl_view
+#include <washer/shell/pidl_lru_cache.hpp> // pidl_lru_cache
+
+#include <comet/ptr.h> // com_ptr
+
+#include <boost/function.hpp> // function
+#include <boost/noncopyable.hpp> // noncopyable
+#include <boost/thread/locks.hpp> // lock_guard
+#include <boost/thread/mutex.hpp> // mutex
+
+#include <cstddef> // size_t
+#include <exception> // exception
+#include <functional> // equal_to
+#include <map>
+#include <vector>
+
+#include <ShObjIdl.h> // IShellFolder
+
+namespace washer {
+namespace shell {
+
+namespace detail {
+
+    /**
+     * IComThreadingInfo.
+     *
+     * Declared here, like the apartment types below, rather than taken from
+     * the SDK, which only declares it when targeting Windows 2000 or later.
+     */
+    struct com_threading_info : public IUnknown
+    {
+        virtual HRESULT STDMETHODCALLTYPE GetCurrentApartmentType(
+            int* type) = 0;
+        virtual HRESULT STDMETHODCALLTYPE GetCurrentThreadType(
+            int* type) = 0;
+        virtual HRESULT STDMETHODCALLTYPE GetCurrentLogicalThreadId(
+            GUID* id) = 0;
+        virtual HRESULT STDMETHODCALLTYPE SetCurrentLogicalThreadId(
+            REFGUID id) = 0;
+    };
+
+    inline const IID& com_threading_info_iid()
+    {
+        static const IID iid = {
+            0x000001ce, 0x0000, 0x0000,
+            { 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46 } };
+        return iid;
+    }
+
+    /**
+     * Identifies the calling thread's COM apartment.
+     *
+     * This needs CoGetObjectContext, which only Windows 2000 and later have,
+     * so it is looked up in OLE32 at run time.  Where it is missing, no
+     * thread is in an apartment whose interface pointers can be cached.
+     */
+    class apartment_identifier
+    {
+    public:
+
+        apartment_identifier()
+        {
+            try
+            {
+                m_get_object_context = washer::load_function<
+                    HRESULT STDAPICALLTYPE (REFIID, void**)>(
+                        "ole32.dll", "CoGetObjectContext");
+            }
+            catch (const std::exception&)
+            {
+                // Leave it empty; nothing will be cached
+            }
+        }
+
+        /**
+         * Identify the calling thread's COM apartment.
+         *
+         * Threads in a single-threaded apartment are identified by their
+         * thread ID.  All threads in the process's multithreaded apartment
+         * share the identifier zero, which is never a thread ID.
+         *
+         * @returns  false if the thread isn't in an apartment whose interface
+         *           pointers can be cached: it hasn't initialised COM, is
+         *           running in the neutral apartment or this version of
+         *           Windows can't tell.
+         */
+        bool operator()(DWORD& apartment) const
+        {
+            if (!m_get_object_context)
+                return false;
+
+            com_threading_info* info = NULL;
+            HRESULT hr = m_get_object_context(
+                com_threading_info_iid(), reinterpret_cast<void**>(&info));
+            if (FAILED(hr) || !info)
+                return false;
+
+            int type;
+            hr = info->GetCurrentApartmentType(&type);
+            info->Release();
+            if (FAILED(hr))
+                return false;
+
+            switch (type)
+            {
+            case apartment_sta:
+            case apartment_main_sta:
+                apartment = ::GetCurrentThreadId();
+                return true;
+
+            case apartment_mta:
+                apartment = 0;
+                return true;
+
+            default:
+                return false;
+            }
+        }
+
+    private:
+
+        /// APTTYPE values
+        enum
+        {
+            apartment_sta = 0,
+            apartment_mta = 1,
+            apartment_neutral = 2,
+            apartment_main_sta = 3
+        };
+
+        boost::function<HRESULT (REFIID, void**)> m_get_object_context;
+    };
+}
+
+/**
+ * Remembers the IShellFolder of folders that have been bound to, so that
+ * binding to the parent of many items in the same folder binds the folder
+ * only once.
+ *
+ * Folders are keyed on their absolute PIDL and on the COM apartment they
+ * were bound in.  An interface pointer is only valid in the apartment that
+ * obtained it, so each apartment sees only the folders it cached itself.
+ * Threads that haven't initialised COM, or are in the neutral apartment,
+ * bypass the cache.  So does every thread on Windows before 2000, which
+ * can't identify apartments.
+ *
+ * The cache holds at most @c capacity folders and, when full, forgets the
+ * least recently used one.  Folders do not expire; call invalidate() or
+ * invalidate_subtree() when folders are renamed, moved or deleted.
+ *
+ * The cache can be shared between threads.  Removing a folder that belongs
+ * to a different apartment from the caller's does not release it there and
+ * then, which would break COM's rules, but sets it aside to be released the
+ * next time its own apartment uses the cache.  A single-threaded apartment
+ * that has used the cache must call release_apartment() before it
+ * uninitialises COM, as its folders are invalid afterwards and its thread
+ * ID may be reused.
+ */
+class parent_folder_cache : private boost::noncopyable
+{
+public:
+
+    /**
+     * An empty cache that will hold at most @a capacity folders.
+     */
+    explicit parent_folder_cache(std::size_t capacity) : m_folders(capacity)
+    {}
+
+    /**
+     * Release the folders belonging to the calling apartment.
+     *
+     * Folders from other apartments are deliberately leaked as they can't
+     * safely be released here.
+     */
+    ~parent_folder_cache() throw()
+    {
+        try
+        {
+            release_apartment();
+        }
+        catch (...) {}
+
+        for (graveyard::iterator it = m_set_aside.begin();
+             it != m_set_aside.end(); ++it)
+        {
+            for (std::size_t i = 0; i < it->second.size(); ++i)
+            {
+                it->second[i].detach();
+            }
+        }
+
+        m_folders.clear(leak());
+    }
+
+    /**
+     * The cached folder at the given PIDL, if the calling apartment has
+     * cached it.
+     *
+     * The view doesn't have to be terminated so the parent of a PIDL can be
+     * looked up without copying it.
+     *
+     * @returns  The folder or a NULL pointer if not cached.
+     */
+    comet::com_ptr<IShellFolder> find(const pidl::apidl_view& folder)
+    {
+        DWORD apartment;
+        if (!m_current_apartment(apartment))
+            return comet::com_ptr<IShellFolder>();
+
+        folder_list released; // released after unlocking
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+        take_set_aside(apartment, released);
+
+        comet::com_ptr<IShellFolder>* cached =
+            m_folders.find(folder, apartment);
+        return (cached) ? *cached : comet::com_ptr<IShellFolder>();
+    }
+
+    /**
+     * Remember a folder bound in the calling apartment, replacing any
+     * folder the apartment has already cached at the same PIDL.
+     */
+    void insert(
+        PCIDLIST_ABSOLUTE folder, const comet::com_ptr<IShellFolder>& handler)
+    {
+        DWORD apartment;
+        if (!m_current_apartment(apartment))
+            return;
+
+        folder_list released;
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+        take_set_aside(apartment, released);
+
+        m_folders.insert(
+            folder, apartment, handler,
+            set_aside(true, apartment, released, m_set_aside));
+    }
+
+    /**
+     * Forget the folder at the given PIDL in every apartment.
+     *
+     * @returns  Number of cached folders forgotten.
+     */
+    std::size_t invalidate(PCIDLIST_ABSOLUTE folder)
+    {
+        DWORD apartment;
+        bool cacheable = m_current_apartment(apartment);
+
+        folder_list released;
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+
+        return m_folders.invalidate(
+            folder, set_aside(cacheable, apartment, released, m_set_aside));
+    }
+
+    /**
+     * Forget the folder at the given PIDL, and all folders below it, in
+     * every apartment.
+     *
+     * @returns  Number of cached folders forgotten.
+     */
+    std::size_t invalidate_subtree(PCIDLIST_ABSOLUTE folder)
+    {
+        DWORD apartment;
+        bool cacheable = m_current_apartment(apartment);
+
+        folder_list released;
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+
+        return m_folders.invalidate_subtree(
+            folder, set_aside(cacheable, apartment, released, m_set_aside));
+    }
+
+    /**
+     * Forget every folder in every apartment.
+     */
+    void clear()
+    {
+        DWORD apartment;
+        bool cacheable = m_current_apartment(apartment);
+
+        folder_list released;
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+
+        m_folders.clear(
+            set_aside(cacheable, apartment, released, m_set_aside));
+    }
+
+    /**
+     * Release every folder belonging to the calling apartment, including
+     * those set aside by other threads.
+     *
+     * @returns  Number of cached folders forgotten.
+     */
+    std::size_t release_apartment()
+    {
+        DWORD apartment;
+        if (!m_current_apartment(apartment))
+            return 0;
+
+        folder_list released;
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+        take_set_aside(apartment, released);
+
+        return m_folders.erase_if(
+            std::bind2nd(std::equal_to<DWORD>(), apartment),
+            set_aside(true, apartment, released, m_set_aside));
+    }
+
+    /**
+     * Number of folders cached, across all apartments.
+     */
+    std::size_t size() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+        return m_folders.size();
+    }
+
+    std::size_t capacity() const
+    {
+        return m_folders.capacity();
+    }
+
+    pidl_lru_cache_statistics statistics() const
+    {
+        boost::lock_guard<boost::mutex> lock(m_mutex);
+        return m_folders.statistics();
+    }
+
+private:
+
+    typedef std::vector< comet::com_ptr<IShellFolder> > folder_list;
+    typedef std::map<DWORD, folder_list> graveyard;
+
+    /**
+     * Takes the folders out of entries being removed so that they are
+     * released in their own apartment, and outside the lock.
+     */
+    class set_aside
+    {
+    public:
+        set_aside(
+            bool cacheable, DWORD apartment, folder_list& here,
+            graveyard& elsewhere)
+            : m_cacheable(cacheable), m_apartment(apartment), m_here(&here),
+              m_elsewhere(&elsewhere) {}
+
+        void operator()(DWORD owner, comet::com_ptr<IShellFolder>& folder)
+        {
+            folder_list& destination =
+                (m_cacheable && owner == m_apartment) ?
+                    *m_here : (*m_elsewhere)[owner];
+
+            destination.push_back(comet::com_ptr<IShellFolder>());
+            destination.back().swap(folder);
+        }
+
+    private:
+        bool m_cacheable;
+        DWORD m_apartment;
+        folder_list* m_here;
+        graveyard* m_elsewhere;
+    };
+
+    struct leak
+    {
+        void operator()(DWORD, comet::com_ptr<IShellFolder>& folder)
+        {
+            folder.detach();
+        }
+    };
+
+    /**
+     * Collect folders other threads set aside for this apartment.
+     */
+    void take_set_aside(DWORD apartment, folder_list& released)
+    {
+        graveyard::iterator pos = m_set_aside.find(apartment);
+        if (pos != m_set_aside.end())
+        {
+            released.swap(pos->second);
+            m_set_aside.erase(pos);
+        }
+    }
+
+    detail::apartment_identifier m_current_apartment;
+    mutable boost::mutex m_mutex;
+    pidl_lru_cache<DWORD, comet::com_ptr<IShellFolder> > m_folders;
+    graveyard m_set_aside;
+};
+
+}} // namespace washer::shell
+
+#endif
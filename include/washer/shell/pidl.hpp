@@ -34,14 +34,32 @@
 #define WASHER_SHELL_PIDL_HPP
 #pragma once
 
+#include <boost/config.hpp> // BOOST_NO_CXX11_HDR_FUNCTIONAL
+#include <boost/cstdint.hpp> // uint32_t, uint64_t
+#include <boost/static_assert.hpp> // BOOST_STATIC_ASSERT
 #include <boost/throw_exception.hpp> // BOOST_THROW_EXCEPTION
+#include <boost/type_traits/is_convertible.hpp> // is_convertible
+#include <boost/type_traits/is_same.hpp> // is_same
 #include <boost/utility/enable_if.hpp> // conditional specsation of combine
+#include <boost/version.hpp>
+#if (BOOST_VERSION >= 104800)
+#include <boost/move/move.hpp> // BOOST_RV_REF, BOOST_COPYABLE_AND_MOVABLE, move
+#endif
 
-#include <algorithm> // swap
+#include <algorithm> // min, swap
 #include <cassert> // assert
-#include <cstring> // memcpy
+#include <cstddef> // size_t
+#include <cstring> // memcpy, memcmp
 #include <exception> // bad_alloc
-#include <stdexcept> // invalid_argument, logic_error
+#include <iterator> // distance
+#include <stdexcept> // invalid_argument, logic_error, out_of_range
+#if !defined(BOOST_NO_CXX11_HDR_FUNCTIONAL) && \
+    !defined(BOOST_NO_0X_HDR_FUNCTIONAL)
+#include <functional> // hash
+#endif
+#include <vector>
+
+#ifdef _WIN32
 
 #include <Objbase.h> // CoTaskMemAlloc/Free
 
@@ -51,6 +69,13 @@
 
 #include <ShTypes.h> // Raw PIDL types
 
+#else
+
+// Raw PIDL types and CoTaskMemAlloc/Free stand-ins
+#include <washer/detail/portable_shell_types.hpp>
+
+#endif
+
 namespace washer {
 namespace shell {
 namespace pidl {
@@ -171,6 +196,156 @@ inline bool operator!=(const cotaskmem_alloc<T>&, const cotaskmem_alloc<U>&)
 // @}
 
 
+namespace detail {
+
+    /**
+     * Hashing constants for the word size of the platform.
+     *
+     * These are the primes and shifts of xxHash's 32- and 64-bit variants.
+     */
+    template<size_t WordSize>
+    struct hash_parameters;
+
+    template<>
+    struct hash_parameters<4>
+    {
+        static const boost::uint32_t prime1 = 0x9e3779b1U;
+        static const boost::uint32_t prime2 = 0x85ebca77U;
+        static const boost::uint32_t prime3 = 0xc2b2ae3dU;
+        static const int round_rotation = 13;
+        static const int shift1 = 15;
+        static const int shift2 = 13;
+        static const int shift3 = 16;
+    };
+
+    template<>
+    struct hash_parameters<8>
+    {
+        static const boost::uint64_t prime1 = 0x9e3779b185ebca87ULL;
+        static const boost::uint64_t prime2 = 0xc2b2ae3d27d4eb4fULL;
+        static const boost::uint64_t prime3 = 0x165667b19e3779f9ULL;
+        static const int round_rotation = 31;
+        static const int shift1 = 33;
+        static const int shift2 = 29;
+        static const int shift3 = 32;
+    };
+
+    /**
+     * Accumulates a hash of a PIDL item-by-item.
+     *
+     * Each item is consumed a machine word at a time (the final partial word
+     * zero-padded).  Successive words go to four independent lanes in turn and
+     * the lanes are only combined at the end, so the processor can work on
+     * four words at once instead of waiting for each multiply to finish
+     * before starting the next.  Items are fed in individually because raw
+     * PIDLs are only measured by walking them; the caller can hash as it
+     * walks rather than measuring the PIDL first.  Feeding the same items
+     * always gives the same hash whether they came from a raw PIDL or a view.
+     */
+    class pidl_hasher
+    {
+        typedef hash_parameters<sizeof(size_t)> parameters;
+
+    public:
+
+        pidl_hasher() : m_length(0), m_next_lane(0)
+        {
+            m_lanes[0] = static_cast<size_t>(
+                parameters::prime1 + parameters::prime2);
+            m_lanes[1] = static_cast<size_t>(parameters::prime2);
+            m_lanes[2] = 0;
+            m_lanes[3] = static_cast<size_t>(0 - parameters::prime1);
+        }
+
+        void add_item(const void __unaligned* item, size_t item_size)
+        {
+            const BYTE __unaligned* bytes =
+                static_cast<const BYTE __unaligned*>(item);
+            m_length += item_size;
+
+            if (item_size >= lane_count * sizeof(size_t))
+            {
+                size_t& lane0 = m_lanes[m_next_lane];
+                size_t& lane1 = m_lanes[(m_next_lane + 1) % lane_count];
+                size_t& lane2 = m_lanes[(m_next_lane + 2) % lane_count];
+                size_t& lane3 = m_lanes[(m_next_lane + 3) % lane_count];
+
+                // Locals so the compiler keeps the lanes in registers
+                size_t h0 = lane0, h1 = lane1, h2 = lane2, h3 = lane3;
+                for (; item_size >= lane_count * sizeof(size_t);
+                     item_size -= lane_count * sizeof(size_t),
+                     bytes += lane_count * sizeof(size_t))
+                {
+                    h0 = round(h0, word_at(bytes));
+                    h1 = round(h1, word_at(bytes + sizeof(size_t)));
+                    h2 = round(h2, word_at(bytes + 2 * sizeof(size_t)));
+                    h3 = round(h3, word_at(bytes + 3 * sizeof(size_t)));
+                }
+                lane0 = h0; lane1 = h1; lane2 = h2; lane3 = h3;
+            }
+
+            for (; item_size >= sizeof(size_t);
+                 item_size -= sizeof(size_t), bytes += sizeof(size_t))
+            {
+                add_word(word_at(bytes));
+            }
+
+            if (item_size)
+            {
+                size_t word = 0;
+                std::memcpy(&word, bytes, item_size);
+                add_word(word);
+            }
+        }
+
+        size_t value() const
+        {
+            size_t hash = rotate(m_lanes[0], 1) + rotate(m_lanes[1], 7) +
+                rotate(m_lanes[2], 12) + rotate(m_lanes[3], 18) + m_length;
+
+            hash ^= hash >> parameters::shift1;
+            hash *= static_cast<size_t>(parameters::prime2);
+            hash ^= hash >> parameters::shift2;
+            hash *= static_cast<size_t>(parameters::prime3);
+            hash ^= hash >> parameters::shift3;
+            return hash;
+        }
+
+    private:
+
+        static const size_t lane_count = 4;
+
+        static size_t word_at(const BYTE __unaligned* bytes)
+        {
+            size_t word;
+            std::memcpy(&word, bytes, sizeof(word));
+            return word;
+        }
+
+        static size_t rotate(size_t value, int bits)
+        {
+            return (value << bits) | (value >> (sizeof(size_t) * 8 - bits));
+        }
+
+        static size_t round(size_t lane, size_t word)
+        {
+            lane += word * static_cast<size_t>(parameters::prime2);
+            lane = rotate(lane, parameters::round_rotation);
+            return lane * static_cast<size_t>(parameters::prime1);
+        }
+
+        void add_word(size_t word)
+        {
+            m_lanes[m_next_lane] = round(m_lanes[m_next_lane], word);
+            m_next_lane = (m_next_lane + 1) % lane_count;
+        }
+
+        size_t m_lanes[lane_count];
+        size_t m_length; ///< Total bytes hashed
+        size_t m_next_lane; ///< Lane the next word goes to
+    };
+}
+
 namespace raw_pidl {
 
     /**
@@ -199,6 +374,15 @@ namespace raw_pidl {
         return skip(pidl, pidl->mkid.cb);
     }
 
+    /**
+     * Return if PIDL is considered empty (aka. desktop folder).
+     */
+    template<typename T>
+    inline bool empty(const T __unaligned* pidl)
+    {
+        return (pidl == NULL) || (pidl->mkid.cb == 0);
+    }
+
     /**
      * Return address of the last item in the PIDL.
      */
@@ -215,15 +399,6 @@ namespace raw_pidl {
         return reinterpret_cast<const ITEMID_CHILD __unaligned*>(p);
     }
 
-    /**
-     * Return if PIDL is considered empty (aka. desktop folder).
-     */
-    template<typename T>
-    inline bool empty(const T __unaligned* pidl)
-    {
-        return (pidl == NULL) || (pidl->mkid.cb == 0);
-    }
-
     /**
      * Traits governing operations on raw PIDLs.
      */
@@ -254,6 +429,13 @@ namespace raw_pidl {
 
         static void type_check(clone_pidl_type) {} ///< Check PIDLs are what
                                                    ///< they say they are
+
+        static void depth_check(size_t) {} ///< Check a PIDL of the given
+                                           ///< depth can be of this type
+
+        static const size_t max_depth = static_cast<size_t>(-1);
+                                          ///< Most items a PIDL of this type
+                                          ///< can hold
     };
 
     template<>
@@ -266,13 +448,21 @@ namespace raw_pidl {
         typedef ITEMIDLIST_RELATIVE combine_type;
         typedef ITEMIDLIST_RELATIVE* combine_pidl_type;
         static const bool is_appendable = true;
-        static const void type_check(clone_pidl_type pidl)
+        static void type_check(clone_pidl_type pidl)
         {
             if (!empty(pidl) && !empty(next(pidl)))
                 BOOST_THROW_EXCEPTION(
                     std::invalid_argument(
                         "type violation, encountered non-child pidl"));
         }
+        static void depth_check(size_t depth)
+        {
+            if (depth > 1)
+                BOOST_THROW_EXCEPTION(
+                    std::invalid_argument(
+                        "type violation, encountered non-child pidl"));
+        }
+        static const size_t max_depth = 1;
     };
 
     template<>
@@ -285,7 +475,9 @@ namespace raw_pidl {
         typedef idlist_type combine_type;
         typedef pidl_type combine_pidl_type;
         static const bool is_appendable = false;
-        static const void type_check(clone_pidl_type) {}
+        static void type_check(clone_pidl_type) {}
+        static void depth_check(size_t) {}
+        static const size_t max_depth = static_cast<size_t>(-1);
     };
 
     /**
@@ -310,6 +502,70 @@ namespace raw_pidl {
         return s;
     }
 
+    /**
+     * Size and depth of a PIDL that has passed validation.
+     */
+    struct measurement
+    {
+        size_t size; ///< Bytes including null-terminator; 0 if NULL
+        size_t depth; ///< Number of items
+    };
+
+    /**
+     * Check a PIDL from an untrusted source and measure it.
+     *
+     * Unlike the other functions here, which trust each item's @c cb field,
+     * this never reads beyond @a max_size bytes from the start of the PIDL.
+     * In a single pass it checks that:
+     *  - every item is at least large enough to hold its @c cb field;
+     *  - every item, and the null-terminator after the last one, fits
+     *    within @a max_size bytes;
+     *  - the number of items is allowed for PIDLs of type T (i.e. child
+     *    PIDLs have at most one item).
+     *
+     * The result can be passed to the basic_pidl constructor so the PIDL
+     * isn't walked again to copy it.
+     *
+     * @param pidl      The PIDL to check.  May be NULL.
+     * @param max_size  Number of bytes known to be readable at @a pidl.
+     *
+     * @throws std::invalid_argument if the PIDL is not valid.
+     */
+    template<typename T>
+    inline measurement validate(const T __unaligned* pidl, size_t max_size)
+    {
+        measurement result = {0, 0};
+        if (!pidl)
+            return result;
+
+        size_t position = 0;
+        for (;;)
+        {
+            if (max_size - position < sizeof(pidl->mkid.cb))
+                BOOST_THROW_EXCEPTION(
+                    std::invalid_argument("PIDL is not terminated in bounds"));
+
+            USHORT cb = skip(pidl, position)->mkid.cb;
+            if (cb == 0)
+                break;
+
+            if (cb < sizeof(pidl->mkid.cb))
+                BOOST_THROW_EXCEPTION(
+                    std::invalid_argument("PIDL item is too short"));
+            if (cb > max_size - position)
+                BOOST_THROW_EXCEPTION(
+                    std::invalid_argument("PIDL item overruns bounds"));
+
+            position += cb;
+            ++result.depth;
+        }
+
+        traits<T>::depth_check(result.depth);
+
+        result.size = position + sizeof(pidl->mkid.cb);
+        return result;
+    }
+
     /**
      * Clone a raw PIDL.
      */
@@ -327,6 +583,22 @@ namespace raw_pidl {
         return mem;
     }
 
+    /**
+     * Clone a raw PIDL whose size, including the null-terminator, is
+     * already known.
+     */
+    template<typename Alloc, typename T>
+    inline T* clone(const T __unaligned* pidl, size_t size)
+    {
+        if (!pidl)
+            return NULL;
+
+        T* mem = Alloc::allocate(size);
+        std::memcpy(mem, pidl, size);
+
+        return mem;
+    }
+
     /**
      * Clone a raw PIDL after a type check that throws on failure.
      *
@@ -365,7 +637,7 @@ namespace raw_pidl {
     {
         (void) dummy;
         typedef typename traits<T>::combine_type return_item_type;
-        typedef typename Alloc::rebind<return_item_type>::other
+        typedef typename Alloc::template rebind<return_item_type>::other
             allocator_type;
 
         if (!lhs_pidl && !rhs_pidl)
@@ -379,7 +651,8 @@ namespace raw_pidl {
         if (lhs_len && rhs_len)
             len -= sizeof(lhs_pidl->mkid.cb);
 
-        traits<T>::combine_pidl_type mem = allocator_type::allocate(len);
+        typename traits<T>::combine_pidl_type mem =
+            allocator_type::allocate(len);
         std::memcpy(mem, lhs_pidl, lhs_len);
         std::memcpy(
             skip(mem, lhs_len - ((lhs_len) ? sizeof(lhs_pidl->mkid.cb) : 0)),
@@ -387,134 +660,762 @@ namespace raw_pidl {
 
         return mem;
     }
-}
-
-/**
- * Templated PIDL wrapper class.
- *
- * Takes the particular type of raw PIDL (e.g. child - ITEMID_CHILD,
- * relative - ITEMIDLIST_RELATIVE or absolute ITEMIDLIST_ABSOLUTE) as a
- * template parameter, T, ensuring that the operations remain safe with
- * respect to the underlying PIDL type.
- *
- * The template also takes a parameter, Alloc, which specifies an allocator
- * to use when creating new PIDLs.  This allows us to use new & delete rather
- * than the COM allocator (the usual allocator for PIDLs) when testing so that
- * we can detect memory leaks.
- *
- * PIDLs being copied from elsewhere are always treated as unaligned because
- * they may be part way through a larger ITEMIDLIST. Although there may be a
- * performance disadvantage in the case where we are sure the incoming pointer
- * is aligned, it is negligible because aligned child PIDLs are small and
- * aligned absolute PIDLs will have to be treated as unaligned from the second
- * item in the list onwards.  Relative PIDLs should always be treated as
- * unaligned.
- */
-template<typename T, typename Alloc>
-class basic_pidl
-{
-public:
 
-    typedef T                                                     value_type;
-    typedef T*                                                    pointer;
-    typedef const T*                                              const_pointer;
-    typedef Alloc                                                 allocator;
-    typedef typename raw_pidl::traits<T>::combine_type            join_type;
-    typedef typename raw_pidl::traits<T>::combine_pidl_type       join_pidl_type;
-    typedef typename allocator::template rebind<join_type>::other join_allocator;
-    typedef typename basic_pidl<join_type, join_allocator>        join_pidl;
-    typedef typename raw_pidl::traits<T>::clone_pidl_type         foreign_pidl_type;
+    /**
+     * Hash of a raw PIDL's items.
+     *
+     * The PIDL is hashed in the same pass that walks it.  NULL and empty
+     * PIDLs have the same hash as they both represent the desktop.
+     */
+    template<typename T>
+    inline size_t hash(const T __unaligned* pidl)
+    {
+        detail::pidl_hasher hasher;
 
-    basic_pidl() : m_pidl(NULL), m_allocator(Alloc()) {}
+        for (; !empty(pidl); pidl = next(pidl))
+        {
+            hasher.add_item(pidl, pidl->mkid.cb);
+        }
 
-    ~basic_pidl() throw()
-    {
-        m_allocator.deallocate(m_pidl);
+        return hasher.value();
     }
 
     /**
-     * Copy construction.
+     * Three-way bytewise comparison of two raw PIDLs.
+     *
+     * PIDLs are compared item-by-item, each item by its contents as an
+     * unsigned byte string, so a PIDL always sorts before PIDLs it is a
+     * prefix of and all PIDLs sharing a prefix sort next to each other.
+     * NULL and empty PIDLs are equal.
+     *
+     * The order is not the order the shell would display the items in;
+     * that requires IShellFolder::CompareIDs.
+     *
+     * @returns  Negative if @a lhs orders before @a rhs, positive if after
+     *           and 0 if they are equal.
      */
-    basic_pidl(const basic_pidl& pidl) :
-        m_pidl(typename raw_pidl::clone<Alloc>(pidl.m_pidl)) {}
+    template<typename T, typename U>
+    inline int compare(const T __unaligned* lhs, const U __unaligned* rhs)
+    {
+        for (; !empty(lhs) && !empty(rhs); lhs = next(lhs), rhs = next(rhs))
+        {
+            size_t lhs_data = lhs->mkid.cb - sizeof(lhs->mkid.cb);
+            size_t rhs_data = rhs->mkid.cb - sizeof(rhs->mkid.cb);
+
+            int result = std::memcmp(
+                lhs->mkid.abID, rhs->mkid.abID, (std::min)(lhs_data, rhs_data));
+            if (result != 0)
+                return result;
+
+            if (lhs_data != rhs_data)
+                return (lhs_data < rhs_data) ? -1 : 1;
+        }
+
+        if (empty(lhs))
+            return (empty(rhs)) ? 0 : -1;
+        else
+            return 1;
+    }
 
     /**
-     * Construct by copying a raw PIDL.
+     * Are two raw PIDLs the same, byte for byte?
+     *
+     * NULL and empty PIDLs are equal.
      */
-    basic_pidl(const __unaligned T* raw_pidl) :
-        m_pidl(typename raw_pidl::type_checked_clone<Alloc>(raw_pidl)) {}
+    template<typename T, typename U>
+    inline bool equal(const T __unaligned* lhs, const U __unaligned* rhs)
+    {
+        for (; !empty(lhs) && !empty(rhs); lhs = next(lhs), rhs = next(rhs))
+        {
+            if (lhs->mkid.cb != rhs->mkid.cb ||
+                std::memcmp(lhs, rhs, lhs->mkid.cb) != 0)
+                return false;
+        }
+
+        return empty(lhs) && empty(rhs);
+    }
 
     /**
-     * Copy assignment.
+     * Does @a lhs order before @a rhs in the order defined by compare()?
      */
-    basic_pidl& operator=(const basic_pidl& pidl)
+    template<typename T, typename U>
+    inline bool less(const T __unaligned* lhs, const U __unaligned* rhs)
     {
-        basic_pidl copy(pidl);
-        swap(copy);
-        return *this;
+        return compare(lhs, rhs) < 0;
     }
 
     /**
-     * Copy a raw PIDL into this wrapper instance.
+     * Are the items of @a prefix the first items of @a pidl?
+     *
+     * In other words, is @a prefix an ancestor of @a pidl if both are
+     * relative to the same folder.  A PIDL is a prefix of itself and NULL or
+     * empty PIDLs are a prefix of everything.
      */
-    basic_pidl& operator=(foreign_pidl_type raw_pidl)
+    template<typename T, typename U>
+    inline bool is_prefix_of(
+        const T __unaligned* prefix, const U __unaligned* pidl)
     {
-        basic_pidl copy(raw_pidl);
-        swap(copy);
-        return *this;
+        for (; !empty(prefix); prefix = next(prefix), pidl = next(pidl))
+        {
+            if (empty(pidl) || prefix->mkid.cb != pidl->mkid.cb ||
+                std::memcmp(prefix, pidl, prefix->mkid.cb) != 0)
+                return false;
+        }
+
+        return true;
     }
 
     /**
-     * Result of comparing with NULL.
+     * Number of bytes taken by the items two raw PIDLs have in common at
+     * their start.
+     *
+     * Items are compared whole, so the result always falls on an item
+     * boundary of both PIDLs and skipping that many bytes of either gives
+     * the first item where they differ.  The null-terminator is not
+     * counted.  NULL and empty PIDLs have nothing in common with anything.
      */
-    bool operator!() const
+    template<typename T, typename U>
+    inline size_t common_prefix_length(
+        const T __unaligned* lhs, const U __unaligned* rhs)
     {
-        return !m_pidl;
+        size_t length = 0;
+        for (; !empty(lhs) && !empty(rhs); lhs = next(lhs), rhs = next(rhs))
+        {
+            if (lhs->mkid.cb != rhs->mkid.cb ||
+                std::memcmp(lhs, rhs, lhs->mkid.cb) != 0)
+                break;
+
+            length += lhs->mkid.cb;
+        }
+
+        return length;
     }
+}
+
+template<typename T, typename Alloc>
+class basic_pidl;
+
+class pidl_view_iterator;
+
+template<typename T>
+class basic_pidl_index;
+
+namespace detail {
 
     /**
-     * Upcast operator.
-     * Will fail to compile unless it is legal to upcasting the underlying raw
-     * PIDL type to this PIDL's type.
+     * The null-terminator that empty views point to when asked for a
+     * terminated PIDL.
      */
-    template<typename U, typename AllocU>
-    operator basic_pidl<U, AllocU>() const
+    template<typename T>
+    struct empty_pidl
     {
-        return m_pidl;
-    }
+        static const SHITEMID terminator;
+    };
+
+    template<typename T>
+    const SHITEMID empty_pidl<T>::terminator = {0, {0}};
+}
+
+/**
+ * Non-owning view of the items of a PIDL.
+ *
+ * Takes the particular type of raw PIDL (child - ITEMID_CHILD, relative -
+ * ITEMIDLIST_RELATIVE or absolute - ITEMIDLIST_ABSOLUTE) as a template
+ * parameter in the same way as basic_pidl.
+ *
+ * A view is a pointer into an existing ITEMIDLIST and a byte length so,
+ * unlike basic_pidl, taking the last item, the parent or a prefix of a view
+ * never allocates.  The view does not own the memory it points to and is
+ * invalidated if the PIDL it is viewing is destroyed.  Only an explicit
+ * conversion back to a basic_pidl copies the items.
+ *
+ * Views created directly from a PIDL span the whole PIDL up to its
+ * null-terminator.  Views created from another view by parent() or
+ * prefix() are bounded by their length rather than by a null-terminator
+ * because the items that follow them in memory are still there.  Such views
+ * can be measured, compared and copied, but cannot be passed to functions
+ * expecting a raw PIDL (get() throws) as those functions would read past
+ * the end of the view.  Use is_terminated() to check.
+ *
+ * The offset of the last item is found when the view is created so
+ * last_item() is O(1).
+ */
+template<typename T>
+class basic_pidl_view
+{
+public:
+
+    typedef T value_type;
+    typedef const T __unaligned* const_pointer;
 
     /**
-     * Return underlying PIDL.
+     * View of nothing, equivalent to a NULL PIDL.
+     */
+    basic_pidl_view() :
+        m_pidl(NULL), m_size(0), m_last(0), m_terminated(true) {}
+
+    /**
+     * View the whole of a raw PIDL.
      *
-     * Returned const to prevent unexpected modification outside the wrapper.
+     * Walks the PIDL once to measure it.
      */
-    const T* get() const
+    basic_pidl_view(const T __unaligned* pidl) :
+        m_pidl(pidl), m_size(0), m_last(0), m_terminated(true)
     {
-        return m_pidl;
+        raw_pidl::traits<T>::type_check(pidl);
+        measure();
     }
 
     /**
-     * Return a pointer to the internal PIDL suitable for use as an
-     * out-parameter.
-     *
-     * The current PIDL, if any, is deallocated and set to NULL.
-     *
-     * @warning  The memory assigned to the PIDL by the caller must have been
-     * allocated with the SAME ALLOCATOR as used by the wrapper so that it can
-     * be destroyed in the wrapper's destructor.
+     * View the whole of a wrapped PIDL.
      */
-    T** out()
+    template<typename Alloc>
+    basic_pidl_view(const basic_pidl<T, Alloc>& pidl) :
+        m_pidl(pidl.get()), m_size(0), m_last(0), m_terminated(true)
     {
-        m_allocator.deallocate(m_pidl);
-        m_pidl = NULL;
-        return &m_pidl;
+        measure();
     }
 
     /**
-     * Clone internal PIDL as a raw PIDL.
+     * Upcast.
      *
-     * This is needed when returning a PIDL through a COM interface where the
-     * caller takes ownership.  I.e. where the parameter is PIDLIST rather
+     * Will fail to compile unless it is legal to upcast the underlying raw
+     * PIDL type.
+     */
+    template<typename U>
+    basic_pidl_view(const basic_pidl_view<U>& view) :
+        m_pidl(view.m_pidl), m_size(view.m_size), m_last(view.m_last),
+        m_terminated(view.m_terminated) {}
+
+    /**
+     * Result of comparing with NULL.
+     */
+    bool operator!() const
+    {
+        return !m_pidl;
+    }
+
+    /**
+     * The viewed PIDL as a raw PIDL.
+     *
+     * Empty views return a pointer to a null-terminator.
+     *
+     * @throws std::logic_error if the view is not followed by a
+     *         null-terminator in memory.
+     */
+    const_pointer get() const
+    {
+        if (!m_pidl)
+            return NULL;
+
+        if (m_size == 0)
+            return reinterpret_cast<const_pointer>(
+                &detail::empty_pidl<T>::terminator);
+
+        if (!m_terminated)
+            BOOST_THROW_EXCEPTION(
+                std::logic_error(
+                    "PIDL view is bounded and has no null-terminator"));
+
+        return m_pidl;
+    }
+
+    /**
+     * Address of the first viewed item whether or not it is terminated.
+     */
+    const_pointer data() const
+    {
+        return m_pidl;
+    }
+
+    /**
+     * Is the last viewed item followed by a null-terminator?
+     */
+    bool is_terminated() const
+    {
+        return m_terminated || m_size == 0;
+    }
+
+    /**
+     * The size, in bytes, of a PIDL holding the viewed items.
+     *
+     * This includes the null-terminator, matching basic_pidl::size(), even
+     * if the viewed memory itself isn't terminated.
+     */
+    size_t size() const
+    {
+        return (m_pidl) ? m_size + sizeof(m_pidl->mkid.cb) : 0;
+    }
+
+    /**
+     * Number of bytes taken by the viewed items (excluding any
+     * null-terminator).
+     */
+    size_t item_bytes() const
+    {
+        return m_size;
+    }
+
+    /**
+     * Is the view empty?
+     *
+     * Empty views are either NULL or have no items.
+     */
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    /**
+     * Number of items in the view.
+     */
+    size_t depth() const
+    {
+        size_t depth = 0;
+        for (size_t offset = 0; offset < m_size; offset += cb_at(offset))
+        {
+            ++depth;
+        }
+        return depth;
+    }
+
+    /**
+     * View of the last item.
+     *
+     * The item is terminated if this view is terminated.
+     */
+    basic_pidl_view<ITEMID_CHILD> last_item() const
+    {
+        if (empty())
+            BOOST_THROW_EXCEPTION(
+                std::logic_error("Empty PIDL cannot have a last item"));
+
+        return basic_pidl_view<ITEMID_CHILD>(
+            raw_pidl::skip(
+                reinterpret_cast<const ITEMID_CHILD __unaligned*>(m_pidl),
+                m_last),
+            m_size - m_last, 0, m_terminated);
+    }
+
+    /**
+     * View of all but the last item.
+     *
+     * The parent view is not terminated (unless it is empty).
+     */
+    basic_pidl_view parent() const
+    {
+        if (empty())
+            BOOST_THROW_EXCEPTION(
+                std::logic_error("Empty PIDL cannot have a parent"));
+
+        return bounded(m_last);
+    }
+
+    /**
+     * View of the first @a depth items.
+     *
+     * @throws std::out_of_range if the view has fewer items than that.
+     */
+    basic_pidl_view prefix(size_t depth) const
+    {
+        size_t offset = 0;
+        for (size_t i = 0; i < depth; ++i)
+        {
+            if (offset >= m_size)
+                BOOST_THROW_EXCEPTION(
+                    std::out_of_range("PIDL is not that deep"));
+
+            offset += cb_at(offset);
+        }
+
+        return bounded(offset);
+    }
+
+    /**
+     * Copy the viewed items into a newly-allocated, null-terminated PIDL.
+     */
+    template<typename Alloc>
+    T* clone() const
+    {
+        if (!m_pidl)
+            return NULL;
+
+        T* pidl = Alloc::allocate(size());
+        std::memcpy(pidl, m_pidl, m_size);
+        raw_pidl::skip(pidl, m_size)->mkid.cb = 0;
+
+        return pidl;
+    }
+
+private:
+
+    template<typename U>
+    friend class basic_pidl_view;
+    friend class pidl_view_iterator;
+    template<typename U>
+    friend class basic_pidl_index;
+
+    basic_pidl_view(
+        const T __unaligned* pidl, size_t size, size_t last, bool terminated)
+        : m_pidl(pidl), m_size(size), m_last(last), m_terminated(terminated)
+    {}
+
+    USHORT cb_at(size_t offset) const
+    {
+        return raw_pidl::skip(m_pidl, offset)->mkid.cb;
+    }
+
+    void measure()
+    {
+        if (!m_pidl)
+            return;
+
+        for (size_t offset = 0; cb_at(offset) != 0; offset += cb_at(offset))
+        {
+            m_last = offset;
+            m_size = offset + cb_at(offset);
+        }
+    }
+
+    /**
+     * View of the items in the first @a size bytes of this view.
+     */
+    basic_pidl_view bounded(size_t size) const
+    {
+        assert(size <= m_size);
+
+        size_t last = 0;
+        for (size_t offset = 0; offset < size; offset += cb_at(offset))
+        {
+            last = offset;
+        }
+
+        return basic_pidl_view(
+            m_pidl, size, last, m_terminated && size == m_size);
+    }
+
+    const T __unaligned* m_pidl;
+    size_t m_size; ///< Bytes used by items (excludes null-terminator)
+    size_t m_last; ///< Offset of the last item
+    bool m_terminated; ///< Is the last item followed by a null-terminator
+};
+
+/**
+ * @name Comparison
+ *
+ * Views are equal if they contain the same items byte-for-byte.  NULL and
+ * empty views are equal as both represent the desktop.
+ */
+// @{
+template<typename T, typename U>
+inline bool operator==(
+    const basic_pidl_view<T>& lhs, const basic_pidl_view<U>& rhs)
+{
+    return lhs.item_bytes() == rhs.item_bytes() &&
+        (lhs.empty() ||
+         std::memcmp(lhs.data(), rhs.data(), lhs.item_bytes()) == 0);
+}
+
+template<typename T, typename U>
+inline bool operator!=(
+    const basic_pidl_view<T>& lhs, const basic_pidl_view<U>& rhs)
+{
+    return !(lhs == rhs);
+}
+// @}
+
+/**
+ * Hash of a view's items.
+ *
+ * Matches the hash of a basic_pidl holding the same items so views can be
+ * used to look up PIDLs in hashed containers without cloning them.
+ */
+template<typename T>
+inline size_t hash_value(const basic_pidl_view<T>& view)
+{
+    detail::pidl_hasher hasher;
+
+    for (size_t offset = 0; offset < view.item_bytes(); )
+    {
+        const T __unaligned* item = raw_pidl::skip(view.data(), offset);
+        hasher.add_item(item, item->mkid.cb);
+        offset += item->mkid.cb;
+    }
+
+    return hasher.value();
+}
+
+namespace raw_pidl {
+
+    /**
+     * View of the items of @a pidl that follow @a root.
+     *
+     * Nothing is allocated: the view points into @a pidl.  Copy it into a
+     * basic_pidl, which allocates exactly once, if it needs to outlive
+     * @a pidl.  NULL and empty roots give a view of the whole PIDL.
+     *
+     * @throws std::invalid_argument if @a root is not a prefix of @a pidl.
+     */
+    template<typename T, typename U>
+    inline basic_pidl_view<ITEMIDLIST_RELATIVE> relative_to(
+        const T __unaligned* pidl, const U __unaligned* root)
+    {
+        size_t common = common_prefix_length(pidl, root);
+        if (!empty(skip(root, common)))
+            BOOST_THROW_EXCEPTION(
+                std::invalid_argument("PIDL is not below the given root"));
+
+        return basic_pidl_view<ITEMIDLIST_RELATIVE>(
+            reinterpret_cast<const ITEMIDLIST_RELATIVE __unaligned*>(
+                skip(pidl, common)));
+    }
+
+    /**
+     * Move a PIDL from under one root to another.
+     *
+     * Replaces the items of @a old_root at the start of @a pidl with the
+     * items of @a new_root.  The source PIDLs are each walked once and the
+     * result is allocated exactly once, using the given allocator.  As
+     * with combine(), the result type is that of appending to @a new_root.
+     *
+     * @retval NULL  If @a pidl and @a new_root are both NULL.
+     *
+     * @throws std::invalid_argument if @a old_root is not a prefix of
+     *         @a pidl.
+     */
+    template<typename Alloc, typename T, typename U, typename V>
+    inline typename traits<V>::combine_pidl_type rebase(
+        const T __unaligned* pidl, const U __unaligned* old_root,
+        const V __unaligned* new_root)
+    {
+        typedef typename traits<V>::combine_type return_item_type;
+        typedef typename Alloc::template rebind<return_item_type>::other
+            allocator_type;
+
+        basic_pidl_view<ITEMIDLIST_RELATIVE> tail =
+            relative_to(pidl, old_root);
+
+        if (!pidl && !new_root)
+            return NULL;
+
+        size_t root_bytes = size(new_root);
+        if (root_bytes)
+            root_bytes -= sizeof(new_root->mkid.cb);
+
+        size_t items = root_bytes + tail.item_bytes();
+        typename traits<V>::combine_pidl_type mem =
+            allocator_type::allocate(items + sizeof(new_root->mkid.cb));
+
+        if (root_bytes)
+            std::memcpy(mem, new_root, root_bytes);
+        if (!tail.empty())
+            std::memcpy(skip(mem, root_bytes), tail.data(), tail.item_bytes());
+        skip(mem, items)->mkid.cb = 0;
+
+        return mem;
+    }
+}
+
+/**
+ * Templated PIDL wrapper class.
+ *
+ * Takes the particular type of raw PIDL (e.g. child - ITEMID_CHILD,
+ * relative - ITEMIDLIST_RELATIVE or absolute ITEMIDLIST_ABSOLUTE) as a
+ * template parameter, T, ensuring that the operations remain safe with
+ * respect to the underlying PIDL type.
+ *
+ * The template also takes a parameter, Alloc, which specifies an allocator
+ * to use when creating new PIDLs.  This allows us to use new & delete rather
+ * than the COM allocator (the usual allocator for PIDLs) when testing so that
+ * we can detect memory leaks.
+ *
+ * PIDLs being copied from elsewhere are always treated as unaligned because
+ * they may be part way through a larger ITEMIDLIST. Although there may be a
+ * performance disadvantage in the case where we are sure the incoming pointer
+ * is aligned, it is negligible because aligned child PIDLs are small and
+ * aligned absolute PIDLs will have to be treated as unaligned from the second
+ * item in the list onwards.  Relative PIDLs should always be treated as
+ * unaligned.
+ */
+template<typename T, typename Alloc>
+class basic_pidl
+{
+public:
+
+    typedef T                                                     value_type;
+    typedef T*                                                    pointer;
+    typedef const T*                                              const_pointer;
+    typedef Alloc                                                 allocator;
+    typedef typename raw_pidl::traits<T>::combine_type            join_type;
+    typedef typename raw_pidl::traits<T>::combine_pidl_type       join_pidl_type;
+    typedef typename allocator::template rebind<join_type>::other join_allocator;
+    typedef basic_pidl<join_type, join_allocator>                 join_pidl;
+    typedef typename raw_pidl::traits<T>::clone_pidl_type         foreign_pidl_type;
+
+    basic_pidl() : m_pidl(NULL), m_allocator(Alloc()) {}
+
+    ~basic_pidl() throw()
+    {
+        m_allocator.deallocate(m_pidl);
+    }
+
+    /**
+     * Copy construction.
+     */
+    basic_pidl(const basic_pidl& pidl) :
+        m_pidl(raw_pidl::clone<Alloc>(pidl.m_pidl)) {}
+
+#if (BOOST_VERSION >= 104800)
+
+    /**
+     * Move construction.
+     *
+     * Takes over the other wrapper's PIDL without copying it.  The other
+     * wrapper is left holding NULL.
+     *
+     * Never throws, so containers move rather than copy basic_pidls when
+     * they grow.
+     */
+    basic_pidl(BOOST_RV_REF(basic_pidl) pidl) throw() :
+        m_pidl(pidl.m_pidl), m_allocator(pidl.m_allocator)
+    {
+        pidl.m_pidl = NULL;
+    }
+
+#endif
+
+    /**
+     * Construct by copying a raw PIDL.
+     */
+    basic_pidl(const __unaligned T* raw_pidl) :
+        m_pidl(raw_pidl::type_checked_clone<Alloc>(raw_pidl)) {}
+
+    /**
+     * Construct by copying a raw PIDL that has already been validated.
+     *
+     * The measurement from raw_pidl::validate gives the size of the PIDL so
+     * it is copied without being walked again.
+     */
+    basic_pidl(
+        const __unaligned T* pidl, const raw_pidl::measurement& measured) :
+        m_pidl(raw_pidl::clone<Alloc>(pidl, measured.size)) {}
+
+    /**
+     * Construct by copying the items of a PIDL view.
+     */
+    explicit basic_pidl(const basic_pidl_view<T>& view) :
+        m_pidl(view.template clone<Alloc>()) {}
+
+    /**
+     * Copy assignment.
+     */
+#if (BOOST_VERSION >= 104800)
+    basic_pidl& operator=(BOOST_COPY_ASSIGN_REF(basic_pidl) pidl)
+#else
+    basic_pidl& operator=(const basic_pidl& pidl)
+#endif
+    {
+        basic_pidl copy(pidl);
+        swap(copy);
+        return *this;
+    }
+
+#if (BOOST_VERSION >= 104800)
+
+    /**
+     * Move assignment.
+     *
+     * The PIDL previously held by this wrapper is deallocated and replaced
+     * by the other wrapper's PIDL without copying.
+     */
+    basic_pidl& operator=(BOOST_RV_REF(basic_pidl) pidl) throw()
+    {
+        basic_pidl moved(boost::move(pidl));
+        swap(moved);
+        return *this;
+    }
+
+#endif
+
+    /**
+     * Upcasting assignment.
+     *
+     * Will fail to compile unless it is legal to upcast the other wrapper's
+     * PIDL type to this PIDL's type.  Needed as well as the upcast operator
+     * because, with emulated moves, assignment can't convert the other
+     * wrapper implicitly.
+     */
+    template<typename U, typename AllocU>
+    typename boost::disable_if<
+        boost::is_same<basic_pidl<U, AllocU>, basic_pidl>, basic_pidl&>::type
+    operator=(const basic_pidl<U, AllocU>& pidl)
+    {
+        basic_pidl copy = pidl;
+        swap(copy);
+        return *this;
+    }
+
+    /**
+     * Copy a raw PIDL into this wrapper instance.
+     */
+    basic_pidl& operator=(foreign_pidl_type raw_pidl)
+    {
+        basic_pidl copy(raw_pidl);
+        swap(copy);
+        return *this;
+    }
+
+    /**
+     * Result of comparing with NULL.
+     */
+    bool operator!() const
+    {
+        return !m_pidl;
+    }
+
+    /**
+     * Upcast operator.
+     * Will fail to compile unless it is legal to upcasting the underlying raw
+     * PIDL type to this PIDL's type.
+     */
+    template<typename U, typename AllocU>
+    operator basic_pidl<U, AllocU>() const
+    {
+        return m_pidl;
+    }
+
+    /**
+     * Return underlying PIDL.
+     *
+     * Returned const to prevent unexpected modification outside the wrapper.
+     */
+    const T* get() const
+    {
+        return m_pidl;
+    }
+
+    /**
+     * Return a pointer to the internal PIDL suitable for use as an
+     * out-parameter.
+     *
+     * The current PIDL, if any, is deallocated and set to NULL.
+     *
+     * @warning  The memory assigned to the PIDL by the caller must have been
+     * allocated with the SAME ALLOCATOR as used by the wrapper so that it can
+     * be destroyed in the wrapper's destructor.
+     */
+    T** out()
+    {
+        m_allocator.deallocate(m_pidl);
+        m_pidl = NULL;
+        return &m_pidl;
+    }
+
+    /**
+     * Clone internal PIDL as a raw PIDL.
+     *
+     * This is needed when returning a PIDL through a COM interface where the
+     * caller takes ownership.  I.e. where the parameter is PIDLIST rather
      * than PCIDLIST.
      *
      * The output pidl type is a template parameter to allow upcasting.  This
@@ -527,7 +1428,7 @@ public:
     template<typename U>
     void copy_to(U*& raw_pidl) const
     {
-        raw_pidl = typename raw_pidl::clone<Alloc>(m_pidl);
+        raw_pidl = raw_pidl::clone<Alloc>(m_pidl);
     }
 
     /**
@@ -595,7 +1496,8 @@ public:
                 std::logic_error("Empty PIDL cannot have a last item"));
 
         return basic_pidl<
-            ITEMID_CHILD, typename allocator::rebind<ITEMID_CHILD>::other>(
+            ITEMID_CHILD,
+            typename allocator::template rebind<ITEMID_CHILD>::other>(
                 raw_pidl::last(m_pidl));
     }
 
@@ -608,16 +1510,9 @@ public:
             BOOST_THROW_EXCEPTION(
                 std::logic_error("Empty PIDL cannot have a parent"));
 
-        basic_pidl copy(*this);
-
-        // Force-terminate the copy's last item, then re-clone to get
-        // clean version
-
-        const ITEMID_CHILD __unaligned* last = raw_pidl::last(copy.m_pidl);
-
-        const_cast<ITEMID_CHILD __unaligned*>(last)->mkid.cb = 0;
-
-        return copy;
+        // Copy only the parent's items rather than copying the whole PIDL
+        // and then terminating it early
+        return basic_pidl(basic_pidl_view<T>(m_pidl).parent());
     }
 
     /**
@@ -637,6 +1532,11 @@ public:
     }
 
 private:
+
+#if (BOOST_VERSION >= 104800)
+    BOOST_COPYABLE_AND_MOVABLE(basic_pidl)
+#endif
+
     T* m_pidl;
     Alloc m_allocator;
 };
@@ -658,11 +1558,12 @@ template<typename T, typename U, typename Alloc, typename AllocU>
 inline typename basic_pidl<T, Alloc>::join_pidl operator+(
     const basic_pidl<T, Alloc>& lhs, const basic_pidl<U, AllocU>& rhs)
 {
-    typedef basic_pidl<T, Alloc>::join_pidl result_type;
+    typedef typename basic_pidl<T, Alloc>::join_pidl result_type;
 
-    typename result_type pidl;
+    result_type pidl;
     pidl.attach(
-        raw_pidl::combine<result_type::allocator>(lhs.get(), rhs.get()));
+        raw_pidl::combine<typename result_type::allocator>(
+            lhs.get(), rhs.get()));
     return pidl;
 }
 
@@ -670,18 +1571,32 @@ template<typename T, typename U, typename Alloc>
 inline typename basic_pidl<T, Alloc>::join_pidl operator+(
     const basic_pidl<T, Alloc>& lhs, const U __unaligned* rhs)
 {
-    typedef basic_pidl<U, basic_pidl<T, Alloc>::allocator::rebind<U>::other>
-        wrapped_type;
-    return lhs + wrapped_type(rhs);
+    typedef typename basic_pidl<T, Alloc>::join_pidl result_type;
+
+    // Combining straight from the raw PIDL avoids wrapping (and therefore
+    // cloning) it first
+    raw_pidl::traits<U>::type_check(rhs);
+
+    result_type pidl;
+    pidl.attach(
+        raw_pidl::combine<typename result_type::allocator>(lhs.get(), rhs));
+    return pidl;
 }
 
 template<typename T, typename U, typename Alloc>
 inline typename basic_pidl<T, Alloc>::join_pidl operator+(
     const U __unaligned* lhs, const basic_pidl<T, Alloc>& rhs)
 {
-    typedef basic_pidl<U, basic_pidl<T, Alloc>::allocator::rebind<U>::other>
-        wrapped_type;
-    return wrapped_type(lhs) + rhs;
+    typedef typename basic_pidl<T, Alloc>::allocator::template rebind<U>::other
+        lhs_allocator;
+    typedef typename basic_pidl<U, lhs_allocator>::join_pidl result_type;
+
+    raw_pidl::traits<U>::type_check(lhs);
+
+    result_type pidl;
+    pidl.attach(
+        raw_pidl::combine<typename result_type::allocator>(lhs, rhs.get()));
+    return pidl;
 }
 // @}
 
@@ -703,7 +1618,10 @@ template<typename T, typename U, typename Alloc, typename AllocU>
 inline basic_pidl<T, Alloc>& operator+=(
     basic_pidl<T, Alloc>& lhs, const basic_pidl<U, AllocU>& rhs)
 {
-    lhs = lhs + rhs;
+    // Swapping in the joined PIDL, rather than assigning it, hands over its
+    // memory instead of cloning it again
+    basic_pidl<T, Alloc> joined = lhs + rhs;
+    lhs.swap(joined);
     return lhs;
 }
 
@@ -711,11 +1629,155 @@ template<typename T, typename U, typename Alloc>
 inline basic_pidl<T, Alloc>& operator+=(
     basic_pidl<T, Alloc>& lhs, const U* rhs)
 {
-    lhs = lhs + rhs;
+    basic_pidl<T, Alloc> joined = lhs + rhs;
+    lhs.swap(joined);
     return lhs;
 }
 //@}
 
+namespace detail {
+
+    /**
+     * @name Items to join
+     *
+     * View of something that may be appended to a PIDL, whether it is a raw
+     * PIDL, a view or a wrapper with a get() method.
+     *
+     * These will fail to compile if given an absolute PIDL.
+     */
+    // @{
+    template<typename U>
+    inline basic_pidl_view<ITEMIDLIST_RELATIVE> appendable_view(
+        const U __unaligned* pidl)
+    {
+        BOOST_STATIC_ASSERT(raw_pidl::traits<U>::is_appendable);
+        raw_pidl::traits<U>::type_check(pidl);
+
+        return basic_pidl_view<ITEMIDLIST_RELATIVE>(pidl);
+    }
+
+    template<typename U>
+    inline basic_pidl_view<ITEMIDLIST_RELATIVE> appendable_view(U* pidl)
+    {
+        return appendable_view(static_cast<const U*>(pidl));
+    }
+
+    template<typename U>
+    inline basic_pidl_view<ITEMIDLIST_RELATIVE> appendable_view(
+        const basic_pidl_view<U>& view)
+    {
+        BOOST_STATIC_ASSERT(raw_pidl::traits<U>::is_appendable);
+
+        return view;
+    }
+
+    template<typename P>
+    inline basic_pidl_view<ITEMIDLIST_RELATIVE> appendable_view(
+        const P& wrapped_pidl)
+    {
+        BOOST_STATIC_ASSERT(
+            raw_pidl::traits<typename P::value_type>::is_appendable);
+
+        return basic_pidl_view<ITEMIDLIST_RELATIVE>(wrapped_pidl.get());
+    }
+    // @}
+}
+
+/**
+ * @name Bulk joining
+ *
+ * Join one parent PIDL to each of a range of PIDLs, such as the children
+ * of a folder.
+ *
+ * Using @c + for each child walks the parent again for every child.  These
+ * measure the parent once and then allocate each result at its exact size
+ * with a single allocation.  The results are appended to @a joined, which
+ * grows once to fit them all.  Neither the new elements, which start out
+ * NULL, nor the PIDLs already in @a joined, which are swapped into the
+ * larger storage, are cloned, even where the compiler can't move them.
+ *
+ * The range must allow more than one pass (forward iterators) and may hold
+ * raw PIDLs, views or wrapped PIDLs.  Parent views need not be terminated,
+ * so a view of the first few items of a longer PIDL can be the parent.  NULL
+ * parents and children are treated as empty.
+ *
+ * If a child turns out to be invalid, the exception propagates and
+ * @a joined is left as it was.
+ *
+ * The templates will fail to compile if the range holds absolute PIDLs.
+ */
+// @{
+template<typename T, typename U, typename Alloc, typename It>
+inline void join_all(
+    const basic_pidl_view<T>& parent, It first, It last,
+    std::vector< basic_pidl<U, Alloc> >& joined)
+{
+    typedef typename raw_pidl::traits<T>::combine_type join_type;
+    BOOST_STATIC_ASSERT((boost::is_convertible<join_type*, U*>::value));
+
+    size_t parent_bytes = parent.item_bytes();
+    size_t start = joined.size();
+    size_t size = start + std::distance(first, last);
+
+    if (size > joined.capacity())
+    {
+        // Growing in place would copy the existing PIDLs without C++11
+        std::vector< basic_pidl<U, Alloc> > grown;
+        grown.reserve(size);
+        grown.resize(start);
+        for (size_t i = 0; i < start; ++i)
+        {
+            grown[i].swap(joined[i]);
+        }
+        joined.swap(grown);
+    }
+    joined.resize(size);
+
+    try
+    {
+        for (size_t i = start; first != last; ++first, ++i)
+        {
+            basic_pidl_view<ITEMIDLIST_RELATIVE> child =
+                detail::appendable_view(*first);
+            size_t child_bytes = child.item_bytes();
+
+            U* pidl = Alloc::allocate(
+                parent_bytes + child_bytes + sizeof(pidl->mkid.cb));
+            if (parent_bytes)
+                std::memcpy(pidl, parent.data(), parent_bytes);
+            if (child_bytes)
+                std::memcpy(
+                    raw_pidl::skip(pidl, parent_bytes), child.data(),
+                    child_bytes);
+            raw_pidl::skip(pidl, parent_bytes + child_bytes)->mkid.cb = 0;
+
+            joined[i].attach(pidl);
+        }
+    }
+    catch (...)
+    {
+        joined.resize(start);
+        throw;
+    }
+}
+
+template<typename T, typename AllocT, typename U, typename Alloc, typename It>
+inline void join_all(
+    const basic_pidl<T, AllocT>& parent, It first, It last,
+    std::vector< basic_pidl<U, Alloc> >& joined)
+{
+    join_all(basic_pidl_view<T>(parent), first, last, joined);
+}
+
+template<typename T, typename U, typename Alloc, typename It>
+inline void join_all(
+    const T __unaligned* parent, It first, It last,
+    std::vector< basic_pidl<U, Alloc> >& joined)
+{
+    join_all(basic_pidl_view<T>(parent), first, last, joined);
+}
+// @}
+
 /**
  * No-fail swap.
  */
@@ -727,12 +1789,52 @@ inline void swap(
 }
 
 /**
- * Explicit downcast.
+ * @name Comparison
+ *
+ * Wrapped PIDLs are equal if their items are the same byte-for-byte,
+ * regardless of how they were allocated, and are ordered as defined by
+ * raw_pidl::compare.  NULL and empty PIDLs are equal.
  */
-template<typename T, typename U, typename Alloc>
-inline T pidl_cast(const basic_pidl<U, Alloc>& pidl)
+// @{
+template<typename T, typename Alloc, typename AllocU>
+inline bool operator==(
+    const basic_pidl<T, Alloc>& lhs, const basic_pidl<T, AllocU>& rhs)
 {
-    return pidl_cast<T>(pidl.get());
+    return raw_pidl::equal(lhs.get(), rhs.get());
+}
+
+template<typename T, typename Alloc, typename AllocU>
+inline bool operator!=(
+    const basic_pidl<T, Alloc>& lhs, const basic_pidl<T, AllocU>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template<typename T, typename Alloc, typename AllocU>
+inline bool operator<(
+    const basic_pidl<T, Alloc>& lhs, const basic_pidl<T, AllocU>& rhs)
+{
+    return raw_pidl::less(lhs.get(), rhs.get());
+}
+// @}
+
+/**
+ * Is @a prefix an ancestor of, or the same as, @a pidl?
+ */
+template<typename T, typename U, typename Alloc, typename AllocU>
+inline bool is_prefix_of(
+    const basic_pidl<T, Alloc>& prefix, const basic_pidl<U, AllocU>& pidl)
+{
+    return raw_pidl::is_prefix_of(prefix.get(), pidl.get());
+}
+
+/**
+ * Hash of a wrapped PIDL's items for use with boost::hash.
+ */
+template<typename T, typename Alloc>
+inline size_t hash_value(const basic_pidl<T, Alloc>& pidl)
+{
+    return raw_pidl::hash(pidl.get());
 }
 
 /**
@@ -741,7 +1843,16 @@ inline T pidl_cast(const basic_pidl<U, Alloc>& pidl)
 template<typename T, typename U>
 inline T pidl_cast(const U* raw_pidl)
 {
-    return static_cast<T::const_pointer>(raw_pidl);
+    return static_cast<typename T::const_pointer>(raw_pidl);
+}
+
+/**
+ * Explicit downcast.
+ */
+template<typename T, typename U, typename Alloc>
+inline T pidl_cast(const basic_pidl<U, Alloc>& pidl)
+{
+    return pidl_cast<T>(pidl.get());
 }
 
 /**
@@ -757,6 +1868,43 @@ typedef basic_pidl<
 typedef basic_pidl<ITEMID_CHILD, cotaskmem_alloc<ITEMID_CHILD> > cpidl_t;
 // @}
 
+/**
+ * @name  Standard shell PIDL view types.
+ */
+// @{
+typedef basic_pidl_view<ITEMIDLIST_RELATIVE> pidl_view;
+typedef basic_pidl_view<ITEMIDLIST_ABSOLUTE> apidl_view;
+typedef basic_pidl_view<ITEMID_CHILD> cpidl_view;
+// @}
+
 }}} // namespace washer::shell::pidl
 
+#if !defined(BOOST_NO_CXX11_HDR_FUNCTIONAL) && \
+    !defined(BOOST_NO_0X_HDR_FUNCTIONAL)
+
+namespace std {
+
+    template<typename T, typename Alloc>
+    struct hash< washer::shell::pidl::basic_pidl<T, Alloc> >
+    {
+        size_t operator()(
+            const washer::shell::pidl::basic_pidl<T, Alloc>& pidl) const
+        {
+            return washer::shell::pidl::hash_value(pidl);
+        }
+    };
+
+    template<typename T>
+    struct hash< washer::shell::pidl::basic_pidl_view<T> >
+    {
+        size_t operator()(
+            const washer::shell::pidl::basic_pidl_view<T>& view) const
+        {
+            return washer::shell::pidl::hash_value(view);
+        }
+    };
+}
+
+#endif
+
 #endif
@@ -33,7 +33,16 @@
 #define WASHER_SHELL_PIDL_ARRAY_HPP
 #pragma once
 
+#include <washer/shell/pidl.hpp> // basic_pidl_view, raw_pidl
+
+#include <boost/version.hpp>
+#if (BOOST_VERSION >= 104800)
+#include <boost/move/move.hpp> // BOOST_RV_REF, BOOST_COPYABLE_AND_MOVABLE
+#endif
+
 #include <algorithm>  // swap, transform
+#include <cstring> // memcpy
+#include <iterator> // distance
 #include <vector>
 
 namespace washer {
@@ -55,9 +64,34 @@ namespace detail {
         std::vector<typename It::value_type::const_pointer> array;
         transform(
             begin, end, back_inserter(array),
-            raw_pidl_from_wrapper<It::value_type>);
+            raw_pidl_from_wrapper<typename It::value_type>);
         return array;
     }
+
+    /**
+     * @name Packed array items
+     *
+     * The items to pack from the various ways a collection might hold them.
+     */
+    // @{
+    template<typename T, typename P>
+    basic_pidl_view<T> packed_item(const P& wrapped_pidl)
+    {
+        return basic_pidl_view<T>(wrapped_pidl.get());
+    }
+
+    template<typename T, typename U>
+    basic_pidl_view<T> packed_item(U* raw_pidl)
+    {
+        return basic_pidl_view<T>(raw_pidl);
+    }
+
+    template<typename T, typename U>
+    basic_pidl_view<T> packed_item(const basic_pidl_view<U>& view)
+    {
+        return view;
+    }
+    // @}
 }
 
 /**
@@ -85,13 +119,41 @@ public:
     pidl_array(const pidl_array& a) :
         m_array(a.m_array) {}
 
+#if (BOOST_VERSION >= 104800)
+    pidl_array& operator=(BOOST_COPY_ASSIGN_REF(pidl_array) a)
+#else
     pidl_array& operator=(const pidl_array& a)
+#endif
     {
         pidl_array copy(a);
         swap(copy);
         return *this;
     }
 
+#if (BOOST_VERSION >= 104800)
+
+    /**
+     * Move construction.
+     *
+     * Takes over the other array's storage without copying it.
+     */
+    pidl_array(BOOST_RV_REF(pidl_array) a) throw()
+    {
+        swap(a);
+    }
+
+    /**
+     * Move assignment.
+     */
+    pidl_array& operator=(BOOST_RV_REF(pidl_array) a) throw()
+    {
+        pidl_array moved(boost::move(a));
+        swap(moved);
+        return *this;
+    }
+
+#endif
+
     /**
      * Return a pointer to the array.
      */
@@ -117,9 +179,262 @@ public:
     }
 
 private:
+
+#if (BOOST_VERSION >= 104800)
+    BOOST_COPYABLE_AND_MOVABLE(pidl_array)
+#endif
+
+    pidl_array() {}
+
     std::vector<value_type> m_array;
 };
 
+/**
+ * Array of PIDLs that owns copies of them in a single block of memory.
+ *
+ * Unlike pidl_array, which points into PIDLs owned elsewhere, this copies
+ * every PIDL into one arena laid out as the table of pointers followed by
+ * the PIDLs themselves, each with its own null-terminator.  Passing a large
+ * selection to methods such as IShellFolder::GetUIObjectOf then touches one
+ * contiguous block instead of one block per PIDL, and the array can outlive
+ * the collection it was built from.
+ *
+ * Building the array measures every PIDL first so that the arena is
+ * allocated exactly once.  The source iterators must therefore allow more
+ * than one pass (forward iterators).  They can yield raw PIDLs, views or any
+ * wrapper with a get() method such as basic_pidl.
+ */
+template<typename T, typename Alloc>
+class basic_packed_pidl_array
+{
+    typedef typename Alloc::template rebind<BYTE>::other arena_allocator;
+
+public:
+
+    typedef typename raw_pidl::traits<T>::clone_pidl_type value_type;
+    typedef const value_type* const_iterator;
+
+    /**
+     * An empty array.
+     */
+    basic_packed_pidl_array() : m_arena(NULL), m_size(0), m_bytes(0) {}
+
+    /**
+     * Copy the PIDLs in the range into a new array.
+     */
+    template<typename It>
+    basic_packed_pidl_array(It begin, It end)
+        : m_arena(NULL), m_size(0), m_bytes(0)
+    {
+        size_t count = std::distance(begin, end);
+        size_t bytes = count * sizeof(value_type);
+        for (It it = begin; it != end; ++it)
+        {
+            bytes += detail::packed_item<T>(*it).item_bytes() + terminator_size;
+        }
+
+        if (count == 0)
+            return;
+
+        BYTE* arena = arena_allocator::allocate(bytes);
+        try
+        {
+            value_type* table = reinterpret_cast<value_type*>(arena);
+            BYTE* next = arena + count * sizeof(value_type);
+            for (It it = begin; it != end; ++it, ++table)
+            {
+                basic_pidl_view<T> item = detail::packed_item<T>(*it);
+
+                std::memcpy(next, item.data(), item.item_bytes());
+                write_terminator(next + item.item_bytes());
+
+                *table = reinterpret_cast<value_type>(next);
+                next += item.item_bytes() + terminator_size;
+            }
+        }
+        catch (...)
+        {
+            arena_allocator::deallocate(arena);
+            throw;
+        }
+
+        m_arena = arena;
+        m_size = count;
+        m_bytes = bytes;
+    }
+
+    ~basic_packed_pidl_array() throw()
+    {
+        arena_allocator::deallocate(m_arena);
+    }
+
+    /**
+     * Copy construction.
+     *
+     * Copies the whole arena in one go and repoints the copy's table into
+     * its own arena.
+     */
+    basic_packed_pidl_array(const basic_packed_pidl_array& a)
+        : m_arena(NULL), m_size(0), m_bytes(0)
+    {
+        if (!a.m_arena)
+            return;
+
+        m_arena = arena_allocator::allocate(a.m_bytes);
+        std::memcpy(m_arena, a.m_arena, a.m_bytes);
+        m_size = a.m_size;
+        m_bytes = a.m_bytes;
+
+        value_type* table = reinterpret_cast<value_type*>(m_arena);
+        for (size_t i = 0; i < m_size; ++i)
+        {
+            table[i] = reinterpret_cast<value_type>(m_arena + a.offset(i));
+        }
+    }
+
+#if (BOOST_VERSION >= 104800)
+    basic_packed_pidl_array& operator=(
+        BOOST_COPY_ASSIGN_REF(basic_packed_pidl_array) a)
+#else
+    basic_packed_pidl_array& operator=(const basic_packed_pidl_array& a)
+#endif
+    {
+        basic_packed_pidl_array copy(a);
+        swap(copy);
+        return *this;
+    }
+
+#if (BOOST_VERSION >= 104800)
+
+    /**
+     * Move construction.
+     *
+     * Takes over the other array's arena without copying it.
+     */
+    basic_packed_pidl_array(BOOST_RV_REF(basic_packed_pidl_array) a) throw()
+        : m_arena(NULL), m_size(0), m_bytes(0)
+    {
+        swap(a);
+    }
+
+    /**
+     * Move assignment.
+     */
+    basic_packed_pidl_array& operator=(
+        BOOST_RV_REF(basic_packed_pidl_array) a) throw()
+    {
+        basic_packed_pidl_array moved;
+        moved.swap(a);
+        swap(moved);
+        return *this;
+    }
+
+#endif
+
+    /**
+     * Return a pointer to the array.
+     *
+     * For child PIDLs this is a PCUITEMID_CHILD_ARRAY.
+     */
+    const value_type* as_array() const
+    {
+        return reinterpret_cast<const value_type*>(m_arena);
+    }
+
+    /**
+     * The PIDL at the given position.
+     */
+    value_type operator[](size_t i) const
+    {
+        return as_array()[i];
+    }
+
+    const_iterator begin() const
+    {
+        return as_array();
+    }
+
+    const_iterator end() const
+    {
+        return as_array() + m_size;
+    }
+
+    /**
+     * Number of PIDLs in the array.
+     */
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    /**
+     * Offset of the given PIDL from the start of the arena in bytes.
+     */
+    size_t offset(size_t i) const
+    {
+        return reinterpret_cast<const BYTE __unaligned*>(as_array()[i]) -
+            m_arena;
+    }
+
+    /**
+     * Size of the arena in bytes, including the pointer table.
+     */
+    size_t bytes() const
+    {
+        return m_bytes;
+    }
+
+    /**
+     * No-fail swap.
+     */
+    void swap(basic_packed_pidl_array& a) throw()
+    {
+        std::swap(a.m_arena, m_arena);
+        std::swap(a.m_size, m_size);
+        std::swap(a.m_bytes, m_bytes);
+    }
+
+private:
+
+#if (BOOST_VERSION >= 104800)
+    BOOST_COPYABLE_AND_MOVABLE(basic_packed_pidl_array)
+#endif
+
+    static const size_t terminator_size = sizeof(USHORT);
+
+    static void write_terminator(BYTE* location)
+    {
+        const USHORT terminator = 0;
+        std::memcpy(location, &terminator, sizeof(terminator));
+    }
+
+    BYTE* m_arena; ///< Pointer table followed by the PIDLs
+    size_t m_size; ///< Number of PIDLs
+    size_t m_bytes; ///< Size of the arena
+};
+
+/**
+ * No-fail swap.
+ */
+template<typename T, typename Alloc>
+inline void swap(
+    basic_packed_pidl_array<T, Alloc>& a, basic_packed_pidl_array<T, Alloc>& b)
+    throw()
+{
+    a.swap(b);
+}
+
+/**
+ * Packed array of child PIDLs, such as a selection in a folder view.
+ */
+typedef basic_packed_pidl_array<ITEMID_CHILD, cotaskmem_alloc<ITEMID_CHILD> >
+    packed_pidl_array;
+
 }}} // namespace washer::shell::pidl
 
 #endif
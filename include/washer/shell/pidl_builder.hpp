@@ -0,0 +1,296 @@
+/**
+    @file
+
+    Incremental PIDL construction.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_PIDL_BUILDER_HPP
+#define WASHER_SHELL_PIDL_BUILDER_HPP
+#pragma once
+
+#include <washer/shell/pidl.hpp> // basic_pidl, raw_pidl, cotaskmem_alloc
+
+#include <boost/noncopyable.hpp> // noncopyable
+#include <boost/static_assert.hpp> // BOOST_STATIC_ASSERT
+#include <boost/type_traits/is_same.hpp> // is_same
+#include <boost/utility/enable_if.hpp> // enable_if_c
+
+#include <algorithm> // max
+#include <cassert> // assert
+#include <cstring> // memcpy
+
+namespace washer {
+namespace shell {
+namespace pidl {
+
+/**
+ * Builds up a PIDL one item (or sub-list) at a time.
+ *
+ * Joining PIDLs with basic_pidl's @c += allocates a new PIDL the exact
+ * size of the result and measures both operands on every append, so
+ * building a deep PIDL one level at a time is quadratic.  This builder
+ * instead caches the length of the PIDL built so far and grows its buffer
+ * geometrically, making each append cost amortised O(size of appended
+ * PIDL).
+ *
+ * The buffer is allocated with the same allocator as the basic_pidl it
+ * produces, so release() hands the buffer over to a basic_pidl without
+ * copying it.  That PIDL may therefore have unused memory after its
+ * null-terminator, which basic_pidl allows.
+ *
+ * Child PIDLs cannot be built this way as appending to a child results in a
+ * relative PIDL.
+ */
+template<typename T, typename Alloc>
+class basic_pidl_builder : private boost::noncopyable
+{
+    BOOST_STATIC_ASSERT((!boost::is_same<T, ITEMID_CHILD>::value));
+
+public:
+
+    typedef T value_type;
+    typedef Alloc allocator;
+    typedef basic_pidl<T, Alloc> pidl_type;
+
+    /**
+     * Start with nothing.
+     *
+     * No memory is allocated until something is appended.  Releasing a
+     * builder in this state gives a NULL PIDL.
+     */
+    basic_pidl_builder() : m_pidl(NULL), m_size(0), m_capacity(0) {}
+
+    /**
+     * Start by copying the given PIDL.
+     */
+    explicit basic_pidl_builder(const T __unaligned* root)
+        : m_pidl(NULL), m_size(0), m_capacity(0)
+    {
+        append_bytes(root, raw_pidl::size(root));
+    }
+
+    /**
+     * Start by copying the given wrapped PIDL.
+     */
+    template<typename AllocU>
+    explicit basic_pidl_builder(const basic_pidl<T, AllocU>& root)
+        : m_pidl(NULL), m_size(0), m_capacity(0)
+    {
+        append_bytes(root.get(), root.size());
+    }
+
+    ~basic_pidl_builder() throw()
+    {
+        Alloc::deallocate(m_pidl);
+    }
+
+    /**
+     * Make sure the buffer can hold a PIDL of at least the given size, in
+     * bytes including the null-terminator, without reallocating.
+     */
+    void reserve(size_t size)
+    {
+        if (size > m_capacity)
+            reallocate(size);
+    }
+
+    /**
+     * Append a raw PIDL.
+     *
+     * Will fail to compile if used to append an absolute PIDL.
+     */
+    template<typename U>
+    typename boost::enable_if_c<
+        raw_pidl::traits<U>::is_appendable, basic_pidl_builder&>::type
+    append(const U __unaligned* pidl)
+    {
+        raw_pidl::traits<U>::type_check(pidl);
+
+        append_bytes(pidl, raw_pidl::size(pidl));
+        return *this;
+    }
+
+    /**
+     * Append a wrapped PIDL.
+     *
+     * Will fail to compile if used to append an absolute PIDL.
+     */
+    template<typename U, typename AllocU>
+    typename boost::enable_if_c<
+        raw_pidl::traits<U>::is_appendable, basic_pidl_builder&>::type
+    append(const basic_pidl<U, AllocU>& pidl)
+    {
+        append_bytes(pidl.get(), pidl.size());
+        return *this;
+    }
+
+    template<typename U>
+    basic_pidl_builder& operator+=(const U& pidl)
+    {
+        return append(pidl);
+    }
+
+    /**
+     * The PIDL built so far.
+     *
+     * The pointer is invalidated by the next append.
+     */
+    const T* get() const
+    {
+        return m_pidl;
+    }
+
+    /**
+     * Size of the PIDL built so far in bytes, including the null-terminator.
+     *
+     * Unlike basic_pidl::size, this does not walk the PIDL.
+     */
+    size_t size() const
+    {
+        return (m_pidl) ? m_size + sizeof(m_pidl->mkid.cb) : 0;
+    }
+
+    /**
+     * Number of bytes the PIDL can grow to before the buffer is reallocated.
+     */
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    /**
+     * Is the PIDL built so far empty?
+     */
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    /**
+     * Hand over the PIDL built so far.
+     *
+     * The buffer is transferred to the returned PIDL without copying and the
+     * builder is left empty as though newly constructed.
+     */
+    pidl_type release()
+    {
+        pidl_type pidl;
+        if (m_pidl)
+            pidl.attach(m_pidl);
+
+        m_pidl = NULL;
+        m_size = 0;
+        m_capacity = 0;
+
+        return pidl;
+    }
+
+private:
+
+    /**
+     * Append the items of a PIDL that measures @a size bytes including its
+     * null-terminator.
+     */
+    template<typename U>
+    void append_bytes(const U __unaligned* pidl, size_t size)
+    {
+        if (!pidl)
+            return;
+
+        assert(size >= sizeof(pidl->mkid.cb));
+        size_t item_bytes = size - sizeof(pidl->mkid.cb);
+        size_t required = m_size + item_bytes + sizeof(pidl->mkid.cb);
+
+        if (required > m_capacity)
+        {
+            // The PIDL may lie in our own buffer, as when a builder appends
+            // itself, so it is copied before that buffer is freed
+            reallocate(
+                (std::max)(required, m_capacity * 2), pidl, item_bytes);
+            return;
+        }
+
+        BYTE* end = reinterpret_cast<BYTE*>(m_pidl) + m_size;
+        std::memcpy(end, pidl, item_bytes);
+        m_size += item_bytes;
+
+        write_terminator();
+    }
+
+    /**
+     * Move the items to a new buffer of @a capacity bytes, followed by the
+     * @a appended_bytes of items at @a appended.
+     */
+    void reallocate(
+        size_t capacity, const void* appended=NULL,
+        size_t appended_bytes=0)
+    {
+        assert(
+            capacity >= m_size + appended_bytes + sizeof(m_pidl->mkid.cb));
+
+        T* pidl = Alloc::allocate(capacity);
+        if (m_pidl)
+            std::memcpy(pidl, m_pidl, m_size);
+        if (appended_bytes)
+            std::memcpy(
+                reinterpret_cast<BYTE*>(pidl) + m_size, appended,
+                appended_bytes);
+
+        Alloc::deallocate(m_pidl);
+        m_pidl = pidl;
+        m_size += appended_bytes;
+        m_capacity = capacity;
+
+        write_terminator();
+    }
+
+    void write_terminator()
+    {
+        raw_pidl::skip(m_pidl, m_size)->mkid.cb = 0;
+    }
+
+    T* m_pidl;
+    size_t m_size; ///< Bytes used by items (excludes null-terminator)
+    size_t m_capacity; ///< Bytes allocated
+};
+
+/**
+ * @name  Standard shell PIDL builder types.
+ *
+ * These produce the standard CoTaskMemAlloc-allocated PIDL types.
+ */
+// @{
+typedef basic_pidl_builder<
+    ITEMIDLIST_RELATIVE, cotaskmem_alloc<ITEMIDLIST_RELATIVE> > pidl_builder;
+typedef basic_pidl_builder<
+    ITEMIDLIST_ABSOLUTE, cotaskmem_alloc<ITEMIDLIST_ABSOLUTE> > apidl_builder;
+// @}
+
+}}} // namespace washer::shell::pidl
+
+#endif
@@ -0,0 +1,273 @@
+/**
+    @file
+
+    Random access to the items of a PIDL.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_PIDL_INDEX_HPP
+#define WASHER_SHELL_PIDL_INDEX_HPP
+#pragma once
+
+#include <washer/shell/pidl.hpp> // basic_pidl, basic_pidl_view
+#include <washer/shell/pidl_iterator.hpp> // raw_pidl_iterator
+
+#include <boost/throw_exception.hpp> // BOOST_THROW_EXCEPTION
+
+#include <cassert> // assert
+#include <limits> // numeric_limits
+#include <stdexcept> // out_of_range
+#include <vector>
+
+namespace washer {
+namespace shell {
+namespace pidl {
+
+/**
+ * Table of the offsets of each item in a PIDL.
+ *
+ * Finding the Nth item of a PIDL, or the first N items, normally means
+ * walking the list from the start.  The index walks the PIDL once, when it
+ * is created, and records where each item starts.  After that, accessing
+ * any item, prefix or suffix is O(1) and returns a view into the original
+ * PIDL.
+ *
+ * Like a view, the index doesn't own the PIDL and is invalidated if the
+ * PIDL is destroyed or changed.
+ */
+template<typename T>
+class basic_pidl_index
+{
+public:
+
+    /**
+     * Index a raw PIDL.
+     */
+    explicit basic_pidl_index(const T __unaligned* pidl)
+    {
+        raw_pidl::traits<T>::type_check(pidl);
+        build(pidl, (std::numeric_limits<size_t>::max)(), true);
+    }
+
+    /**
+     * Index a wrapped PIDL.
+     */
+    template<typename Alloc>
+    explicit basic_pidl_index(const basic_pidl<T, Alloc>& pidl)
+    {
+        build(pidl.get(), (std::numeric_limits<size_t>::max)(), true);
+    }
+
+    /**
+     * Index the items in a view, which need not be terminated.
+     */
+    explicit basic_pidl_index(const basic_pidl_view<T>& view)
+    {
+        build(view.data(), view.item_bytes(), view.is_terminated());
+    }
+
+    /**
+     * Number of items in the PIDL.
+     */
+    size_t depth() const
+    {
+        return m_offsets.size() - 1;
+    }
+
+    /**
+     * Is the PIDL empty?
+     */
+    bool empty() const
+    {
+        return depth() == 0;
+    }
+
+    /**
+     * View of the whole indexed PIDL.
+     */
+    const basic_pidl_view<T>& view() const
+    {
+        return m_view;
+    }
+
+    /**
+     * View of the item at position @a i.
+     *
+     * No bounds checking.  See at().
+     */
+    basic_pidl_view<ITEMID_CHILD> operator[](size_t i) const
+    {
+        assert(i < depth());
+
+        bool terminated = (i + 1 == depth()) && m_view.is_terminated();
+        return basic_pidl_view<ITEMID_CHILD>(
+            reinterpret_cast<const ITEMID_CHILD __unaligned*>(address(i)),
+            m_offsets[i + 1] - m_offsets[i], 0, terminated);
+    }
+
+    /**
+     * View of the item at position @a i.
+     *
+     * @throws std::out_of_range if there is no such item.
+     */
+    basic_pidl_view<ITEMID_CHILD> at(size_t i) const
+    {
+        check_depth(i + 1);
+        return (*this)[i];
+    }
+
+    /**
+     * View of the first @a n items.
+     *
+     * The view is terminated only if it covers the whole PIDL.
+     *
+     * @throws std::out_of_range if the PIDL has fewer items.
+     */
+    basic_pidl_view<T> prefix(size_t n) const
+    {
+        check_depth(n);
+
+        size_t last = (n == 0) ? 0 : m_offsets[n - 1];
+        return basic_pidl_view<T>(
+            m_view.data(), m_offsets[n], last,
+            n == depth() && m_view.is_terminated());
+    }
+
+    /**
+     * View of the ancestor @a n levels up.
+     *
+     * ancestor(0) is the whole PIDL and ancestor(1) is its parent.
+     *
+     * @throws std::out_of_range if the PIDL has fewer than @a n items.
+     */
+    basic_pidl_view<T> ancestor(size_t n) const
+    {
+        check_depth(n);
+        return prefix(depth() - n);
+    }
+
+    /**
+     * View of the items from position @a n onwards.
+     *
+     * The view is terminated if the indexed PIDL is.
+     *
+     * @throws std::out_of_range if the PIDL has fewer than @a n items.
+     */
+    basic_pidl_view<ITEMIDLIST_RELATIVE> suffix(size_t n) const
+    {
+        check_depth(n);
+
+        size_t last = (n == depth()) ? m_offsets[n] : m_offsets[depth() - 1];
+        return basic_pidl_view<ITEMIDLIST_RELATIVE>(
+            reinterpret_cast<const ITEMIDLIST_RELATIVE __unaligned*>(
+                address(n)),
+            m_offsets[depth()] - m_offsets[n],
+            last - m_offsets[n], m_view.is_terminated());
+    }
+
+    /**
+     * Iterator positioned at item @a n of the PIDL.
+     *
+     * Unlike walking a raw_pidl_iterator forward from the start, this
+     * doesn't have to step over the earlier items.
+     *
+     * @throws std::out_of_range if the PIDL has fewer than @a n items.
+     * @throws std::logic_error if the indexed view is not terminated, as
+     *         a raw_pidl_iterator relies on the terminator to find the end.
+     */
+    raw_pidl_iterator raw_iterator_at(size_t n) const
+    {
+        return raw_pidl_iterator(suffix(n).get());
+    }
+
+    /**
+     * Byte offset of item @a n from the start of the PIDL.
+     *
+     * offset(depth()) is the offset of the null-terminator.
+     */
+    size_t offset(size_t n) const
+    {
+        check_depth(n);
+        return m_offsets[n];
+    }
+
+private:
+
+    /**
+     * Record the offsets of the items in the first @a bound bytes of the
+     * PIDL, or up to its null-terminator if that comes first.
+     *
+     * This is the only walk over the PIDL; the view is made from its
+     * results rather than measuring the PIDL again.
+     */
+    void build(const T __unaligned* pidl, size_t bound, bool terminated)
+    {
+        m_offsets.push_back(0);
+
+        size_t offset = 0;
+        if (pidl)
+        {
+            USHORT cb;
+            while (offset < bound &&
+                   (cb = raw_pidl::skip(pidl, offset)->mkid.cb) != 0)
+            {
+                offset += cb;
+                m_offsets.push_back(offset);
+            }
+        }
+
+        size_t last = (depth() == 0) ? 0 : m_offsets[depth() - 1];
+        m_view = basic_pidl_view<T>(pidl, offset, last, terminated);
+    }
+
+    const BYTE __unaligned* address(size_t n) const
+    {
+        return reinterpret_cast<const BYTE __unaligned*>(m_view.data()) +
+            m_offsets[n];
+    }
+
+    void check_depth(size_t n) const
+    {
+        if (n > depth())
+            BOOST_THROW_EXCEPTION(std::out_of_range("PIDL is not that deep"));
+    }
+
+    basic_pidl_view<T> m_view;
+    std::vector<size_t> m_offsets; ///< Start of each item, then the end
+};
+
+/**
+ * @name  Standard shell PIDL index types.
+ */
+// @{
+typedef basic_pidl_index<ITEMIDLIST_RELATIVE> pidl_index;
+typedef basic_pidl_index<ITEMIDLIST_ABSOLUTE> apidl_index;
+// @}
+
+}}} // namespace washer::shell::pidl
+
+#endif
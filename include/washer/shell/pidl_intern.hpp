@@ -0,0 +1,564 @@
+/**
+    @file
+
+    Sharing storage between identical PIDLs.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_PIDL_INTERN_HPP
+#define WASHER_SHELL_PIDL_INTERN_HPP
+#pragma once
+
+#include <washer/shell/pidl.hpp> // basic_pidl, basic_pidl_view, raw_pidl
+
+#include <boost/make_shared.hpp> // make_shared
+#include <boost/noncopyable.hpp> // noncopyable
+#include <boost/ref.hpp> // ref
+#include <boost/shared_ptr.hpp> // shared_ptr
+#include <boost/unordered_set.hpp> // unordered_set
+#include <boost/version.hpp>
+#if (BOOST_VERSION >= 104800)
+#include <boost/move/move.hpp> // BOOST_RV_REF
+#endif
+
+#include <cstddef> // size_t
+#include <cstring> // memcmp
+
+namespace washer {
+namespace shell {
+namespace pidl {
+
+template<typename T, typename Alloc>
+class basic_pidl_intern_table;
+
+namespace detail {
+
+    /**
+     * Shared, immutable storage for one interned PIDL.
+     *
+     * The hash and size are worked out once, when the PIDL is interned, so
+     * handles never have to walk the PIDL to compare or measure it.
+     */
+    template<typename T, typename Alloc>
+    class interned_pidl_entry : private boost::noncopyable
+    {
+    public:
+
+        /**
+         * Take over the given PIDL's memory.
+         */
+        interned_pidl_entry(basic_pidl<T, Alloc>& pidl, size_t hash)
+            : m_hash(hash)
+        {
+            m_pidl.swap(pidl);
+            m_size = m_pidl.size();
+        }
+
+        const T* get() const { return m_pidl.get(); }
+        size_t size() const { return m_size; }
+        size_t hash() const { return m_hash; }
+
+    private:
+        basic_pidl<T, Alloc> m_pidl;
+        size_t m_size;
+        size_t m_hash;
+    };
+}
+
+/**
+ * Handle to a PIDL stored in a basic_pidl_intern_table.
+ *
+ * Copying a handle shares the PIDL rather than cloning it.  The PIDL is
+ * immutable and is freed when the last handle to it (and the table, if it
+ * still holds it) lets go.  The reference count is atomic so handles to the
+ * same PIDL can be copied and destroyed on different threads.
+ *
+ * Handles to equal PIDLs from the same table always share storage so they
+ * compare equal by pointer.  Handles with different storage are first
+ * compared by their cached hashes and only compared byte-for-byte if those
+ * match, which can only happen for handles from different tables or hash
+ * collisions.
+ */
+template<typename T, typename Alloc>
+class basic_interned_pidl
+{
+    typedef detail::interned_pidl_entry<T, Alloc> entry_type;
+
+public:
+
+    typedef T value_type;
+    typedef const T* const_pointer;
+    typedef Alloc allocator;
+
+    /**
+     * A NULL PIDL.
+     */
+    basic_interned_pidl() {}
+
+    /**
+     * The interned PIDL.
+     *
+     * This is suitable for passing straight to shell APIs and is valid for as
+     * long as any handle to this PIDL exists.
+     */
+    const T* get() const
+    {
+        return (m_entry) ? m_entry->get() : NULL;
+    }
+
+    /**
+     * Result of comparing with NULL.
+     */
+    bool operator!() const
+    {
+        return !get();
+    }
+
+    /**
+     * The size of the PIDL in bytes, including the null-terminator.
+     *
+     * Unlike basic_pidl::size(), this is O(1).
+     */
+    size_t size() const
+    {
+        return (m_entry) ? m_entry->size() : 0;
+    }
+
+    /**
+     * Is the PIDL empty?
+     *
+     * Empty PIDLs are either NULL or point to a NULL-terminator.
+     */
+    bool empty() const
+    {
+        return raw_pidl::empty(get());
+    }
+
+    /**
+     * Hash of the PIDL's items; the same as hash_value of a basic_pidl with
+     * the same items.
+     */
+    size_t hash() const
+    {
+        return (m_entry) ? m_entry->hash() : raw_pidl::hash(get());
+    }
+
+    /**
+     * View of the interned PIDL.
+     */
+    basic_pidl_view<T> view() const
+    {
+        return basic_pidl_view<T>(get());
+    }
+
+    /**
+     * Copy the interned PIDL into a PIDL the caller owns.
+     */
+    basic_pidl<T, Alloc> copy() const
+    {
+        return basic_pidl<T, Alloc>(get());
+    }
+
+    /**
+     * Do both handles share storage?
+     */
+    bool shares_storage_with(const basic_interned_pidl& other) const
+    {
+        return m_entry == other.m_entry;
+    }
+
+    /**
+     * No-fail swap.
+     */
+    void swap(basic_interned_pidl& other) throw()
+    {
+        m_entry.swap(other.m_entry);
+    }
+
+private:
+    friend class basic_pidl_intern_table<T, Alloc>;
+
+    explicit basic_interned_pidl(
+        const boost::shared_ptr<const entry_type>& entry) : m_entry(entry) {}
+
+    boost::shared_ptr<const entry_type> m_entry;
+};
+
+/**
+ * @name Comparison
+ *
+ * Interned PIDLs are equal if their items are the same byte-for-byte and are
+ * ordered as defined by raw_pidl::compare.  NULL and empty PIDLs are equal.
+ */
+// @{
+template<typename T, typename Alloc>
+inline bool operator==(
+    const basic_interned_pidl<T, Alloc>& lhs,
+    const basic_interned_pidl<T, Alloc>& rhs)
+{
+    if (lhs.shares_storage_with(rhs))
+        return true;
+    else if (lhs.hash() != rhs.hash())
+        return false;
+    else
+        return raw_pidl::equal(lhs.get(), rhs.get());
+}
+
+template<typename T, typename Alloc>
+inline bool operator!=(
+    const basic_interned_pidl<T, Alloc>& lhs,
+    const basic_interned_pidl<T, Alloc>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template<typename T, typename Alloc>
+inline bool operator<(
+    const basic_interned_pidl<T, Alloc>& lhs,
+    const basic_interned_pidl<T, Alloc>& rhs)
+{
+    return !lhs.shares_storage_with(rhs) &&
+        raw_pidl::less(lhs.get(), rhs.get());
+}
+// @}
+
+/**
+ * Hash of an interned PIDL for use with boost::hash.
+ */
+template<typename T, typename Alloc>
+inline size_t hash_value(const basic_interned_pidl<T, Alloc>& pidl)
+{
+    return pidl.hash();
+}
+
+/**
+ * No-fail swap.
+ */
+template<typename T, typename Alloc>
+inline void swap(
+    basic_interned_pidl<T, Alloc>& lhs, basic_interned_pidl<T, Alloc>& rhs)
+    throw()
+{
+    lhs.swap(rhs);
+}
+
+/**
+ * Memory used by a basic_pidl_intern_table.
+ */
+struct pidl_intern_statistics
+{
+    size_t unique_pidls; ///< Distinct PIDLs held by the table
+    size_t handles; ///< Handles, outside the table, sharing those PIDLs
+    size_t stored_bytes; ///< Bytes of PIDL data held by the table
+    size_t saved_bytes; ///< Extra bytes the handles would have needed if
+                        ///< each had its own copy of its PIDL
+};
+
+/**
+ * Deduplicates identical PIDLs into shared storage.
+ *
+ * Interning a PIDL returns a handle to the table's copy of a PIDL with the
+ * same items, copying the PIDL into the table only if the table doesn't
+ * have one already.  Large numbers of identical PIDLs, such as the parent
+ * folder of every item in a view, therefore cost only one allocation
+ * between them.
+ *
+ * The table keeps its PIDLs alive until purge() or clear() is called, even
+ * if no handles refer to them.  Handles outlive the table safely.
+ *
+ * Interning and purging are not thread-safe; the handles are.
+ */
+template<typename T, typename Alloc>
+class basic_pidl_intern_table : private boost::noncopyable
+{
+    typedef detail::interned_pidl_entry<T, Alloc> entry_type;
+    typedef boost::shared_ptr<const entry_type> entry_pointer;
+
+public:
+
+    typedef basic_interned_pidl<T, Alloc> handle_type;
+    typedef basic_pidl<T, Alloc> pidl_type;
+
+    /**
+     * Intern a raw PIDL, copying it only if it isn't already in the table.
+     */
+    handle_type intern(const T __unaligned* pidl)
+    {
+        if (!pidl)
+            return handle_type();
+
+        raw_pidl::traits<T>::type_check(pidl);
+
+        lookup_key key(pidl);
+        typename entry_set::const_iterator pos =
+            m_entries.find(key, entry_hash(), entry_equal());
+        if (pos != m_entries.end())
+            return handle_type(*pos);
+
+        pidl_type copy(pidl);
+        return insert(copy, key.hash);
+    }
+
+    /**
+     * Intern a wrapped PIDL, copying it only if it isn't already in the
+     * table.
+     */
+    template<typename AllocU>
+    handle_type intern(const basic_pidl<T, AllocU>& pidl)
+    {
+        return intern(pidl.get());
+    }
+
+    /**
+     * Intern a view's items, copying them only if they aren't already in the
+     * table.
+     */
+    handle_type intern(const basic_pidl_view<T>& view)
+    {
+        if (!view.data())
+            return handle_type();
+
+        lookup_key key(view);
+        typename entry_set::const_iterator pos =
+            m_entries.find(key, entry_hash(), entry_equal());
+        if (pos != m_entries.end())
+            return handle_type(*pos);
+
+        pidl_type copy(view);
+        return insert(copy, key.hash);
+    }
+
+#if (BOOST_VERSION >= 104800)
+
+    /**
+     * Intern a PIDL that the caller no longer needs.
+     *
+     * If the table doesn't already hold the PIDL, it takes over the PIDL's
+     * memory rather than copying it.  Either way, @a pidl is left NULL.
+     */
+    handle_type intern(BOOST_RV_REF(pidl_type) pidl)
+    {
+        pidl_type adopted(boost::move(pidl));
+        if (!adopted)
+            return handle_type();
+
+        lookup_key key(adopted.get());
+        typename entry_set::const_iterator pos =
+            m_entries.find(key, entry_hash(), entry_equal());
+        if (pos != m_entries.end())
+            return handle_type(*pos);
+
+        return insert(adopted, key.hash);
+    }
+
+#endif
+
+    /**
+     * Number of distinct PIDLs in the table.
+     */
+    size_t size() const
+    {
+        return m_entries.size();
+    }
+
+    bool empty() const
+    {
+        return m_entries.empty();
+    }
+
+    /**
+     * Release the table's hold on PIDLs that no handle refers to any more.
+     *
+     * @returns  Number of PIDLs freed.
+     */
+    size_t purge()
+    {
+        size_t purged = 0;
+        typename entry_set::iterator it = m_entries.begin();
+        while (it != m_entries.end())
+        {
+            if (it->use_count() == 1)
+            {
+                it = m_entries.erase(it);
+                ++purged;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        return purged;
+    }
+
+    /**
+     * Release the table's hold on all its PIDLs.
+     *
+     * PIDLs with outstanding handles stay alive until the handles are
+     * destroyed but later interning will no longer share them.
+     */
+    void clear()
+    {
+        m_entries.clear();
+    }
+
+    /**
+     * Measure how much memory interning is saving.
+     *
+     * This visits every PIDL in the table.  Handle counts are a snapshot if
+     * handles are being copied or destroyed on other threads.
+     */
+    pidl_intern_statistics statistics() const
+    {
+        pidl_intern_statistics stats = {0, 0, 0, 0};
+
+        for (typename entry_set::const_iterator it = m_entries.begin();
+             it != m_entries.end(); ++it)
+        {
+            // The table's own reference isn't a handle
+            size_t handles = it->use_count() - 1;
+            size_t size = (*it)->size();
+
+            ++stats.unique_pidls;
+            stats.handles += handles;
+            stats.stored_bytes += size;
+            if (handles > 1)
+                stats.saved_bytes += (handles - 1) * size;
+        }
+
+        return stats;
+    }
+
+private:
+
+    /**
+     * Raw items to look up in the table without copying them first.
+     */
+    struct lookup_key
+    {
+        /**
+         * Key for a null-terminated PIDL, hashed in a single pass.
+         */
+        explicit lookup_key(const T __unaligned* pidl)
+            : items(pidl), item_bytes(0), bounded(false),
+              hash(raw_pidl::hash(pidl)) {}
+
+        /**
+         * Key for the items of a view, which need not be terminated.
+         */
+        explicit lookup_key(const basic_pidl_view<T>& view)
+            : items(view.data()), item_bytes(view.item_bytes()),
+              bounded(true), hash(hash_value(view)) {}
+
+        const T __unaligned* items;
+        size_t item_bytes; ///< Size of items excluding terminator if bounded
+        bool bounded;
+        size_t hash;
+    };
+
+    struct entry_hash
+    {
+        size_t operator()(const entry_pointer& entry) const
+        {
+            return entry->hash();
+        }
+
+        size_t operator()(const lookup_key& key) const
+        {
+            return key.hash;
+        }
+    };
+
+    struct entry_equal
+    {
+        bool operator()(
+            const entry_pointer& lhs, const entry_pointer& rhs) const
+        {
+            return lhs == rhs || (lhs->hash() == rhs->hash() &&
+                raw_pidl::equal(lhs->get(), rhs->get()));
+        }
+
+        bool operator()(
+            const lookup_key& key, const entry_pointer& entry) const
+        {
+            if (key.hash != entry->hash())
+                return false;
+            else if (!key.bounded)
+                return raw_pidl::equal(key.items, entry->get());
+            else
+                return
+                    key.item_bytes + sizeof(USHORT) == entry->size() &&
+                    std::memcmp(key.items, entry->get(), key.item_bytes) == 0;
+        }
+
+        bool operator()(
+            const entry_pointer& entry, const lookup_key& key) const
+        {
+            return (*this)(key, entry);
+        }
+    };
+
+    typedef boost::unordered_set<entry_pointer, entry_hash, entry_equal>
+        entry_set;
+
+    handle_type insert(basic_pidl<T, Alloc>& pidl, size_t hash)
+    {
+        entry_pointer entry = boost::make_shared<entry_type>(
+            boost::ref(pidl), hash);
+        m_entries.insert(entry);
+        return handle_type(entry);
+    }
+
+    entry_set m_entries;
+};
+
+/**
+ * @name  Standard interned PIDL types.
+ *
+ * These hold the standard CoTaskMemAlloc-allocated PIDL types.
+ */
+// @{
+typedef basic_interned_pidl<
+    ITEMIDLIST_RELATIVE, cotaskmem_alloc<ITEMIDLIST_RELATIVE> > interned_pidl;
+typedef basic_interned_pidl<
+    ITEMIDLIST_ABSOLUTE, cotaskmem_alloc<ITEMIDLIST_ABSOLUTE> > interned_apidl;
+typedef basic_interned_pidl<ITEMID_CHILD, cotaskmem_alloc<ITEMID_CHILD> >
+    interned_cpidl;
+
+typedef basic_pidl_intern_table<
+    ITEMIDLIST_RELATIVE, cotaskmem_alloc<ITEMIDLIST_RELATIVE> >
+    pidl_intern_table;
+typedef basic_pidl_intern_table<
+    ITEMIDLIST_ABSOLUTE, cotaskmem_alloc<ITEMIDLIST_ABSOLUTE> >
+    apidl_intern_table;
+typedef basic_pidl_intern_table<ITEMID_CHILD, cotaskmem_alloc<ITEMID_CHILD> >
+    cpidl_intern_table;
+// @}
+
+}}} // namespace washer::shell::pidl
+
+#endif
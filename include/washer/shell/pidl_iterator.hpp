@@ -33,18 +33,22 @@
 #define WASHER_SHELL_PIDL_ITERATOR_HPP
 #pragma once
 
-#include <washer/shell/pidl.hpp> // next, empty, pidl_t
+#include <washer/shell/pidl.hpp> // next, empty, pidl_t, cpidl_view
 
+#include <boost/cstdint.hpp> // uint32_t
 #include <boost/iterator/iterator_adaptor.hpp> // iterator_adaptor
+#include <boost/iterator/iterator_facade.hpp> // iterator_facade
 
 #include <cassert> // assert
+#include <limits> // numeric_limits
 #include <stdexcept> // range_error
 
+#ifdef _WIN32
 #ifndef STRICT_TYPED_ITEMIDS
 #error Currently, washer requires strict PIDL types: define STRICT_TYPED_ITEMIDS
 #endif
-#include <Shlobj.h> // ILCloneFirst
 #include <ShTypes.h> // Raw PIDL types
+#endif
 
 namespace washer {
 namespace shell {
@@ -91,7 +95,7 @@ public:
     raw_pidl_iterator() : raw_pidl_iterator::iterator_adaptor_(NULL) {}
 
 private:
-    friend boost::iterator_core_access;
+    friend class boost::iterator_core_access;
 
     reference dereference() const
     {
@@ -151,25 +155,273 @@ class pidl_iterator :
 public:
     template<typename T, typename Alloc>
     explicit pidl_iterator(const basic_pidl<T, Alloc>& pidl)
-        : pidl_iterator::iterator_adaptor_(raw_pidl_iterator(pidl.get())) {}
+        : pidl_iterator::iterator_adaptor_(raw_pidl_iterator(pidl.get())),
+          m_item_source(NULL) {}
 
     explicit pidl_iterator(PCUIDLIST_RELATIVE pidl)
-        : pidl_iterator::iterator_adaptor_(raw_pidl_iterator(pidl)) {}
+        : pidl_iterator::iterator_adaptor_(raw_pidl_iterator(pidl)),
+          m_item_source(NULL) {}
+
+    pidl_iterator()
+        : pidl_iterator::iterator_adaptor_(), m_item_source(NULL) {}
+
+private:
+    friend class boost::iterator_core_access;
+
+    reference dereference() const;
+
+    mutable cpidl_t m_item;
+    mutable PCUIDLIST_RELATIVE m_item_source; ///< Item m_item was cloned from
+};
+
+/**
+ * Iterates over the items in an Item ID List without copying them.
+ *
+ * The iteration is complete when the iterator is equal to a default-constructed
+ * one.  I.e when @code iterator == pidl_view_iterator() @endcode
+ *
+ * The iterator becomes invalid if the IDLIST that it is created from is
+ * deallocated.
+ *
+ * When dereferenced, returns a view of the single item at that point in the
+ * original PIDL (a cpidl_view).  Unlike pidl_iterator, nothing is copied;
+ * convert the view to a cpidl_t to get a copy of the item.
+ *
+ * The iterator is bidirectional.  As items can only be found by walking
+ * forward, it keeps the offsets of a handful of the items it has passed as
+ * checkpoints, inside the iterator itself so iteration doesn't allocate.
+ * Stepping back walks forward from the nearest checkpoint, leaving new
+ * checkpoints along the way.  Walking backwards from the end of even a very
+ * deep PIDL therefore costs a few forward walks rather than one per item.
+ *
+ * A default-constructed end iterator cannot be decremented as it doesn't
+ * know which PIDL it belongs to.  Use end() to get one that can.
+ */
+class pidl_view_iterator :
+    public boost::iterator_facade<
+        pidl_view_iterator, cpidl_view, boost::bidirectional_traversal_tag,
+        cpidl_view>
+{
+public:
 
-    pidl_iterator() : pidl_iterator::iterator_adaptor_() {}
+    pidl_view_iterator() :
+        m_pidl(NULL), m_bound(0), m_terminated(true), m_offset(0),
+        m_index(0), m_stride(1), m_checkpoint_count(0) {}
+
+    explicit pidl_view_iterator(PCUIDLIST_RELATIVE pidl) :
+        m_pidl(pidl), m_bound((std::numeric_limits<size_t>::max)()),
+        m_terminated(true), m_offset(0), m_index(0), m_stride(1),
+        m_checkpoint_count(0) {}
+
+    template<typename T, typename Alloc>
+    explicit pidl_view_iterator(const basic_pidl<T, Alloc>& pidl) :
+        m_pidl(pidl.get()), m_bound((std::numeric_limits<size_t>::max)()),
+        m_terminated(true), m_offset(0), m_index(0), m_stride(1),
+        m_checkpoint_count(0) {}
+
+    /**
+     * Iterate over the items of a view, which need not be terminated.
+     */
+    template<typename T>
+    explicit pidl_view_iterator(const basic_pidl_view<T>& view) :
+        m_pidl(view.data()), m_bound(view.item_bytes()),
+        m_terminated(view.is_terminated()), m_offset(0), m_index(0),
+        m_stride(1), m_checkpoint_count(0) {}
+
+    /**
+     * Iterator positioned after the last item of the given PIDL or view.
+     *
+     * Unlike a default-constructed iterator, this can be decremented.
+     */
+    template<typename P>
+    static pidl_view_iterator end(const P& pidl)
+    {
+        pidl_view_iterator it(pidl);
+        while (!it.at_end())
+        {
+            ++it;
+        }
+        return it;
+    }
 
 private:
-    friend boost::iterator_core_access;
+    friend class boost::iterator_core_access;
+
+    static const size_t max_checkpoints = 8;
+
+    /**
+     * Position of an item the iterator can return to without walking from
+     * the start of the PIDL.
+     *
+     * 32 bits are plenty: each item is at most 64KB and real PIDLs are
+     * nowhere near 4GB.  Halving the size of the checkpoints keeps the
+     * iterator cheap to copy.
+     */
+    struct checkpoint
+    {
+        boost::uint32_t index;
+        boost::uint32_t offset;
+    };
+
+    USHORT cb_at(size_t offset) const
+    {
+        return raw_pidl::skip(m_pidl, offset)->mkid.cb;
+    }
+
+    bool at_end() const
+    {
+        return m_pidl == NULL || m_offset >= m_bound || cb_at(m_offset) == 0;
+    }
+
+    /**
+     * Canonical position; NULL at the end of any PIDL.
+     */
+    PCUIDLIST_RELATIVE position() const
+    {
+        return (at_end()) ? NULL : raw_pidl::skip(m_pidl, m_offset);
+    }
 
     reference dereference() const
     {
-        m_item.attach(::ILCloneFirst(*this->base_reference()));
-        return m_item;
+        if (at_end())
+            BOOST_THROW_EXCEPTION(
+                std::logic_error(
+                    "Dereferencing past the end of the ITEMIDLIST"));
+
+        size_t next = m_offset + cb_at(m_offset);
+        bool terminated = (next >= m_bound) ? m_terminated : cb_at(next) == 0;
+
+        return cpidl_view(
+            reinterpret_cast<PCUITEMID_CHILD>(raw_pidl::skip(m_pidl, m_offset)),
+            cb_at(m_offset), 0, terminated);
     }
 
-    mutable cpidl_t m_item;
+    bool equal(const pidl_view_iterator& other) const
+    {
+        return position() == other.position();
+    }
+
+    void increment()
+    {
+        if (at_end())
+            BOOST_THROW_EXCEPTION(
+                std::range_error("Cannot increment past end of ITEMIDLIST"));
+
+        m_offset += cb_at(m_offset);
+        ++m_index;
+
+        if (m_index - last_checkpoint().index >= m_stride)
+        {
+            // Only use half the checkpoints going forward, leaving the rest
+            // to cut short the walks when stepping back
+            if (m_checkpoint_count >= max_checkpoints / 2)
+            {
+                // Keep every other checkpoint so that they stay spread over
+                // everything passed so far, and space new ones further apart
+                size_t kept = 0;
+                for (size_t i = 1; i < m_checkpoint_count; i += 2)
+                {
+                    m_checkpoints[kept++] = m_checkpoints[i];
+                }
+                m_checkpoint_count = kept;
+                m_stride *= 2;
+            }
+
+            if (m_index - last_checkpoint().index >= m_stride)
+                add_checkpoint(m_index, m_offset);
+        }
+    }
+
+    void decrement()
+    {
+        if (m_index == 0)
+            BOOST_THROW_EXCEPTION(
+                std::range_error(
+                    "Cannot decrement before start of ITEMIDLIST"));
+
+        --m_index;
+
+        // Checkpoints after the new position can't help to step back further
+        while (m_checkpoint_count > 0 &&
+               m_checkpoints[m_checkpoint_count - 1].index > m_index)
+        {
+            --m_checkpoint_count;
+        }
+
+        checkpoint start = last_checkpoint();
+        size_t distance = m_index - start.index;
+
+        // Leave checkpoints halfway to the new position, then halfway along
+        // what remains, and so on, so that the walks for the next steps back
+        // are short
+        size_t next_checkpoint = distance / 2;
+
+        size_t offset = start.offset;
+        for (size_t i = 1; i <= distance; ++i)
+        {
+            offset += cb_at(offset);
+
+            if (i == next_checkpoint && i < distance &&
+                m_checkpoint_count < max_checkpoints)
+            {
+                add_checkpoint(start.index + i, offset);
+                next_checkpoint = i + (distance - i) / 2;
+            }
+        }
+
+        m_offset = offset;
+    }
+
+    /**
+     * Latest checkpoint, or the start of the PIDL if there isn't one.
+     */
+    checkpoint last_checkpoint() const
+    {
+        if (m_checkpoint_count > 0)
+        {
+            return m_checkpoints[m_checkpoint_count - 1];
+        }
+        else
+        {
+            checkpoint start = { 0, 0 };
+            return start;
+        }
+    }
+
+    void add_checkpoint(size_t index, size_t offset)
+    {
+        assert(m_checkpoint_count < max_checkpoints);
+        assert(offset <= (std::numeric_limits<boost::uint32_t>::max)());
+
+        checkpoint c = {
+            static_cast<boost::uint32_t>(index),
+            static_cast<boost::uint32_t>(offset) };
+        m_checkpoints[m_checkpoint_count++] = c;
+    }
+
+    PCUIDLIST_RELATIVE m_pidl;
+    size_t m_bound; ///< Bytes of m_pidl that may be iterated over
+    bool m_terminated; ///< Is the item at m_bound a null-terminator
+    size_t m_offset; ///< Offset of the current item
+    size_t m_index; ///< Index of the current item
+    size_t m_stride; ///< Items to pass before adding another checkpoint
+    size_t m_checkpoint_count;
+    checkpoint m_checkpoints[max_checkpoints]; ///< In order of position
 };
 
+inline pidl_iterator::reference pidl_iterator::dereference() const
+{
+    // Only clone the item once, however many times it is dereferenced
+    PCUIDLIST_RELATIVE item = *this->base_reference();
+    if (item != m_item_source)
+    {
+        m_item = cpidl_t(*pidl_view_iterator(item));
+        m_item_source = item;
+    }
+
+    return m_item;
+}
+
 inline bool operator==(const raw_pidl_iterator& lhs, const pidl_iterator& rhs)
 {
     return lhs == rhs.base();
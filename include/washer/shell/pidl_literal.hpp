@@ -0,0 +1,241 @@
+/**
+    @file
+
+    PIDLs laid out in static storage at compile time.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_PIDL_LITERAL_HPP
+#define WASHER_SHELL_PIDL_LITERAL_HPP
+#pragma once
+
+#include <washer/shell/pidl.hpp> // raw_pidl
+
+#include <boost/static_assert.hpp> // BOOST_STATIC_ASSERT
+
+#include <cassert> // assert
+#include <climits> // USHRT_MAX
+#include <cstddef> // size_t
+
+namespace washer {
+namespace shell {
+namespace pidl {
+
+/*
+ * A PIDL literal is a POD aggregate whose layout is exactly that of the
+ * PIDL it represents: each item's size field immediately followed by its
+ * payload, then the null-terminator.  Being an aggregate, a literal
+ * declared at namespace scope (or as a function-local static) with a
+ * brace-initialiser of constant expressions is initialised statically.
+ * Using it involves no allocation, no copying and no initialisation order
+ * problems.
+ *
+ * For example, with a payload type @c root_item:
+ *
+ *     static const child_pidl_literal<root_item>::type root_pidl =
+ *     { {
+ *         WASHER_PIDL_LITERAL_ITEM(root_item, { 'R', 'O', 'O', 'T' }),
+ *         { 0 }
+ *     } };
+ *
+ * C++03 gives an aggregate no way to fill in the size fields itself, and
+ * no way to check an initialiser at compile time.  Write each item with
+ * WASHER_PIDL_LITERAL_ITEM, which fills in the size from the payload type,
+ * rather than initialising the size by hand.  Debug builds also check the
+ * sizes whenever the literal is used, in case the payload type given to
+ * the macro isn't the one in the literal's type.
+ */
+
+/**
+ * Initialiser for one item of a PIDL literal: its size field, calculated
+ * from @a payload_type, followed by the payload's initialiser.
+ */
+#define WASHER_PIDL_LITERAL_ITEM(payload_type, ...) \
+    { ::washer::shell::pidl::pidl_literal_item< payload_type >::item_size, \
+      __VA_ARGS__ }
+
+#pragma pack(push, 1)
+
+/**
+ * One item of a PIDL literal.
+ *
+ * @tparam Payload  POD type of the item's data.  The item holds exactly
+ *                  @c sizeof(Payload) bytes of data.
+ */
+template<typename Payload>
+struct pidl_literal_item
+{
+    enum { item_size = sizeof(USHORT) + sizeof(Payload) };
+
+    USHORT cb; ///< Must be @c item_size; use WASHER_PIDL_LITERAL_ITEM
+    Payload data;
+};
+
+/**
+ * Null-terminator ending the items of a PIDL literal.
+ */
+struct pidl_literal_terminator
+{
+    enum { depth = 0 };
+
+    USHORT cb; ///< Must be initialised to 0
+};
+
+/**
+ * Items of a PIDL literal as a list of payload types.
+ *
+ * @tparam Head  Payload type of the first item.
+ * @tparam Tail  Remaining items: either another pidl_literal_items or the
+ *               pidl_literal_terminator.
+ */
+template<typename Head, typename Tail=pidl_literal_terminator>
+struct pidl_literal_items
+{
+    enum { depth = 1 + Tail::depth };
+
+    pidl_literal_item<Head> head;
+    Tail tail;
+};
+
+/**
+ * PIDL of type @a T held in static storage.
+ *
+ * Converts implicitly to <code>const T*</code> so the literal can be passed
+ * wherever a raw PIDL is accepted.  Function templates that deduce the
+ * PIDL type need get().
+ *
+ * @tparam T      ITEMID_CHILD, ITEMIDLIST_RELATIVE or ITEMIDLIST_ABSOLUTE.
+ * @tparam Items  The items as a pidl_literal_items list.
+ */
+template<typename T, typename Items>
+struct basic_pidl_literal
+{
+    BOOST_STATIC_ASSERT(
+        static_cast<size_t>(Items::depth) <= raw_pidl::traits<T>::max_depth);
+
+    typedef T value_type;
+
+    Items items;
+
+    const T* get() const
+    {
+        const T* pidl = reinterpret_cast<const T*>(&items);
+        assert(raw_pidl::size(pidl) == sizeof(Items) ||
+            !"PIDL literal initialised with the wrong item sizes");
+        return pidl;
+    }
+
+    operator const T*() const
+    {
+        return get();
+    }
+
+    /**
+     * Size of the PIDL in bytes, including the null-terminator.
+     *
+     * Unlike raw_pidl::size, this does not walk the PIDL.
+     */
+    static size_t size()
+    {
+        return sizeof(Items);
+    }
+
+    /**
+     * Number of items in the PIDL.
+     */
+    static size_t depth()
+    {
+        return Items::depth;
+    }
+};
+
+#pragma pack(pop)
+
+namespace detail {
+
+    template<
+        typename P1, typename P2, typename P3, typename P4, typename P5,
+        typename P6>
+    struct make_literal_items
+    {
+        BOOST_STATIC_ASSERT(
+            static_cast<size_t>(pidl_literal_item<P1>::item_size) <=
+            USHRT_MAX);
+
+        typedef pidl_literal_items<
+            P1,
+            typename make_literal_items<P2, P3, P4, P5, P6, void>::type> type;
+    };
+
+    template<>
+    struct make_literal_items<void, void, void, void, void, void>
+    {
+        typedef pidl_literal_terminator type;
+    };
+}
+
+/**
+ * @name  PIDL literal types for up to six items.
+ *
+ * Longer literals can name their pidl_literal_items list directly.
+ */
+// @{
+template<typename Payload>
+struct child_pidl_literal
+{
+    typedef basic_pidl_literal<
+        ITEMID_CHILD,
+        typename detail::make_literal_items<
+            Payload, void, void, void, void, void>::type> type;
+};
+
+template<
+    typename P1, typename P2=void, typename P3=void, typename P4=void,
+    typename P5=void, typename P6=void>
+struct relative_pidl_literal
+{
+    typedef basic_pidl_literal<
+        ITEMIDLIST_RELATIVE,
+        typename detail::make_literal_items<P1, P2, P3, P4, P5, P6>::type>
+        type;
+};
+
+template<
+    typename P1, typename P2=void, typename P3=void, typename P4=void,
+    typename P5=void, typename P6=void>
+struct absolute_pidl_literal
+{
+    typedef basic_pidl_literal<
+        ITEMIDLIST_ABSOLUTE,
+        typename detail::make_literal_items<P1, P2, P3, P4, P5, P6>::type>
+        type;
+};
+// @}
+
+}}} // namespace washer::shell::pidl
+
+#endif
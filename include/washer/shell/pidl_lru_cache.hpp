@@ -0,0 +1,578 @@
+/**
+    @file
+
+    Bounded cache of values keyed on absolute PIDLs.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_PIDL_LRU_CACHE_HPP
+#define WASHER_SHELL_PIDL_LRU_CACHE_HPP
+#pragma once
+
+#include <washer/shell/pidl.hpp> // apidl_t, apidl_view, raw_pidl
+#include <washer/shell/pidl_trie.hpp> // apidl_trie
+
+#include <boost/functional/hash.hpp> // hash, hash_combine
+#include <boost/noncopyable.hpp> // noncopyable
+#include <boost/unordered_set.hpp> // unordered_set
+
+#include <algorithm> // find
+#include <cassert> // assert
+#include <cstddef> // size_t
+#include <cstring> // memcmp
+#include <list>
+#include <vector>
+
+namespace washer {
+namespace shell {
+
+/**
+ * How well a pidl_lru_cache is working.
+ */
+struct pidl_lru_cache_statistics
+{
+    std::size_t hits; ///< Lookups answered from the cache
+    std::size_t misses; ///< Lookups the cache couldn't answer
+    std::size_t evictions; ///< Values dropped to make room for newer ones
+};
+
+/**
+ * Removal callback that lets values be destroyed with their entries.
+ */
+struct discard_removed_values
+{
+    template<typename K, typename V>
+    void operator()(const K&, V&) const {}
+};
+
+/**
+ * Bounded cache of values keyed on an absolute PIDL together with a
+ * secondary key of type @a K that distinguishes different values for the
+ * same item.
+ *
+ * Looking up a value hashes the caller's PIDL, or view of a PIDL, in a
+ * single pass without copying it.  When full, the cache forgets the least
+ * recently used value to make room for a new one.
+ *
+ * Values are kept until evicted or explicitly forgotten.  invalidate()
+ * forgets the values of one item, whatever their secondary key, and
+ * invalidate_subtree() also forgets those of every item below it.  The
+ * items are indexed by a PIDL trie so invalidating a subtree only visits
+ * the values in it.
+ *
+ * Operations that remove values take an optional callback, called as
+ * <code>f(const K&, V&)</code> on each value just before its entry is
+ * destroyed, so that the value can be moved somewhere else to be disposed
+ * of.
+ *
+ * The cache is not thread-safe.
+ *
+ * @tparam K  Secondary key.  Must be copyable, equality-comparable and
+ *            hashable by boost::hash.
+ * @tparam V  Cached value.  Must be copyable.
+ */
+template<typename K, typename V>
+class pidl_lru_cache : private boost::noncopyable
+{
+public:
+
+    typedef K key_type;
+    typedef V value_type;
+
+    /**
+     * An empty cache that will hold at most @a capacity values.
+     *
+     * A cache with no capacity never holds anything but still counts
+     * misses.
+     */
+    explicit pidl_lru_cache(std::size_t capacity) : m_capacity(capacity)
+    {
+        m_statistics.hits = 0;
+        m_statistics.misses = 0;
+        m_statistics.evictions = 0;
+    }
+
+    /**
+     * The cached value for the given item, if any.
+     *
+     * Finding the value makes it the most recently used.
+     *
+     * @returns  Pointer to the value, valid until the cache is next changed,
+     *           or NULL if there is no such value.
+     */
+    V* find(PCIDLIST_ABSOLUTE pidl, const K& key)
+    {
+        return find(lookup_key(pidl, key));
+    }
+
+    template<typename Alloc>
+    V* find(
+        const pidl::basic_pidl<ITEMIDLIST_ABSOLUTE, Alloc>& pidl,
+        const K& key)
+    {
+        return find(pidl.get(), key);
+    }
+
+    /**
+     * The cached value for the item viewed, if any.
+     *
+     * The view doesn't have to be terminated so, for example, the parent of
+     * a PIDL can be looked up without copying it out.
+     */
+    V* find(const pidl::apidl_view& pidl, const K& key)
+    {
+        return find(lookup_key(pidl, key));
+    }
+
+    /**
+     * Remember the value for the given item, replacing any value already
+     * cached for it.
+     *
+     * The value becomes the most recently used.  If the cache is full, the
+     * least recently used value is forgotten.
+     *
+     * @param removed  Called on the replaced or evicted value, if any.
+     */
+    template<typename F>
+    void insert(
+        PCIDLIST_ABSOLUTE pidl, const K& key, const V& value, F removed)
+    {
+        if (m_capacity == 0)
+            return;
+
+        lookup_key lookup(pidl, key);
+        typename index_type::iterator pos =
+            m_index.find(lookup, entry_hash(), entry_equal());
+        if (pos != m_index.end())
+        {
+            V replacement(value);
+            removed((*pos)->key, (*pos)->value);
+            std::swap((*pos)->value, replacement);
+            touch(*pos);
+            return;
+        }
+
+        add(pidl, lookup, value);
+
+        if (m_index.size() > m_capacity)
+        {
+            entry_iterator oldest = --m_entries.end();
+            removed(oldest->key, oldest->value);
+            forget(oldest);
+            ++m_statistics.evictions;
+        }
+    }
+
+    void insert(PCIDLIST_ABSOLUTE pidl, const K& key, const V& value)
+    {
+        insert(pidl, key, value, discard_removed_values());
+    }
+
+    template<typename Alloc>
+    void insert(
+        const pidl::basic_pidl<ITEMIDLIST_ABSOLUTE, Alloc>& pidl,
+        const K& key, const V& value)
+    {
+        insert(pidl.get(), key, value, discard_removed_values());
+    }
+
+    /**
+     * Forget every value cached for the given item.
+     *
+     * Values for items below it are kept.
+     *
+     * @returns  Number of values forgotten.
+     */
+    template<typename F>
+    std::size_t invalidate(PCIDLIST_ABSOLUTE pidl, F removed)
+    {
+        entry_references* references = m_by_pidl.find(pidl);
+        if (!references)
+            return 0;
+
+        std::size_t forgotten =
+            forget_references<F>(*this, removed)(pidl, *references);
+        m_by_pidl.erase(pidl);
+        return forgotten;
+    }
+
+    std::size_t invalidate(PCIDLIST_ABSOLUTE pidl)
+    {
+        return invalidate(pidl, discard_removed_values());
+    }
+
+    template<typename Alloc>
+    std::size_t invalidate(
+        const pidl::basic_pidl<ITEMIDLIST_ABSOLUTE, Alloc>& pidl)
+    {
+        return invalidate(pidl.get(), discard_removed_values());
+    }
+
+    /**
+     * Forget every value cached for the given item and for all items below
+     * it.
+     *
+     * @returns  Number of values forgotten.
+     */
+    template<typename F>
+    std::size_t invalidate_subtree(PCIDLIST_ABSOLUTE pidl, F removed)
+    {
+        std::size_t forgotten = 0;
+        m_by_pidl.for_each(
+            pidl, counting_forget_references<F>(*this, removed, forgotten));
+        m_by_pidl.invalidate(pidl);
+        return forgotten;
+    }
+
+    std::size_t invalidate_subtree(PCIDLIST_ABSOLUTE pidl)
+    {
+        return invalidate_subtree(pidl, discard_removed_values());
+    }
+
+    template<typename Alloc>
+    std::size_t invalidate_subtree(
+        const pidl::basic_pidl<ITEMIDLIST_ABSOLUTE, Alloc>& pidl)
+    {
+        return invalidate_subtree(pidl.get(), discard_removed_values());
+    }
+
+    /**
+     * Forget every value whose secondary key matches a predicate.
+     *
+     * This visits every value in the cache.
+     *
+     * @returns  Number of values forgotten.
+     */
+    template<typename P, typename F>
+    std::size_t erase_if(P predicate, F removed)
+    {
+        std::size_t forgotten = 0;
+        entry_iterator it = m_entries.begin();
+        while (it != m_entries.end())
+        {
+            entry_iterator current = it++;
+            if (predicate(current->key))
+            {
+                removed(current->key, current->value);
+                forget(current);
+                ++forgotten;
+            }
+        }
+
+        return forgotten;
+    }
+
+    /**
+     * Forget every value.
+     *
+     * The statistics are kept.
+     */
+    template<typename F>
+    void clear(F removed)
+    {
+        for (entry_iterator it = m_entries.begin(); it != m_entries.end();
+             ++it)
+        {
+            removed(it->key, it->value);
+        }
+
+        m_index.clear();
+        m_entries.clear();
+        m_by_pidl.clear();
+    }
+
+    void clear()
+    {
+        clear(discard_removed_values());
+    }
+
+    /**
+     * Number of values cached.
+     */
+    std::size_t size() const
+    {
+        return m_index.size();
+    }
+
+    bool empty() const
+    {
+        return m_index.empty();
+    }
+
+    std::size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    pidl_lru_cache_statistics statistics() const
+    {
+        return m_statistics;
+    }
+
+private:
+
+    struct entry
+    {
+        entry(
+            PCIDLIST_ABSOLUTE pidl, std::size_t item_bytes, const K& key,
+            std::size_t hash, const V& value)
+            : item(pidl), item_bytes(item_bytes), key(key), hash(hash),
+              value(value) {}
+
+        pidl::apidl_t item;
+        std::size_t item_bytes; ///< Size of item excluding terminator
+        K key;
+        std::size_t hash;
+        V value;
+    };
+
+    /**
+     * Most recently used first.
+     */
+    typedef std::list<entry> entry_list;
+    typedef typename entry_list::iterator entry_iterator;
+
+    /**
+     * The entries for one PIDL: one per secondary key it was cached with.
+     */
+    typedef std::vector<entry_iterator> entry_references;
+
+    /**
+     * Item to look up without copying its PIDL first.
+     *
+     * The PIDL is measured and hashed in the same pass.
+     */
+    struct lookup_key
+    {
+        lookup_key(PCIDLIST_ABSOLUTE pidl, const K& key)
+            : items(pidl), item_bytes(0), key(key)
+        {
+            pidl::detail::pidl_hasher hasher;
+            for (const ITEMIDLIST_ABSOLUTE __unaligned* item = pidl;
+                 !pidl::raw_pidl::empty(item);
+                 item = pidl::raw_pidl::next(item))
+            {
+                hasher.add_item(item, item->mkid.cb);
+                item_bytes += item->mkid.cb;
+            }
+
+            hash = hasher.value();
+            boost::hash_combine(hash, key);
+        }
+
+        lookup_key(const pidl::apidl_view& view, const K& key)
+            : items(view.data()), item_bytes(view.item_bytes()), key(key),
+              hash(hash_value(view))
+        {
+            boost::hash_combine(hash, key);
+        }
+
+        const ITEMIDLIST_ABSOLUTE __unaligned* items;
+        std::size_t item_bytes;
+        const K& key;
+        std::size_t hash;
+    };
+
+    struct entry_hash
+    {
+        std::size_t operator()(const entry_iterator& entry) const
+        {
+            return entry->hash;
+        }
+
+        std::size_t operator()(const lookup_key& key) const
+        {
+            return key.hash;
+        }
+    };
+
+    struct entry_equal
+    {
+        bool operator()(
+            const entry_iterator& lhs, const entry_iterator& rhs) const
+        {
+            return lhs == rhs;
+        }
+
+        bool operator()(
+            const lookup_key& key, const entry_iterator& entry) const
+        {
+            return key.hash == entry->hash &&
+                key.item_bytes == entry->item_bytes &&
+                key.key == entry->key &&
+                std::memcmp(
+                    key.items, entry->item.get(), key.item_bytes) == 0;
+        }
+
+        bool operator()(
+            const entry_iterator& entry, const lookup_key& key) const
+        {
+            return (*this)(key, entry);
+        }
+    };
+
+    typedef boost::unordered_set<entry_iterator, entry_hash, entry_equal>
+        index_type;
+
+    /**
+     * Forgets the values of a PIDL in the trie, leaving the trie itself to
+     * the caller.
+     */
+    template<typename F>
+    class forget_references
+    {
+    public:
+        forget_references(pidl_lru_cache& cache, F removed)
+            : m_cache(&cache), m_removed(removed) {}
+
+        std::size_t operator()(
+            PCIDLIST_ABSOLUTE, entry_references& references)
+        {
+            std::size_t forgotten = 0;
+            while (!references.empty())
+            {
+                entry_iterator entry = references.back();
+                m_removed(entry->key, entry->value);
+
+                references.pop_back();
+                m_cache->m_index.erase(entry);
+                m_cache->m_entries.erase(entry);
+                ++forgotten;
+            }
+
+            return forgotten;
+        }
+
+    private:
+        pidl_lru_cache* m_cache;
+        F m_removed;
+    };
+
+    template<typename F>
+    class counting_forget_references
+    {
+    public:
+        counting_forget_references(
+            pidl_lru_cache& cache, F removed, std::size_t& forgotten)
+            : m_forget(cache, removed), m_forgotten(&forgotten) {}
+
+        void operator()(
+            PCIDLIST_ABSOLUTE pidl, entry_references& references)
+        {
+            *m_forgotten += m_forget(pidl, references);
+        }
+
+    private:
+        forget_references<F> m_forget;
+        std::size_t* m_forgotten;
+    };
+
+    V* find(const lookup_key& key)
+    {
+        typename index_type::iterator pos =
+            m_index.find(key, entry_hash(), entry_equal());
+        if (pos == m_index.end())
+        {
+            ++m_statistics.misses;
+            return NULL;
+        }
+
+        ++m_statistics.hits;
+        touch(*pos);
+        return &(*pos)->value;
+    }
+
+    /**
+     * Make an entry the most recently used.
+     */
+    void touch(entry_iterator entry)
+    {
+        m_entries.splice(m_entries.begin(), m_entries, entry);
+    }
+
+    /**
+     * Add a new entry as the most recently used, undoing the addition if
+     * any part of it fails.
+     */
+    void add(PCIDLIST_ABSOLUTE pidl, const lookup_key& key, const V& value)
+    {
+        m_entries.push_front(
+            entry(pidl, key.item_bytes, key.key, key.hash, value));
+        entry_iterator added = m_entries.begin();
+
+        try
+        {
+            m_index.insert(added);
+
+            try
+            {
+                m_by_pidl[pidl].push_back(added);
+            }
+            catch (...)
+            {
+                m_index.erase(added);
+                throw;
+            }
+        }
+        catch (...)
+        {
+            entry_references* references = m_by_pidl.find(pidl);
+            if (references && references->empty())
+                m_by_pidl.erase(pidl);
+
+            m_entries.pop_front();
+            throw;
+        }
+    }
+
+    /**
+     * Remove a single entry from every structure that refers to it.
+     */
+    void forget(entry_iterator entry)
+    {
+        entry_references* references = m_by_pidl.find(entry->item);
+        assert(references);
+
+        references->erase(
+            std::find(references->begin(), references->end(), entry));
+        if (references->empty())
+            m_by_pidl.erase(entry->item);
+
+        m_index.erase(entry);
+        m_entries.erase(entry);
+    }
+
+    std::size_t m_capacity;
+    entry_list m_entries;
+    index_type m_index;
+    typename pidl::apidl_trie<entry_references>::type m_by_pidl;
+    pidl_lru_cache_statistics m_statistics;
+};
+
+}} // namespace washer::shell
+
+#endif
@@ -0,0 +1,470 @@
+/**
+    @file
+
+    Memory-mapped on-disk storage for collections of PIDLs.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_PIDL_STORE_HPP
+#define WASHER_SHELL_PIDL_STORE_HPP
+#pragma once
+
+#include <washer/detail/file_mapping.hpp> // read_only_file_mapping
+#include <washer/shell/pidl.hpp> // basic_pidl, basic_pidl_view, raw_pidl
+
+#include <boost/cstdint.hpp> // uint32_t, uint64_t
+#include <boost/filesystem/fstream.hpp> // ofstream
+#include <boost/filesystem/path.hpp> // path
+#include <boost/iterator/iterator_facade.hpp> // iterator_facade
+#include <boost/noncopyable.hpp> // noncopyable
+#include <boost/static_assert.hpp> // BOOST_STATIC_ASSERT
+#include <boost/throw_exception.hpp> // BOOST_THROW_EXCEPTION
+
+#include <cassert> // assert
+#include <cstddef> // size_t, ptrdiff_t
+#include <cstring> // memcpy
+#include <ios> // ios_base
+#include <stdexcept> // invalid_argument, logic_error, runtime_error etc.
+#include <vector>
+
+namespace washer {
+namespace shell {
+namespace pidl {
+
+namespace detail {
+
+    /**
+     * Start of a PIDL store file.
+     *
+     * The rest of the file is laid out as:
+     *
+     *  - the PIDLs, one after another, each with its own null-terminator;
+     *  - zero padding to an 8-byte boundary;
+     *  - the offset table: one 64-bit file offset per PIDL, plus one more
+     *    giving the end of the last PIDL.
+     *
+     * The table comes after the PIDLs, and the header records where it
+     * starts, so that a writer can stream PIDLs straight to disk as they are
+     * appended.  All integers are in the byte order of the machine that wrote
+     * the file; a file written with the other byte order fails the magic
+     * number check.
+     */
+    struct pidl_store_header
+    {
+        boost::uint32_t magic; ///< Always pidl_store_magic
+        boost::uint32_t version; ///< Format version
+        boost::uint64_t count; ///< Number of PIDLs in the store
+        boost::uint64_t table_offset; ///< File offset of the offset table.
+                                      ///< Zero if the writer never finished.
+    };
+
+    BOOST_STATIC_ASSERT(sizeof(pidl_store_header) == 24);
+
+    const boost::uint32_t pidl_store_magic = 0x44495057; // "WPID"
+    const boost::uint32_t pidl_store_version = 1;
+
+    const std::size_t pidl_store_table_alignment = sizeof(boost::uint64_t);
+
+    inline void throw_corrupt_pidl_store()
+    {
+        BOOST_THROW_EXCEPTION(std::runtime_error("Corrupt PIDL store"));
+    }
+}
+
+/**
+ * Read access to a file of PIDLs written by basic_pidl_store_writer.
+ *
+ * The file is memory-mapped and the PIDLs are never copied; each is handed
+ * out as a view of (or raw pointer to) the null-terminated PIDL in the
+ * mapping, so they work directly with raw_pidl functions and the PIDL
+ * iterators.  They remain valid for the lifetime of the reader.
+ *
+ * Opening the store checks the header and offset table, and walks the items
+ * of each PIDL to make sure none strays outside its slot.  Walking only
+ * visits the item headers, so this is much cheaper than copying the PIDLs
+ * and means a corrupt file cannot lead to reading outside the mapping.
+ */
+template<typename T>
+class basic_pidl_store_reader : private boost::noncopyable
+{
+public:
+
+    typedef basic_pidl_view<T> value_type;
+
+    class const_iterator : public boost::iterator_facade<
+        const_iterator, basic_pidl_view<T>,
+        boost::random_access_traversal_tag, basic_pidl_view<T> >
+    {
+    public:
+
+        const_iterator() : m_store(NULL), m_position(0) {}
+
+    private:
+        friend class boost::iterator_core_access;
+        friend class basic_pidl_store_reader;
+
+        const_iterator(
+            const basic_pidl_store_reader* store, std::size_t position)
+            : m_store(store), m_position(position) {}
+
+        basic_pidl_view<T> dereference() const
+        {
+            return (*m_store)[m_position];
+        }
+
+        bool equal(const const_iterator& other) const
+        {
+            return m_store == other.m_store && m_position == other.m_position;
+        }
+
+        void increment() { ++m_position; }
+        void decrement() { --m_position; }
+        void advance(std::ptrdiff_t n) { m_position += n; }
+
+        std::ptrdiff_t distance_to(const const_iterator& other) const
+        {
+            return static_cast<std::ptrdiff_t>(other.m_position) -
+                static_cast<std::ptrdiff_t>(m_position);
+        }
+
+        const basic_pidl_store_reader* m_store;
+        std::size_t m_position;
+    };
+
+    /**
+     * Open and check a PIDL store.
+     *
+     * @throws std::runtime_error if the file is not a complete, valid store.
+     */
+    explicit basic_pidl_store_reader(const boost::filesystem::path& file)
+        : m_file(file), m_offsets(NULL), m_count(0)
+    {
+        validate();
+    }
+
+    /**
+     * Number of PIDLs in the store.
+     */
+    std::size_t size() const
+    {
+        return m_count;
+    }
+
+    bool empty() const
+    {
+        return m_count == 0;
+    }
+
+    /**
+     * Null-terminated raw PIDL at the given position.
+     */
+    const T __unaligned* get(std::size_t i) const
+    {
+        assert(i < m_count);
+        return reinterpret_cast<const T __unaligned*>(
+            m_file.data() + m_offsets[i]);
+    }
+
+    /**
+     * Size in bytes, including the null-terminator, of the PIDL at the given
+     * position.
+     *
+     * Unlike raw_pidl::size, this doesn't walk the PIDL.
+     */
+    std::size_t pidl_size(std::size_t i) const
+    {
+        assert(i < m_count);
+        return static_cast<std::size_t>(m_offsets[i + 1] - m_offsets[i]);
+    }
+
+    /**
+     * View of the PIDL at the given position.
+     */
+    basic_pidl_view<T> operator[](std::size_t i) const
+    {
+        return basic_pidl_view<T>(get(i));
+    }
+
+    /**
+     * View of the PIDL at the given position with bounds checking.
+     */
+    basic_pidl_view<T> at(std::size_t i) const
+    {
+        if (i >= m_count)
+            BOOST_THROW_EXCEPTION(
+                std::out_of_range("Position is past the end of the store"));
+
+        return (*this)[i];
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(this, m_count);
+    }
+
+private:
+
+    void validate()
+    {
+        if (m_file.size() < sizeof(detail::pidl_store_header))
+            BOOST_THROW_EXCEPTION(std::runtime_error("Not a PIDL store"));
+
+        detail::pidl_store_header header;
+        std::memcpy(&header, m_file.data(), sizeof(header));
+
+        if (header.magic != detail::pidl_store_magic)
+            BOOST_THROW_EXCEPTION(std::runtime_error("Not a PIDL store"));
+        if (header.version != detail::pidl_store_version)
+            BOOST_THROW_EXCEPTION(
+                std::runtime_error("Unsupported PIDL store version"));
+        if (header.table_offset == 0)
+            BOOST_THROW_EXCEPTION(
+                std::runtime_error("Incomplete PIDL store"));
+
+        // Check the table fits before trusting the count
+        boost::uint64_t file_size = m_file.size();
+        if (header.table_offset < sizeof(header) ||
+            header.table_offset > file_size ||
+            header.table_offset % detail::pidl_store_table_alignment != 0 ||
+            (file_size - header.table_offset) / sizeof(boost::uint64_t) <=
+                header.count)
+            detail::throw_corrupt_pidl_store();
+
+        m_count = static_cast<std::size_t>(header.count);
+        m_offsets = reinterpret_cast<const boost::uint64_t*>(
+            m_file.data() + header.table_offset);
+
+        if (m_offsets[0] != sizeof(header) ||
+            m_offsets[m_count] > header.table_offset)
+            detail::throw_corrupt_pidl_store();
+
+        for (std::size_t i = 0; i < m_count; ++i)
+        {
+            if (m_offsets[i + 1] < m_offsets[i])
+                detail::throw_corrupt_pidl_store();
+
+            validate_pidl(i);
+        }
+    }
+
+    /**
+     * Make sure walking the PIDL's items lands exactly on a null-terminator
+     * at the end of its slot.
+     */
+    void validate_pidl(std::size_t i) const
+    {
+        std::size_t slot = pidl_size(i);
+
+        raw_pidl::measurement measured;
+        try
+        {
+            measured = raw_pidl::validate(get(i), slot);
+        }
+        catch (const std::invalid_argument&)
+        {
+            detail::throw_corrupt_pidl_store();
+        }
+
+        if (measured.size != slot)
+            detail::throw_corrupt_pidl_store();
+    }
+
+    washer::detail::read_only_file_mapping m_file;
+    const boost::uint64_t* m_offsets;
+    std::size_t m_count;
+};
+
+/**
+ * Writes a collection of PIDLs to a file that basic_pidl_store_reader can
+ * map.
+ *
+ * PIDLs are written to the file as they are appended; only their offsets
+ * (8 bytes per PIDL) are kept in memory until commit() writes them out as
+ * the offset table and fills in the header.  A store whose writer was
+ * destroyed without committing is marked incomplete and won't open.
+ *
+ * Stream failures are reported by throwing std::ios_base::failure.
+ */
+template<typename T>
+class basic_pidl_store_writer : private boost::noncopyable
+{
+public:
+
+    /**
+     * Create a new store, replacing any existing file.
+     */
+    explicit basic_pidl_store_writer(const boost::filesystem::path& file)
+        : m_position(sizeof(detail::pidl_store_header)), m_committed(false)
+    {
+        m_stream.exceptions(std::ios_base::badbit | std::ios_base::failbit);
+        m_stream.open(
+            file, std::ios_base::out | std::ios_base::binary |
+            std::ios_base::trunc);
+
+        write_header(0);
+    }
+
+    /**
+     * Append a raw PIDL.
+     *
+     * NULL PIDLs are stored as empty PIDLs.
+     */
+    void append(const T __unaligned* pidl)
+    {
+        raw_pidl::traits<T>::type_check(pidl);
+
+        std::size_t size = raw_pidl::size(pidl);
+        if (size)
+            append_bytes(pidl, size - sizeof(USHORT));
+        else
+            append_bytes(NULL, 0);
+    }
+
+    /**
+     * Append a wrapped PIDL.
+     */
+    template<typename Alloc>
+    void append(const basic_pidl<T, Alloc>& pidl)
+    {
+        append(pidl.get());
+    }
+
+    /**
+     * Append the items of a view.
+     *
+     * The view doesn't have to be terminated.
+     */
+    void append(const basic_pidl_view<T>& view)
+    {
+        append_bytes(view.data(), view.item_bytes());
+    }
+
+    /**
+     * Number of PIDLs appended so far.
+     */
+    std::size_t size() const
+    {
+        return m_offsets.size();
+    }
+
+    /**
+     * Finish writing the store.
+     *
+     * Writes the offset table and header, then closes the file.  Nothing
+     * can be appended afterwards.
+     */
+    void commit()
+    {
+        check_not_committed();
+
+        std::size_t padding = (detail::pidl_store_table_alignment -
+            m_position % detail::pidl_store_table_alignment) %
+            detail::pidl_store_table_alignment;
+        const char zeros[detail::pidl_store_table_alignment] = {0};
+        m_stream.write(zeros, padding);
+
+        boost::uint64_t table_offset = m_position + padding;
+
+        m_offsets.push_back(m_position);
+        try
+        {
+            m_stream.write(
+                reinterpret_cast<const char*>(&m_offsets[0]),
+                m_offsets.size() * sizeof(m_offsets[0]));
+        }
+        catch (...)
+        {
+            m_offsets.pop_back();
+            throw;
+        }
+        m_offsets.pop_back();
+
+        m_stream.seekp(0);
+        write_header(table_offset);
+        m_stream.close();
+
+        m_committed = true;
+    }
+
+private:
+
+    void append_bytes(const void __unaligned* items, std::size_t item_bytes)
+    {
+        check_not_committed();
+
+        const USHORT terminator = 0;
+        if (item_bytes)
+            m_stream.write(reinterpret_cast<const char*>(items), item_bytes);
+        m_stream.write(
+            reinterpret_cast<const char*>(&terminator), sizeof(terminator));
+
+        m_offsets.push_back(m_position);
+        m_position += item_bytes + sizeof(terminator);
+    }
+
+    void write_header(boost::uint64_t table_offset)
+    {
+        detail::pidl_store_header header;
+        header.magic = detail::pidl_store_magic;
+        header.version = detail::pidl_store_version;
+        header.count = m_offsets.size();
+        header.table_offset = table_offset;
+
+        m_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    void check_not_committed() const
+    {
+        if (m_committed)
+            BOOST_THROW_EXCEPTION(
+                std::logic_error("PIDL store has already been committed"));
+    }
+
+    boost::filesystem::ofstream m_stream;
+    std::vector<boost::uint64_t> m_offsets;
+    boost::uint64_t m_position; ///< Where the next PIDL will be written
+    bool m_committed;
+};
+
+/**
+ * @name  Standard PIDL store types.
+ */
+// @{
+typedef basic_pidl_store_reader<ITEMIDLIST_ABSOLUTE> apidl_store_reader;
+typedef basic_pidl_store_writer<ITEMIDLIST_ABSOLUTE> apidl_store_writer;
+typedef basic_pidl_store_reader<ITEMIDLIST_RELATIVE> pidl_store_reader;
+typedef basic_pidl_store_writer<ITEMIDLIST_RELATIVE> pidl_store_writer;
+// @}
+
+}}} // namespace washer::shell::pidl
+
+#endif
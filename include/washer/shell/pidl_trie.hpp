@@ -0,0 +1,710 @@
+/**
+    @file
+
+    Prefix tree of values keyed by PIDLs.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_PIDL_TRIE_HPP
+#define WASHER_SHELL_PIDL_TRIE_HPP
+#pragma once
+
+#include <washer/shell/pidl.hpp> // raw_pidl, basic_pidl
+#include <washer/shell/pidl_iterator.hpp> // raw_pidl_iterator
+
+#include <boost/functional/hash.hpp> // hash_combine
+#include <boost/noncopyable.hpp> // noncopyable
+#include <boost/optional.hpp> // optional
+#include <boost/pool/pool.hpp> // pool
+#include <boost/shared_ptr.hpp> // shared_ptr
+#include <boost/throw_exception.hpp> // BOOST_THROW_EXCEPTION
+#include <boost/unordered_set.hpp> // unordered_set
+
+#include <algorithm> // min
+#include <cstring> // memcpy, memcmp
+#include <exception> // bad_alloc
+#include <new> // placement new
+#include <vector>
+
+namespace washer {
+namespace shell {
+namespace pidl {
+
+namespace detail {
+
+    /**
+     * Node of a PIDL trie: one item of the PIDLs below it.
+     *
+     * The children of a node are a doubly-linked list so that a subtree can
+     * be walked, or cut out, without recursion.
+     *
+     * The node's item (its label) is stored straight after the node in the
+     * same allocation, which must be allocation_size() bytes.
+     */
+    template<typename V>
+    struct pidl_trie_node : private boost::noncopyable
+    {
+        static size_t allocation_size(USHORT label_size)
+        {
+            return sizeof(pidl_trie_node) + label_size;
+        }
+
+        /**
+         * Node for the first item of @a item, or the root node if NULL.
+         */
+        pidl_trie_node(
+            pidl_trie_node* parent, PCUIDLIST_RELATIVE item, size_t hash)
+            : parent(parent), first_child(NULL), previous_sibling(NULL),
+              next_sibling(NULL), label_size(0), hash(hash)
+        {
+            if (item)
+            {
+                label_size = item->mkid.cb;
+                std::memcpy(label(), item, label_size);
+            }
+        }
+
+        /**
+         * The item, including its cb.
+         */
+        BYTE* label()
+        {
+            return reinterpret_cast<BYTE*>(this + 1);
+        }
+
+        const BYTE* label() const
+        {
+            return reinterpret_cast<const BYTE*>(this + 1);
+        }
+
+        pidl_trie_node* parent;
+        pidl_trie_node* first_child;
+        pidl_trie_node* previous_sibling;
+        pidl_trie_node* next_sibling;
+
+        USHORT label_size;
+        size_t hash; ///< Hash of the label and parent
+        boost::optional<V> value;
+    };
+}
+
+/**
+ * Map from PIDLs to values that keeps PIDLs sharing a prefix together.
+ *
+ * Each node of the tree is one item (SHITEMID) of the PIDLs stored below
+ * it, so a PIDL's value lives at the end of the path spelled out by its
+ * items.  Inserting or finding a PIDL walks its items once, costing
+ * O(depth) hash lookups however many PIDLs the trie holds.  Unlike a hashed
+ * map, everything at or below a given PIDL can be enumerated or thrown away
+ * without visiting anything else.  That is what caches keyed by absolute
+ * PIDLs need when a folder is renamed or deleted.
+ *
+ * Nodes are allocated from pools owned by the trie and freed back to them
+ * as soon as nothing is stored at or below them.  Each node holds a copy of
+ * its item at the end of its own allocation, so there is one pooled
+ * allocation per node.  As items vary in size, there is a pool for each
+ * size class of node, allocated in steps of a few bytes.  Finding a child
+ * is one lookup in a single hash table of all the edges in the trie, keyed
+ * by parent node and item bytes.
+ *
+ * PIDLs are compared byte-for-byte, item by item.  NULL and empty PIDLs
+ * are the same key: the root.
+ *
+ * The trie is not thread-safe.
+ */
+template<typename T, typename V>
+class basic_pidl_trie : private boost::noncopyable
+{
+    typedef detail::pidl_trie_node<V> node;
+
+public:
+
+    typedef V mapped_type;
+
+    basic_pidl_trie() : m_root(NULL), m_size(0)
+    {
+        m_root = create_node(NULL, NULL, 0);
+    }
+
+    ~basic_pidl_trie()
+    {
+        destroy_subtree(m_root);
+    }
+
+    /**
+     * Store a value for a PIDL unless it already has one.
+     *
+     * @returns  Whether the value was stored.
+     */
+    bool insert(const T __unaligned* pidl, const V& value)
+    {
+        node* n = find_or_create_node(pidl);
+        if (n->value)
+            return false;
+
+        n->value = value;
+        ++m_size;
+        return true;
+    }
+
+    template<typename Alloc>
+    bool insert(const basic_pidl<T, Alloc>& pidl, const V& value)
+    {
+        return insert(pidl.get(), value);
+    }
+
+    /**
+     * The value for a PIDL, default-constructing it if there isn't one.
+     */
+    V& operator[](const T __unaligned* pidl)
+    {
+        node* n = find_or_create_node(pidl);
+        if (!n->value)
+        {
+            n->value = V();
+            ++m_size;
+        }
+
+        return *n->value;
+    }
+
+    template<typename Alloc>
+    V& operator[](const basic_pidl<T, Alloc>& pidl)
+    {
+        return (*this)[pidl.get()];
+    }
+
+    /**
+     * The value for a PIDL or NULL if it has none.
+     */
+    V* find(const T __unaligned* pidl)
+    {
+        node* n = find_node(pidl);
+        return (n && n->value) ? n->value.get_ptr() : NULL;
+    }
+
+    template<typename Alloc>
+    V* find(const basic_pidl<T, Alloc>& pidl)
+    {
+        return find(pidl.get());
+    }
+
+    const V* find(const T __unaligned* pidl) const
+    {
+        node* n = find_node(pidl);
+        return (n && n->value) ? n->value.get_ptr() : NULL;
+    }
+
+    template<typename Alloc>
+    const V* find(const basic_pidl<T, Alloc>& pidl) const
+    {
+        return find(pidl.get());
+    }
+
+    /**
+     * Remove the value for a PIDL but keep those below it.
+     *
+     * @returns  Whether there was a value to remove.
+     */
+    bool erase(const T __unaligned* pidl)
+    {
+        node* n = find_node(pidl);
+        if (!n || !n->value)
+            return false;
+
+        n->value = boost::none;
+        --m_size;
+        prune(n);
+        return true;
+    }
+
+    template<typename Alloc>
+    bool erase(const basic_pidl<T, Alloc>& pidl)
+    {
+        return erase(pidl.get());
+    }
+
+    /**
+     * Remove the values for a PIDL and every PIDL below it.
+     *
+     * Costs O(depth) plus the size of the subtree removed.
+     *
+     * @returns  Number of values removed.
+     */
+    size_t invalidate(const T __unaligned* pidl)
+    {
+        node* n = find_node(pidl);
+        if (!n)
+            return 0;
+
+        size_t removed = count_values(n);
+
+        if (n == m_root)
+        {
+            while (m_root->first_child)
+            {
+                node* child = m_root->first_child;
+                unlink(child);
+                destroy_subtree(child);
+            }
+            m_root->value = boost::none;
+        }
+        else
+        {
+            node* parent = n->parent;
+            unlink(n);
+            destroy_subtree(n);
+            prune(parent);
+        }
+
+        m_size -= removed;
+        return removed;
+    }
+
+    template<typename Alloc>
+    size_t invalidate(const basic_pidl<T, Alloc>& pidl)
+    {
+        return invalidate(pidl.get());
+    }
+
+    /**
+     * Call @a f with each PIDL at or below the given one that has a value,
+     * and its value.
+     *
+     * @a f is called as @c f(const T* pidl, V& value).  The PIDL is rebuilt
+     * in a buffer reused for the whole walk so is only valid during the
+     * call; copy it to keep it.  @a f must not modify the trie.  PIDLs are
+     * visited parent first but siblings are in no particular order.
+     */
+    template<typename F>
+    void for_each(const T __unaligned* pidl, F f)
+    {
+        node* top = find_node(pidl);
+        if (top)
+            walk(top, pidl, f);
+    }
+
+    template<typename Alloc, typename F>
+    void for_each(const basic_pidl<T, Alloc>& pidl, F f)
+    {
+        for_each(pidl.get(), f);
+    }
+
+    /**
+     * Number of PIDLs with a value.
+     */
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    /**
+     * Number of nodes in the tree, including the root.
+     *
+     * Every node is on the path to at least one value, so this is at most
+     * one more than the total depth of the PIDLs stored.
+     */
+    size_t node_count() const
+    {
+        return m_edges.size() + 1;
+    }
+
+    /**
+     * Remove everything and return the pools' memory.
+     */
+    void clear()
+    {
+        invalidate(static_cast<const T __unaligned*>(NULL));
+
+        for (size_t i = 0; i < m_pools.size(); ++i)
+        {
+            if (m_pools[i])
+                m_pools[i]->release_memory();
+        }
+    }
+
+private:
+
+    /**
+     * Granularity of node sizes.  Each size class has its own pool, so this
+     * trades the few bytes wasted at the end of each node against the
+     * number of pools.
+     */
+    static const size_t size_class_bytes = 16;
+
+    /**
+     * Pool blocks grow up to about this size, however large the nodes, so
+     * that a few nodes with huge items don't reserve lots of memory.
+     */
+    static const size_t max_block_bytes = 64 * 1024;
+
+    /**
+     * Edge to look up without creating a node first.
+     */
+    struct edge_key
+    {
+        edge_key(const node* parent, PCUIDLIST_RELATIVE item)
+            : parent(parent), item(item), hash(edge_hash::hash(parent, item))
+        {}
+
+        const node* parent;
+        PCUIDLIST_RELATIVE item;
+        size_t hash;
+    };
+
+    struct edge_hash
+    {
+        static size_t hash(const node* parent, PCUIDLIST_RELATIVE item)
+        {
+            detail::pidl_hasher hasher;
+            hasher.add_item(item, item->mkid.cb);
+
+            size_t seed = hasher.value();
+            boost::hash_combine(seed, parent);
+            return seed;
+        }
+
+        size_t operator()(const node* n) const
+        {
+            return n->hash;
+        }
+
+        size_t operator()(const edge_key& key) const
+        {
+            return key.hash;
+        }
+    };
+
+    struct edge_equal
+    {
+        bool operator()(const node* lhs, const node* rhs) const
+        {
+            return lhs == rhs || (
+                lhs->hash == rhs->hash && lhs->parent == rhs->parent &&
+                lhs->label_size == rhs->label_size &&
+                std::memcmp(
+                    lhs->label(), rhs->label(), lhs->label_size) == 0);
+        }
+
+        bool operator()(const edge_key& key, const node* n) const
+        {
+            return key.hash == n->hash && key.parent == n->parent &&
+                key.item->mkid.cb == n->label_size &&
+                std::memcmp(key.item, n->label(), n->label_size) == 0;
+        }
+
+        bool operator()(const node* n, const edge_key& key) const
+        {
+            return (*this)(key, n);
+        }
+    };
+
+    typedef boost::unordered_set<node*, edge_hash, edge_equal> edge_set;
+
+    static size_t size_class_of(USHORT label_size)
+    {
+        return (label_size + size_class_bytes - 1) / size_class_bytes;
+    }
+
+    /**
+     * The pool for nodes whose item is the given size, created if needed.
+     */
+    boost::pool<>& pool_for(USHORT label_size)
+    {
+        size_t size_class = size_class_of(label_size);
+        if (size_class >= m_pools.size())
+            m_pools.resize(size_class + 1);
+
+        if (!m_pools[size_class])
+        {
+            size_t chunk_size = node::allocation_size(
+                static_cast<USHORT>(size_class * size_class_bytes));
+            size_t max_chunks = max_block_bytes / chunk_size;
+            if (max_chunks == 0)
+                max_chunks = 1;
+
+            m_pools[size_class].reset(
+                new boost::pool<>(
+                    chunk_size, (std::min)(size_t(32), max_chunks),
+                    max_chunks));
+        }
+
+        return *m_pools[size_class];
+    }
+
+    node* create_node(node* parent, PCUIDLIST_RELATIVE item, size_t hash)
+    {
+        boost::pool<>& pool = pool_for((item) ? item->mkid.cb : 0);
+        void* memory = pool.malloc();
+        if (!memory)
+            BOOST_THROW_EXCEPTION(std::bad_alloc());
+
+        try
+        {
+            return new (memory) node(parent, item, hash);
+        }
+        catch (...)
+        {
+            pool.free(memory);
+            throw;
+        }
+    }
+
+    void destroy_node(node* n)
+    {
+        boost::pool<>& pool = *m_pools[size_class_of(n->label_size)];
+        n->~node();
+        pool.free(n);
+    }
+
+    node* find_node(const T __unaligned* pidl) const
+    {
+        node* n = m_root;
+        for (raw_pidl_iterator it(pidl); it != raw_pidl_iterator(); ++it)
+        {
+            typename edge_set::const_iterator child = m_edges.find(
+                edge_key(n, *it), edge_hash(), edge_equal());
+            if (child == m_edges.end())
+                return NULL;
+
+            n = *child;
+        }
+
+        return n;
+    }
+
+    node* find_or_create_node(const T __unaligned* pidl)
+    {
+        node* n = m_root;
+        try
+        {
+            for (raw_pidl_iterator it(pidl); it != raw_pidl_iterator(); ++it)
+            {
+                edge_key key(n, *it);
+                typename edge_set::const_iterator child =
+                    m_edges.find(key, edge_hash(), edge_equal());
+
+                n = (child != m_edges.end()) ? *child : add_child(n, key);
+            }
+        }
+        catch (...)
+        {
+            // Nodes created on the way here lead nowhere
+            prune(n);
+            throw;
+        }
+
+        return n;
+    }
+
+    node* add_child(node* parent, const edge_key& key)
+    {
+        node* child = create_node(parent, key.item, key.hash);
+        try
+        {
+            m_edges.insert(child);
+        }
+        catch (...)
+        {
+            destroy_node(child);
+            throw;
+        }
+
+        child->next_sibling = parent->first_child;
+        if (parent->first_child)
+            parent->first_child->previous_sibling = child;
+        parent->first_child = child;
+
+        return child;
+    }
+
+    /**
+     * Detach a node, and so its subtree, from its parent and the edge set.
+     */
+    void unlink(node* n)
+    {
+        if (n->previous_sibling)
+            n->previous_sibling->next_sibling = n->next_sibling;
+        else
+            n->parent->first_child = n->next_sibling;
+
+        if (n->next_sibling)
+            n->next_sibling->previous_sibling = n->previous_sibling;
+
+        n->previous_sibling = NULL;
+        n->next_sibling = NULL;
+
+        m_edges.erase(n);
+    }
+
+    /**
+     * Free a node and everything below it.
+     *
+     * The node must already be unlinked from its parent (or be the root).
+     * The nodes below it are removed from the edge set as they go.
+     */
+    void destroy_subtree(node* top)
+    {
+        node* n = top;
+        for (;;)
+        {
+            while (n->first_child)
+            {
+                n = n->first_child;
+            }
+
+            if (n == top)
+                break;
+
+            node* parent = n->parent;
+            unlink(n);
+            destroy_node(n);
+            n = parent;
+        }
+
+        destroy_node(top);
+    }
+
+    /**
+     * Free nodes, from the given one upwards, that no longer lead to a
+     * value.
+     */
+    void prune(node* n)
+    {
+        while (n != m_root && !n->value && !n->first_child)
+        {
+            node* parent = n->parent;
+            unlink(n);
+            destroy_node(n);
+            n = parent;
+        }
+    }
+
+    /**
+     * Next node in a parent-first walk of the subtree under @a top.
+     *
+     * If given a @a key, keeps it in step with the path to the node.
+     */
+    static node* next_in_walk(
+        node* n, const node* top, std::vector<BYTE>* key)
+    {
+        if (n->first_child)
+        {
+            n = n->first_child;
+            push_label(n, key);
+            return n;
+        }
+
+        while (n != top)
+        {
+            pop_label(n, key);
+            if (n->next_sibling)
+            {
+                n = n->next_sibling;
+                push_label(n, key);
+                return n;
+            }
+
+            n = n->parent;
+        }
+
+        return NULL;
+    }
+
+    static void push_label(const node* n, std::vector<BYTE>* key)
+    {
+        if (key)
+            key->insert(
+                key->end(), n->label(), n->label() + n->label_size);
+    }
+
+    static void pop_label(const node* n, std::vector<BYTE>* key)
+    {
+        if (key)
+            key->resize(key->size() - n->label_size);
+    }
+
+    template<typename F>
+    void walk(node* top, const T __unaligned* pidl, F& f)
+    {
+        std::vector<BYTE> key;
+        size_t prefix_size = raw_pidl::size(pidl);
+        if (prefix_size)
+        {
+            const BYTE __unaligned* prefix =
+                reinterpret_cast<const BYTE __unaligned*>(pidl);
+            key.assign(prefix, prefix + prefix_size - sizeof(USHORT));
+        }
+
+        const BYTE terminator[sizeof(USHORT)] = {0, 0};
+
+        for (node* n = top; n; n = next_in_walk(n, top, &key))
+        {
+            if (!n->value)
+                continue;
+
+            key.insert(key.end(), terminator, terminator + sizeof(terminator));
+            f(reinterpret_cast<const T*>(&key[0]), *n->value);
+            key.resize(key.size() - sizeof(terminator));
+        }
+    }
+
+    static size_t count_values(node* top)
+    {
+        size_t count = 0;
+        for (node* n = top; n; n = next_in_walk(n, top, NULL))
+        {
+            if (n->value)
+                ++count;
+        }
+        return count;
+    }
+
+    /// Pools indexed by size class, created when first needed
+    std::vector< boost::shared_ptr< boost::pool<> > > m_pools;
+    node* m_root;
+    edge_set m_edges;
+    size_t m_size;
+};
+
+/**
+ * Trie keyed by absolute PIDLs: @c apidl_trie<V>::type.
+ */
+template<typename V>
+struct apidl_trie
+{
+    typedef basic_pidl_trie<ITEMIDLIST_ABSOLUTE, V> type;
+};
+
+}}} // namespace washer::shell::pidl
+
+#endif
@@ -0,0 +1,481 @@
+/**
+    @file
+
+    Reference-counted PIDL wrapper.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_SHARED_PIDL_HPP
+#define WASHER_SHELL_SHARED_PIDL_HPP
+#pragma once
+
+#include <washer/shell/pidl.hpp> // basic_pidl, basic_pidl_view, raw_pidl
+
+#include <boost/make_shared.hpp> // make_shared
+#include <boost/noncopyable.hpp> // noncopyable
+#include <boost/shared_ptr.hpp> // shared_ptr
+#include <boost/throw_exception.hpp> // BOOST_THROW_EXCEPTION
+#include <boost/version.hpp>
+#if (BOOST_VERSION >= 104800)
+#include <boost/move/move.hpp> // BOOST_RV_REF
+#endif
+
+#include <cassert> // assert
+#include <stdexcept> // logic_error
+
+namespace washer {
+namespace shell {
+namespace pidl {
+
+namespace detail {
+
+    /**
+     * The PIDL shared by copies of a basic_shared_pidl.
+     */
+    template<typename T, typename Alloc>
+    struct shared_pidl_storage : private boost::noncopyable
+    {
+        explicit shared_pidl_storage(T* pidl = NULL) : pidl(pidl) {}
+
+        ~shared_pidl_storage() throw()
+        {
+            Alloc::deallocate(pidl);
+        }
+
+        T* pidl;
+    };
+}
+
+/**
+ * Copy-on-write PIDL wrapper.
+ *
+ * Has the same interface as basic_pidl but copies share the same PIDL
+ * instead of cloning it; copying costs an atomic reference-count increment
+ * and no allocation.  This makes it suitable for PIDLs that are copied
+ * much more often than they are changed, such as those held in containers
+ * or by shell items.
+ *
+ * Operations that change the PIDL detach this wrapper from the copies
+ * sharing its PIDL first so the others never see the change.  As the
+ * change replaces the whole PIDL anyway, detaching doesn't copy anything.
+ */
+template<typename T, typename Alloc>
+class basic_shared_pidl
+{
+    typedef detail::shared_pidl_storage<T, Alloc> storage_type;
+
+public:
+
+    typedef T                                                     value_type;
+    typedef T*                                                    pointer;
+    typedef const T*                                              const_pointer;
+    typedef Alloc                                                 allocator;
+    typedef typename raw_pidl::traits<T>::combine_type            join_type;
+    typedef typename allocator::template rebind<join_type>::other join_allocator;
+    typedef basic_shared_pidl<join_type, join_allocator>          join_pidl;
+    typedef typename raw_pidl::traits<T>::clone_pidl_type         foreign_pidl_type;
+    typedef basic_pidl<T, Alloc>                                  unshared_pidl;
+
+    basic_shared_pidl() {}
+
+    /**
+     * Construct by copying a raw PIDL.
+     */
+    basic_shared_pidl(const __unaligned T* raw_pidl)
+    {
+        adopt(raw_pidl::type_checked_clone<Alloc>(raw_pidl));
+    }
+
+    /**
+     * Construct by copying a wrapped PIDL.
+     */
+    template<typename AllocU>
+    explicit basic_shared_pidl(const basic_pidl<T, AllocU>& pidl)
+    {
+        adopt(raw_pidl::clone<Alloc>(pidl.get()));
+    }
+
+#if (BOOST_VERSION >= 104800)
+
+    /**
+     * Construct by taking over a wrapped PIDL's memory without copying it.
+     *
+     * @a pidl is left NULL.
+     */
+    explicit basic_shared_pidl(BOOST_RV_REF(unshared_pidl) pidl)
+    {
+        adopt(pidl.detach());
+    }
+
+#endif
+
+    /**
+     * Construct by copying the items of a PIDL view.
+     */
+    explicit basic_shared_pidl(const basic_pidl_view<T>& view)
+    {
+        adopt(view.template clone<Alloc>());
+    }
+
+    /**
+     * Copy a raw PIDL into this wrapper instance.
+     *
+     * Other wrappers sharing the previous PIDL are unaffected.
+     */
+    basic_shared_pidl& operator=(foreign_pidl_type raw_pidl)
+    {
+        basic_shared_pidl copy(raw_pidl);
+        swap(copy);
+        return *this;
+    }
+
+    /**
+     * Result of comparing with NULL.
+     */
+    bool operator!() const
+    {
+        return !get();
+    }
+
+    /**
+     * Upcast operator.
+     *
+     * Will fail to compile unless it is legal to upcast the underlying raw
+     * PIDL type to this PIDL's type.  The result holds its own copy of the
+     * PIDL.
+     */
+    template<typename U, typename AllocU>
+    operator basic_shared_pidl<U, AllocU>() const
+    {
+        return static_cast<const U*>(get());
+    }
+
+    /**
+     * Unshared copy of the PIDL.
+     */
+    template<typename AllocU>
+    operator basic_pidl<T, AllocU>() const
+    {
+        return get();
+    }
+
+    /**
+     * Return underlying PIDL.
+     *
+     * Returned const to prevent modification of PIDL shared with other
+     * wrappers.
+     */
+    const T* get() const
+    {
+        return (m_storage) ? m_storage->pidl : NULL;
+    }
+
+    /**
+     * Return a pointer to the internal PIDL suitable for use as an
+     * out-parameter.
+     *
+     * The wrapper stops sharing its current PIDL, which is deallocated if
+     * no other wrapper shares it, and is set to NULL.
+     *
+     * @warning  The memory assigned to the PIDL by the caller must have been
+     * allocated with the SAME ALLOCATOR as used by the wrapper so that it can
+     * be destroyed in the wrapper's destructor.
+     */
+    T** out()
+    {
+        if (m_storage && m_storage.unique())
+        {
+            Alloc::deallocate(m_storage->pidl);
+            m_storage->pidl = NULL;
+        }
+        else
+        {
+            m_storage = boost::make_shared<storage_type>();
+        }
+
+        return &m_storage->pidl;
+    }
+
+    /**
+     * Clone internal PIDL as a raw PIDL.
+     *
+     * @see basic_pidl::copy_to
+     */
+    template<typename U>
+    void copy_to(U*& raw_pidl) const
+    {
+        raw_pidl = raw_pidl::clone<Alloc>(get());
+    }
+
+    /**
+     * Attach wrapper to a raw PIDL without copying.
+     *
+     * Other wrappers sharing the previous PIDL are unaffected.
+     *
+     * @warning  The raw PIDL must have been allocated with the SAME ALLOCATOR
+     * as used by the wrapper so that it can be destroyed in the wrapper's
+     * destructor.
+     */
+    basic_shared_pidl& attach(T* raw_pidl)
+    {
+        assert(get() != raw_pidl);
+
+        raw_pidl::traits<T>::type_check(raw_pidl);
+
+        basic_shared_pidl attached;
+        attached.adopt(raw_pidl);
+        swap(attached);
+        return *this;
+    }
+
+    /**
+     * The size of the PIDL in bytes.
+     *
+     * @see basic_pidl::size
+     */
+    size_t size() const
+    {
+        return raw_pidl::size(get());
+    }
+
+    /**
+     * Is the PIDL empty?
+     *
+     * Empty PIDLs are either NULL or point to a NULL-terminator.
+     */
+    bool empty() const
+    {
+        return raw_pidl::empty(get());
+    }
+
+    /**
+     * Is this the only wrapper holding the PIDL?
+     */
+    bool unique() const
+    {
+        return !m_storage || m_storage.unique();
+    }
+
+    /**
+     * The single child pidl of this namespace item.
+     */
+    basic_shared_pidl<
+        ITEMID_CHILD, typename allocator::template rebind<ITEMID_CHILD>::other>
+    last_item() const
+    {
+        if (empty())
+            BOOST_THROW_EXCEPTION(
+                std::logic_error("Empty PIDL cannot have a last item"));
+
+        return basic_shared_pidl<
+            ITEMID_CHILD,
+            typename allocator::template rebind<ITEMID_CHILD>::other>(
+                basic_pidl_view<T>(get()).last_item());
+    }
+
+    /**
+     * Upwards navigation.
+     */
+    basic_shared_pidl parent() const
+    {
+        if (empty())
+            BOOST_THROW_EXCEPTION(
+                std::logic_error("Empty PIDL cannot have a parent"));
+
+        return basic_shared_pidl(basic_pidl_view<T>(get()).parent());
+    }
+
+    /**
+     * No-fail swap.
+     */
+    void swap(basic_shared_pidl& pidl) throw()
+    {
+        m_storage.swap(pidl.m_storage);
+    }
+
+private:
+
+    /**
+     * Take ownership of a PIDL allocated with Alloc.
+     */
+    void adopt(T* pidl)
+    {
+        if (!pidl)
+            return;
+
+        try
+        {
+            m_storage = boost::make_shared<storage_type>(pidl);
+        }
+        catch (...)
+        {
+            Alloc::deallocate(pidl);
+            throw;
+        }
+    }
+
+    boost::shared_ptr<storage_type> m_storage;
+};
+
+/**
+ * @name Concatenation
+ *
+ * Join two PIDLs with the + operator.
+ *
+ * The template will fail to compile if used with an absolute PIDL as the
+ * right-hand operand.
+ *
+ * @returns  A new, unshared PIDL with the contents of the second operand
+ *           appended to the first.
+ */
+// @{
+template<typename T, typename U, typename Alloc, typename AllocU>
+inline typename basic_shared_pidl<T, Alloc>::join_pidl operator+(
+    const basic_shared_pidl<T, Alloc>& lhs,
+    const basic_shared_pidl<U, AllocU>& rhs)
+{
+    typedef typename basic_shared_pidl<T, Alloc>::join_pidl result_type;
+
+    result_type pidl;
+    pidl.attach(
+        raw_pidl::combine<typename result_type::allocator>(
+            lhs.get(), rhs.get()));
+    return pidl;
+}
+
+template<typename T, typename U, typename Alloc>
+inline typename basic_shared_pidl<T, Alloc>::join_pidl operator+(
+    const basic_shared_pidl<T, Alloc>& lhs, const U __unaligned* rhs)
+{
+    typedef typename basic_shared_pidl<T, Alloc>::join_pidl result_type;
+
+    raw_pidl::traits<U>::type_check(rhs);
+
+    result_type pidl;
+    pidl.attach(
+        raw_pidl::combine<typename result_type::allocator>(lhs.get(), rhs));
+    return pidl;
+}
+// @}
+
+/**
+ * @name Appending
+ *
+ * Append one PIDL to another with the += operator.
+ *
+ * The left-hand wrapper is given a new PIDL; other wrappers that shared its
+ * previous PIDL are unaffected.
+ */
+//@{
+template<typename T, typename U, typename Alloc, typename AllocU>
+inline basic_shared_pidl<T, Alloc>& operator+=(
+    basic_shared_pidl<T, Alloc>& lhs, const basic_shared_pidl<U, AllocU>& rhs)
+{
+    basic_shared_pidl<T, Alloc> joined = lhs + rhs;
+    lhs.swap(joined);
+    return lhs;
+}
+
+template<typename T, typename U, typename Alloc>
+inline basic_shared_pidl<T, Alloc>& operator+=(
+    basic_shared_pidl<T, Alloc>& lhs, const U* rhs)
+{
+    basic_shared_pidl<T, Alloc> joined = lhs + rhs;
+    lhs.swap(joined);
+    return lhs;
+}
+//@}
+
+/**
+ * No-fail swap.
+ */
+template<typename T, typename Alloc>
+inline void swap(
+    basic_shared_pidl<T, Alloc>& pidl1, basic_shared_pidl<T, Alloc>& pidl2)
+    throw()
+{
+    pidl1.swap(pidl2);
+}
+
+/**
+ * @name Comparison
+ *
+ * As for basic_pidl.  Wrappers sharing a PIDL are equal without comparing
+ * the PIDL's bytes.
+ */
+// @{
+template<typename T, typename Alloc, typename AllocU>
+inline bool operator==(
+    const basic_shared_pidl<T, Alloc>& lhs,
+    const basic_shared_pidl<T, AllocU>& rhs)
+{
+    return lhs.get() == rhs.get() || raw_pidl::equal(lhs.get(), rhs.get());
+}
+
+template<typename T, typename Alloc, typename AllocU>
+inline bool operator!=(
+    const basic_shared_pidl<T, Alloc>& lhs,
+    const basic_shared_pidl<T, AllocU>& rhs)
+{
+    return !(lhs == rhs);
+}
+
+template<typename T, typename Alloc, typename AllocU>
+inline bool operator<(
+    const basic_shared_pidl<T, Alloc>& lhs,
+    const basic_shared_pidl<T, AllocU>& rhs)
+{
+    return lhs.get() != rhs.get() && raw_pidl::less(lhs.get(), rhs.get());
+}
+// @}
+
+/**
+ * Hash of a shared PIDL's items for use with boost::hash.
+ */
+template<typename T, typename Alloc>
+inline size_t hash_value(const basic_shared_pidl<T, Alloc>& pidl)
+{
+    return raw_pidl::hash(pidl.get());
+}
+
+/**
+ * @name  Standard shared PIDL types.
+ *
+ * These all use the CoTaskMemAlloc allocation method.
+ */
+// @{
+typedef basic_shared_pidl<
+    ITEMIDLIST_RELATIVE, cotaskmem_alloc<ITEMIDLIST_RELATIVE> > shared_pidl_t;
+typedef basic_shared_pidl<
+    ITEMIDLIST_ABSOLUTE, cotaskmem_alloc<ITEMIDLIST_ABSOLUTE> > shared_apidl_t;
+typedef basic_shared_pidl<ITEMID_CHILD, cotaskmem_alloc<ITEMID_CHILD> >
+    shared_cpidl_t;
+// @}
+
+}}} // namespace washer::shell::pidl
+
+#endif
@@ -34,7 +34,8 @@
 #pragma once
 
 #include <washer/detail/path_traits.hpp> // choose_path
-#include <washer/shell/pidl.hpp> // cpidl_t, apidl_t
+#include <washer/shell/pidl.hpp> // cpidl_t, apidl_t, apidl_view
+#include <washer/shell/shell_context.hpp> // shell_context
 #include <washer/shell/shell_item.hpp> // pidl_shell_item
 
 #include <comet/ptr.h> // com_ptr
@@ -44,6 +45,7 @@
 #include <boost/exception/info.hpp> // errinfo
 #include <boost/shared_ptr.hpp> // shared_ptr
 #include <boost/throw_exception.hpp> // BOOST_THROW_EXCEPTION
+#include <boost/type_traits/is_same.hpp> // is_same
 
 #include <cassert> // assert
 #include <stdexcept> // runtime_error, logic_error
@@ -182,10 +184,10 @@ inline comet::com_ptr<IShellFolder> desktop_folder()
  */
 template<typename T>
 inline std::basic_string<T> strret_to_string(
-    STRRET& strret, const pidl::cpidl_t& pidl=pidl::cpidl_t())
+    STRRET& strret, PCUITEMID_CHILD pidl)
 {
     T* str = NULL;
-    HRESULT hr = detail::native::str_ret_to_str(&strret, pidl.get(), &str);
+    HRESULT hr = detail::native::str_ret_to_str(&strret, pidl, &str);
 
     // RAII for CoTaskMemAlloced string
     boost::shared_ptr<T> str_lifetime(str, ::CoTaskMemFree);
@@ -202,6 +204,18 @@ inline std::basic_string<T> strret_to_string(
     return (str) ? std::basic_string<T>(str) : std::basic_string<T>();
 }
 
+/**
+ * Convert a STRRET structure to a string.
+ *
+ * @see the raw PIDL overload above.
+ */
+template<typename T>
+inline std::basic_string<T> strret_to_string(
+    STRRET& strret, const pidl::cpidl_t& pidl=pidl::cpidl_t())
+{
+    return strret_to_string<T>(strret, pidl.get());
+}
+
 /**
  * Create a STRRET from an ANSI string.
  *
@@ -329,13 +343,52 @@ inline comet::com_ptr<T> bind_to_parent(const pidl::apidl_t& pidl)
 }
 
 /**
- * Given a PIDL, return an IStream to it.
+ * Bind to the parent object of an absolute PIDL, reusing the parent folder
+ * if it is in the context's folder cache.
+ *
+ * The cache only holds IShellFolders, so only requests for IShellFolder use
+ * it.  Other interfaces are bound as bind_to_parent(pidl) does, as the
+ * parent may not give the same object for them by querying its
+ * IShellFolder.  If the context has no folder cache, this is also the same
+ * as bind_to_parent(pidl).
+ *
+ * @tparam T  Type of interface on the parent object to return.
+ *
+ * @returns  The requested interface of the parent object.
+ */
+template<typename T>
+inline comet::com_ptr<T> bind_to_parent(
+    const pidl::apidl_t& pidl, const shell_context& context)
+{
+    if (!context.folders || !boost::is_same<T, IShellFolder>::value)
+        return bind_to_parent<T>(pidl);
+
+    if (pidl.empty())
+        BOOST_THROW_EXCEPTION(std::logic_error("Already at top level"));
+
+    // Looking up the parent through a view doesn't copy it
+    comet::com_ptr<IShellFolder> parent =
+        context.folders->find(pidl::apidl_view(pidl).parent());
+    if (!parent)
+    {
+        parent = bind_to_parent<IShellFolder>(pidl);
+        context.folders->insert(pidl.parent().get(), parent);
+    }
+
+    return comet::try_cast(parent);
+}
+
+/**
+ * Given a PIDL, return an IStream to it, binding to its parent folder
+ * through the context's caches.
  *
  * @note  This fails with E_NOTIMPL on Windows 2000 and below.
  */
-inline comet::com_ptr<IStream> stream_from_pidl(const pidl::apidl_t& pidl)
+inline comet::com_ptr<IStream> stream_from_pidl(
+    const pidl::apidl_t& pidl, const shell_context& context)
 {
-    comet::com_ptr<IShellFolder> parent = bind_to_parent<IShellFolder>(pidl);
+    comet::com_ptr<IShellFolder> parent =
+        bind_to_parent<IShellFolder>(pidl, context);
 
     comet::com_ptr<IStream> stream;
 
@@ -351,12 +404,22 @@ inline comet::com_ptr<IStream> stream_from_pidl(const pidl::apidl_t& pidl)
             BOOST_THROW_EXCEPTION(
                 comet::com_error(
                     L"Couldn't get stream for source file: " +
-                    pidl_shell_item(pidl).parsing_name(), hr));
+                    pidl_shell_item(pidl, context).parsing_name(), hr));
     }
 
     return stream;
 }
 
+/**
+ * Given a PIDL, return an IStream to it.
+ *
+ * @note  This fails with E_NOTIMPL on Windows 2000 and below.
+ */
+inline comet::com_ptr<IStream> stream_from_pidl(const pidl::apidl_t& pidl)
+{
+    return stream_from_pidl(pidl, shell_context());
+}
+
 }} // namespace washer::shell
 
 #endif
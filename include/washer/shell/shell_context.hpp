@@ -0,0 +1,62 @@
+/**
+    @file
+
+    Caches shared by shell operations.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_SHELL_SHELL_CONTEXT_HPP
+#define WASHER_SHELL_SHELL_CONTEXT_HPP
+#pragma once
+
+#include <washer/shell/display_name_cache.hpp> // display_name_cache
+#include <washer/shell/parent_folder_cache.hpp> // parent_folder_cache
+
+#include <boost/shared_ptr.hpp> // shared_ptr
+
+namespace washer {
+namespace shell {
+
+/**
+ * Caches that shell operations can share to avoid repeating work.
+ *
+ * Operations taking a context use whichever caches it has and behave like
+ * their context-free versions for those it hasn't.  A default-constructed
+ * context has no caches.  Copies of a context share its caches.
+ *
+ * The folder cache can be used from any thread but the name cache must
+ * only be used by one thread at a time.
+ */
+struct shell_context
+{
+    boost::shared_ptr<parent_folder_cache> folders;
+    boost::shared_ptr<display_name_cache> names;
+};
+
+}} // namespace washer::shell
+
+#endif
@@ -34,6 +34,7 @@
 #pragma once
 
 #include <washer/shell/pidl.hpp> // apidl_t, cpidl_t
+#include <washer/shell/shell_context.hpp> // shell_context
 #include <washer/shell/folder_error_adapters.hpp> // comtype<IShellFolder>
 
 #include <comet/ptr.h> // com_ptr
@@ -53,9 +54,13 @@ namespace shell {
 template<typename T>
 inline comet::com_ptr<T> bind_to_parent(const pidl::apidl_t& pidl);
 
+template<typename T>
+inline comet::com_ptr<T> bind_to_parent(
+    const pidl::apidl_t& pidl, const shell_context& context);
+
 template<typename T>
 inline std::basic_string<T> strret_to_string(
-    STRRET& strret, const pidl::cpidl_t& pidl);
+    STRRET& strret, PCUITEMID_CHILD pidl);
 
 /**
  * Interface to items in the shell namespace.
@@ -346,19 +351,27 @@ namespace detail {
 
     /**
      * Return the name of a PIDL as given by its parent folder.
+     *
+     * The parent folder is bound through the context's folder cache, if it
+     * has one.
      */
     inline std::wstring display_name_from_pidl(
-        const pidl::apidl_t& pidl, SHGDNF type_flags)
+        const pidl::apidl_t& pidl, SHGDNF type_flags,
+        const shell_context& context=shell_context())
     {
-        comet::com_ptr<IShellFolder> parent = bind_to_parent<IShellFolder>(pidl);
+        comet::com_ptr<IShellFolder> parent =
+            bind_to_parent<IShellFolder>(pidl, context);
+
+        // A view of the last item points into the PIDL rather than copying
+        // the item out
+        PCUITEMID_CHILD item = pidl::apidl_view(pidl).last_item().get();
 
         STRRET str;
-        HRESULT hr = parent->GetDisplayNameOf(
-            pidl.last_item().get(), type_flags, &str);
+        HRESULT hr = parent->GetDisplayNameOf(item, type_flags, &str);
         if (FAILED(hr))
             BOOST_THROW_EXCEPTION(comet::com_error_from_interface(parent, hr));
 
-        return strret_to_string<wchar_t>(str, pidl.last_item());
+        return strret_to_string<wchar_t>(str, item);
     }
 }
 
@@ -368,32 +381,59 @@ public:
 
     explicit pidl_shell_item(const pidl::apidl_t& pidl) : m_pidl(pidl) {}
 
+    /**
+     * Shell item that uses the caches in a context to bind to its parent
+     * folder and to look up its names.
+     *
+     * The caches are typically shared by many items.  Like the items, the
+     * name cache must only be used by one thread at a time.
+     */
+    pidl_shell_item(const pidl::apidl_t& pidl, const shell_context& context)
+        : m_pidl(pidl), m_context(context) {}
+
     virtual std::wstring friendly_name(
         BOOST_SCOPED_ENUM(friendly_name_type) type=friendly_name_type::default)
     const
     {
-        std::wstring name = detail::display_name_from_pidl(
-            m_pidl, detail::friendly_name_type_to_shgdnf(type));
-
-        // Editing result should always be the same whether INFOLDER is
-        // specified or not
-        assert(
-            type != friendly_name_type::editable ||
-            name == detail::display_name_from_pidl(m_pidl, SHGDN_FOREDITING));
-
-        return name;
+        return display_name(detail::friendly_name_type_to_shgdnf(type));
     }
 
     virtual std::wstring parsing_name(
         BOOST_SCOPED_ENUM(parsing_name_type) type=parsing_name_type::default)
     const
     {
-        return detail::display_name_from_pidl(
-            m_pidl, detail::parsing_name_type_to_shgdnf(type));
+        return display_name(detail::parsing_name_type_to_shgdnf(type));
     }
 
 private:
+
+    std::wstring display_name(SHGDNF flags) const
+    {
+        if (m_context.names)
+        {
+            const std::wstring* name = m_context.names->find(m_pidl, flags);
+            if (name)
+                return *name;
+        }
+
+        std::wstring name =
+            detail::display_name_from_pidl(m_pidl, flags, m_context);
+
+        // Editing result should always be the same whether INFOLDER is
+        // specified or not
+        assert(
+            flags != (SHGDN_FOREDITING | SHGDN_INFOLDER) ||
+            name == detail::display_name_from_pidl(
+                m_pidl, SHGDN_FOREDITING, m_context));
+
+        if (m_context.names)
+            m_context.names->insert(m_pidl, flags, name);
+
+        return name;
+    }
+
     pidl::apidl_t m_pidl;
+    shell_context m_context;
 };
 
 }} // namespace washer::shell
@@ -0,0 +1,435 @@
+/**
+    @file
+
+    Unit tests for enumerating folders on a worker thread.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // child_pidl_from_text, pidl_matches_text
+#include "sandbox_fixture.hpp" // sandbox_fixture
+#include "wchar_output.hpp" // wstring output
+
+#include <washer/shell/background_enumeration.hpp> // test subject
+#include <washer/shell/enum_id_list.hpp> // make_enum_id_list
+#include <washer/shell/folder_error_adapters.hpp> // folder_error_adapter
+#include <washer/shell/shell.hpp> // bind_to_handler_object
+#include <washer/shell/shell_item.hpp> // pidl_shell_item
+
+#include <comet/error.h> // com_error
+#include <comet/ptr.h> // com_ptr
+#include <comet/server.h> // simple_object
+#include <comet/util.h> // auto_coinit
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm> // sort
+#include <cstddef> // size_t
+#include <string>
+#include <vector>
+
+#include <Windows.h> // PeekMessage, DispatchMessage, MsgWaitForMultipleObjects,
+                     // Sleep
+
+using comet::auto_coinit;
+using comet::com_error;
+using comet::com_ptr;
+using comet::simple_object;
+
+using namespace washer::shell;
+using washer::shell::pidl::apidl_t;
+using washer::shell::pidl::cpidl_t;
+using washer::test::child_pidl_from_text;
+using washer::test::pidl_matches_text;
+using washer::test::sandbox_fixture;
+
+using std::size_t;
+using std::sort;
+using std::string;
+using std::vector;
+using std::wstring;
+
+namespace {
+
+    class background_enumeration_fixture : public sandbox_fixture
+    {
+    public:
+
+        /**
+         * Add a batch's items to a list of paths.
+         */
+        void add_paths(
+            const background_enumeration::batch& items,
+            vector<wstring>& paths)
+        {
+            apidl_t folder = sandbox_pidl();
+            for (size_t i = 0; i < items.size(); ++i)
+            {
+                paths.push_back(
+                    pidl_shell_item(folder + items[i]).parsing_name());
+            }
+        }
+
+        /**
+         * Take every batch, waiting for each, and return the paths, sorted.
+         */
+        vector<wstring> drain(
+            background_enumeration& items, size_t max_batch_size)
+        {
+            vector<wstring> paths;
+            background_enumeration::batch batch;
+            while (items.pop(batch))
+            {
+                BOOST_CHECK(!batch.empty());
+                BOOST_CHECK_LE(batch.size(), max_batch_size);
+                add_paths(batch, paths);
+            }
+
+            BOOST_CHECK(items.finished());
+
+            sort(paths.begin(), paths.end());
+            return paths;
+        }
+
+        /**
+         * Take every batch without waiting, servicing this thread's messages
+         * while there is nothing to take, and return the paths, sorted.
+         */
+        vector<wstring> drain_pumping(background_enumeration& items)
+        {
+            vector<wstring> paths;
+            background_enumeration::batch batch;
+            while (!items.finished())
+            {
+                if (items.try_pop(batch))
+                {
+                    add_paths(batch, paths);
+                }
+                else
+                {
+                    ::MsgWaitForMultipleObjects(
+                        0, NULL, FALSE, 10, QS_ALLINPUT);
+
+                    MSG message;
+                    while (::PeekMessageW(&message, NULL, 0, 0, PM_REMOVE))
+                    {
+                        ::TranslateMessage(&message);
+                        ::DispatchMessageW(&message);
+                    }
+                }
+            }
+
+            sort(paths.begin(), paths.end());
+            return paths;
+        }
+    };
+
+    /**
+     * Enumerator that hands out its first batch of items and then fails.
+     */
+    class failing_enum_id_list : public simple_object<IEnumIDList>
+    {
+    public:
+
+        typedef IEnumIDList interface_is;
+
+        failing_enum_id_list(const string& texts, HRESULT error)
+            : m_error(error), m_failing(false)
+        {
+            vector<cpidl_t> pidls;
+            for (string::size_type i = 0; i < texts.size(); ++i)
+            {
+                pidls.push_back(child_pidl_from_text(texts.substr(i, 1)));
+            }
+            m_items = make_enum_id_list(pidls.begin(), pidls.end());
+        }
+
+        virtual IFACEMETHODIMP Next(
+            ULONG celt, PITEMID_CHILD* rgelt, ULONG* pceltFetched)
+        {
+            if (pceltFetched)
+                *pceltFetched = 0;
+
+            if (m_failing)
+                return m_error;
+
+            m_failing = true;
+            return m_items->Next(celt, rgelt, pceltFetched);
+        }
+
+        virtual IFACEMETHODIMP Skip(ULONG celt)
+        { return m_items->Skip(celt); }
+
+        virtual IFACEMETHODIMP Reset()
+        { return m_items->Reset(); }
+
+        virtual IFACEMETHODIMP Clone(IEnumIDList**)
+        { return E_NOTIMPL; }
+
+    private:
+        com_ptr<IEnumIDList> m_items;
+        HRESULT m_error;
+        bool m_failing;
+    };
+
+    /**
+     * Folder whose items are enumerated by a failing_enum_id_list.
+     */
+    class failing_folder : public simple_object<folder_error_adapter>
+    {
+    public:
+
+        failing_folder(const string& texts, HRESULT error)
+            : m_texts(texts), m_error(error) {}
+
+        PIDLIST_RELATIVE parse_display_name(
+            HWND, IBindCtx*, const wchar_t*, ULONG*)
+        { return NULL; }
+
+        IEnumIDList* enum_objects(HWND, SHCONTF)
+        {
+            return com_ptr<IEnumIDList>(
+                new failing_enum_id_list(m_texts, m_error)).detach();
+        }
+
+        void bind_to_object(
+            PCUIDLIST_RELATIVE, IBindCtx*, const IID&, void** interface_out)
+        { *interface_out = NULL; }
+
+        void bind_to_storage(
+            PCUIDLIST_RELATIVE, IBindCtx*, const IID&, void** interface_out)
+        { *interface_out = NULL; }
+
+        int compare_ids(
+            LPARAM, PCUIDLIST_RELATIVE, PCUIDLIST_RELATIVE)
+        { return 0; }
+
+        void create_view_object(HWND, const IID&, void** interface_out)
+        { *interface_out = NULL; }
+
+        void get_attributes_of(UINT, PCUITEMID_CHILD_ARRAY, SFGAOF*)
+        {}
+
+        void get_ui_object_of(
+            HWND, UINT, PCUITEMID_CHILD_ARRAY, const IID&,
+            void** interface_out)
+        { *interface_out = NULL; }
+
+        STRRET get_display_name_of(PCUITEMID_CHILD, SHGDNF)
+        { return STRRET(); }
+
+        PITEMID_CHILD set_name_of(
+            HWND, PCUITEMID_CHILD, const wchar_t*, SHGDNF)
+        { return NULL; }
+
+    private:
+        string m_texts;
+        HRESULT m_error;
+    };
+}
+
+BOOST_FIXTURE_TEST_SUITE(background_enumeration_tests,
+                         background_enumeration_fixture)
+
+/**
+ * An empty folder ends without giving any batches.
+ */
+BOOST_AUTO_TEST_CASE( empty_folder )
+{
+    auto_coinit com;
+
+    background_enumeration items(
+        sandbox_pidl(), SHCONTF_FOLDERS | SHCONTF_NONFOLDERS);
+
+    background_enumeration::batch batch;
+    BOOST_CHECK(!items.pop(batch));
+    BOOST_CHECK(batch.empty());
+    BOOST_CHECK(items.finished());
+    BOOST_CHECK(!items.try_pop(batch));
+}
+
+/**
+ * Every item arrives once, in batches no larger than asked for, even when
+ * the worker has to wait for the queue to drain.
+ */
+BOOST_AUTO_TEST_CASE( batches_from_pidl )
+{
+    auto_coinit com;
+
+    vector<wstring> files = create_files(5);
+
+    background_enumeration::options settings;
+    settings.batch_size = 2;
+    settings.max_queued_batches = 1;
+
+    background_enumeration items(
+        sandbox_pidl(), SHCONTF_FOLDERS | SHCONTF_NONFOLDERS, settings);
+
+    vector<wstring> paths = drain(items, 2);
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        paths.begin(), paths.end(), files.begin(), files.end());
+}
+
+/**
+ * A folder from this apartment reaches the worker through the Global
+ * Interface Table.
+ */
+BOOST_AUTO_TEST_CASE( batches_from_folder )
+{
+    auto_coinit com;
+
+    vector<wstring> files = create_files(5);
+
+    background_enumeration::options settings;
+    settings.batch_size = 3;
+    settings.worker_apartment =
+        background_enumeration::apartment::multithreaded;
+
+    background_enumeration items(
+        bind_to_handler_object<IShellFolder>(sandbox_pidl()),
+        SHCONTF_FOLDERS | SHCONTF_NONFOLDERS, settings);
+
+    vector<wstring> paths = drain_pumping(items);
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        paths.begin(), paths.end(), files.begin(), files.end());
+}
+
+/**
+ * Cancelling releases a worker waiting for room in the queue and ends the
+ * enumeration early.
+ */
+BOOST_AUTO_TEST_CASE( cancel )
+{
+    auto_coinit com;
+
+    create_files(5);
+
+    background_enumeration::options settings;
+    settings.batch_size = 1;
+    settings.max_queued_batches = 1;
+
+    background_enumeration items(
+        sandbox_pidl(), SHCONTF_FOLDERS | SHCONTF_NONFOLDERS, settings);
+
+    background_enumeration::batch batch;
+    BOOST_REQUIRE(items.pop(batch));
+    BOOST_CHECK_EQUAL(batch.size(), 1U);
+
+    items.cancel();
+
+    size_t remaining = 0;
+    while (items.pop(batch))
+    {
+        remaining += batch.size();
+    }
+
+    BOOST_CHECK_LE(remaining, 1U);
+    BOOST_CHECK(items.finished());
+}
+
+/**
+ * Destroying an enumeration part way through stops the worker.
+ */
+BOOST_AUTO_TEST_CASE( abandon )
+{
+    auto_coinit com;
+
+    create_files(5);
+
+    background_enumeration::options settings;
+    settings.batch_size = 1;
+    settings.max_queued_batches = 1;
+
+    background_enumeration items(
+        sandbox_pidl(), SHCONTF_FOLDERS | SHCONTF_NONFOLDERS, settings);
+}
+
+/**
+ * A folder the worker cannot bind to ends the enumeration with the error,
+ * which pop() rethrows.
+ */
+BOOST_AUTO_TEST_CASE( bind_failure )
+{
+    auto_coinit com;
+
+    vector<wstring> files = create_files(1);
+
+    background_enumeration items(
+        path_pidl(files[0]), SHCONTF_FOLDERS | SHCONTF_NONFOLDERS);
+
+    background_enumeration::batch batch;
+    BOOST_CHECK_THROW(items.pop(batch), com_error);
+    BOOST_CHECK(items.finished());
+}
+
+/**
+ * When Next() fails part way through, the batches before the failure still
+ * arrive and then try_pop() rethrows the failure as a plain COM error.
+ *
+ * The caller joins the multithreaded apartment, like the worker, so the
+ * fake folder is called directly and no messages need pumping.
+ */
+BOOST_AUTO_TEST_CASE( enumerator_failure )
+{
+    auto_coinit com(COINIT_MULTITHREADED);
+
+    background_enumeration::options settings;
+    settings.batch_size = 2;
+    settings.worker_apartment =
+        background_enumeration::apartment::multithreaded;
+
+    background_enumeration items(
+        com_ptr<IShellFolder>(new failing_folder("abcde", E_UNEXPECTED)),
+        SHCONTF_FOLDERS | SHCONTF_NONFOLDERS, settings);
+
+    background_enumeration::batch received;
+    try
+    {
+        background_enumeration::batch batch;
+        for (;;)
+        {
+            if (items.try_pop(batch))
+                received.insert(received.end(), batch.begin(), batch.end());
+            else if (items.finished())
+                break;
+            else
+                ::Sleep(10);
+        }
+
+        BOOST_FAIL("Enumeration ended without an error");
+    }
+    catch (const com_error& e)
+    {
+        BOOST_CHECK_EQUAL(e.hr(), E_UNEXPECTED);
+    }
+
+    BOOST_REQUIRE_EQUAL(received.size(), 2U);
+    BOOST_CHECK(pidl_matches_text(received[0].get(), "a"));
+    BOOST_CHECK(pidl_matches_text(received[1].get(), "b"));
+    BOOST_CHECK(items.finished());
+}
+
+BOOST_AUTO_TEST_SUITE_END();
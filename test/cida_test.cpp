@@ -0,0 +1,366 @@
+/**
+    @file
+
+    Unit tests for cida_view.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // child_pidl_from_text etc.
+
+#include <washer/shell/cida.hpp> // test subject
+
+#include <boost/test/unit_test.hpp>
+#include <boost/version.hpp>
+#if (BOOST_VERSION >= 104800)
+#include <boost/move/move.hpp> // move
+#endif
+
+#include <cstring> // memcpy
+#include <iterator> // distance
+#include <stdexcept> // out_of_range, runtime_error
+#include <string>
+#include <vector>
+
+#include <ShlObj.h> // CIDA
+#include <Windows.h> // GlobalSize, GlobalFree
+
+using namespace washer::shell::pidl;
+using washer::global_lock;
+using washer::unique_global_alloc;
+using washer::unique_hglobal;
+using washer::test::absolute_pidl_from_texts;
+using washer::test::binary_equal_pidls;
+using washer::test::child_pidl_from_text;
+using washer::test::pidl_matches_text;
+
+using std::string;
+using std::vector;
+
+namespace {
+
+    unique_hglobal global_from_bytes(const vector<BYTE>& bytes)
+    {
+        unique_hglobal global = unique_global_alloc(
+            GMEM_MOVEABLE, bytes.size());
+        {
+            global_lock<BYTE> lock(global.get());
+            std::memcpy(lock.get(), &bytes[0], bytes.size());
+        }
+
+#if (BOOST_VERSION >= 104800)
+        return boost::move(global);
+#else
+        return global;
+#endif
+    }
+
+    void append_bytes(vector<BYTE>& bytes, const void* data, size_t size)
+    {
+        const BYTE* begin = static_cast<const BYTE*>(data);
+        bytes.insert(bytes.end(), begin, begin + size);
+    }
+
+    /**
+     * Lay out a CIDA by hand.
+     */
+    vector<BYTE> cida_bytes(
+        const apidl_t& parent, const vector<cpidl_t>& items)
+    {
+        UINT count = static_cast<UINT>(items.size());
+        vector<UINT> offsets;
+        UINT offset = static_cast<UINT>(sizeof(UINT) * (count + 2));
+
+        offsets.push_back(offset);
+        offset += static_cast<UINT>(parent.size());
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            offsets.push_back(offset);
+            offset += static_cast<UINT>(items[i].size());
+        }
+
+        vector<BYTE> bytes;
+        append_bytes(bytes, &count, sizeof(count));
+        append_bytes(bytes, &offsets[0], offsets.size() * sizeof(UINT));
+        append_bytes(bytes, parent.get(), parent.size());
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            append_bytes(bytes, items[i].get(), items[i].size());
+        }
+
+        return bytes;
+    }
+
+    apidl_t parent_folder()
+    {
+        vector<string> texts;
+        texts.push_back("C:");
+        texts.push_back("Users");
+        return absolute_pidl_from_texts(texts);
+    }
+
+    vector<cpidl_t> three_items()
+    {
+        vector<cpidl_t> items;
+        items.push_back(child_pidl_from_text("one"));
+        items.push_back(child_pidl_from_text("two"));
+        items.push_back(child_pidl_from_text("three"));
+        return items;
+    }
+
+    unique_hglobal test_cida()
+    {
+        return global_from_bytes(cida_bytes(parent_folder(), three_items()));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(cida_tests)
+
+/**
+ * The parent and items are viewed in place.
+ */
+BOOST_AUTO_TEST_CASE( view_in_place )
+{
+    unique_hglobal global = test_cida();
+    cida_view cida(global.get());
+
+    BOOST_REQUIRE_EQUAL(cida.size(), 3U);
+    BOOST_CHECK(!cida.empty());
+
+    BOOST_CHECK(
+        binary_equal_pidls(cida.parent_pidl(), parent_folder().get()));
+    BOOST_CHECK(binary_equal_pidls(cida.parent().get(), parent_folder().get()));
+    BOOST_CHECK(pidl_matches_text(cida.get(0), "one"));
+    BOOST_CHECK(pidl_matches_text(cida[1].get(), "two"));
+    BOOST_CHECK(pidl_matches_text(cida.at(2).get(), "three"));
+
+    global_lock<BYTE> lock(global.get());
+    const BYTE* first = reinterpret_cast<const BYTE*>(cida.get(0));
+    const BYTE* last = reinterpret_cast<const BYTE*>(cida.get(2));
+    BOOST_CHECK(first > lock.get());
+    BOOST_CHECK(last < lock.get() + ::GlobalSize(global.get()));
+}
+
+/**
+ * The items can be iterated as a random-access range.
+ */
+BOOST_AUTO_TEST_CASE( iterate )
+{
+    unique_hglobal global = test_cida();
+    cida_view cida(global.get());
+    vector<cpidl_t> expected = three_items();
+
+    BOOST_REQUIRE_EQUAL(cida.end() - cida.begin(), 3);
+
+    size_t i = 0;
+    for (cida_view::const_iterator it = cida.begin(); it != cida.end(); ++it)
+    {
+        BOOST_CHECK(binary_equal_pidls((*it).get(), expected[i++].get()));
+    }
+
+    BOOST_CHECK(pidl_matches_text((cida.begin() + 2)->get(), "three"));
+
+    // Copying is explicit
+    vector<pidl_t> copies;
+    for (cida_view::const_iterator it = cida.begin(); it != cida.end(); ++it)
+    {
+        copies.push_back(pidl_t(*it));
+    }
+    BOOST_REQUIRE_EQUAL(copies.size(), 3U);
+    BOOST_CHECK(binary_equal_pidls(copies[0].get(), expected[0].get()));
+}
+
+/**
+ * Absolute PIDLs are built on request.
+ */
+BOOST_AUTO_TEST_CASE( absolute )
+{
+    unique_hglobal global = test_cida();
+    cida_view cida(global.get());
+
+    BOOST_CHECK(
+        cida.absolute(1) == parent_folder() + child_pidl_from_text("two"));
+}
+
+/**
+ * A view can be made from an existing lock.
+ */
+BOOST_AUTO_TEST_CASE( from_lock )
+{
+    unique_hglobal global = test_cida();
+    global_lock<CIDA> lock(global.get());
+    cida_view cida(lock, ::GlobalSize(global.get()));
+
+    BOOST_CHECK_EQUAL(cida.size(), 3U);
+    BOOST_CHECK(pidl_matches_text(cida.get(2), "three"));
+}
+
+/**
+ * A CIDA with only the parent folder is empty.
+ */
+BOOST_AUTO_TEST_CASE( no_items )
+{
+    unique_hglobal global = global_from_bytes(
+        cida_bytes(parent_folder(), vector<cpidl_t>()));
+    cida_view cida(global.get());
+
+    BOOST_CHECK(cida.empty());
+    BOOST_CHECK(cida.begin() == cida.end());
+    BOOST_CHECK(binary_equal_pidls(cida.parent_pidl(), parent_folder().get()));
+    BOOST_CHECK_THROW(cida.at(0), std::out_of_range);
+}
+
+/**
+ * A count larger than the offset table can hold is rejected.
+ */
+BOOST_AUTO_TEST_CASE( count_too_large )
+{
+    vector<BYTE> bytes = cida_bytes(parent_folder(), three_items());
+    UINT count = 0xFFFFFFFF;
+    std::memcpy(&bytes[0], &count, sizeof(count));
+
+    unique_hglobal global = global_from_bytes(bytes);
+    BOOST_CHECK_THROW(cida_view(global.get()), std::runtime_error);
+}
+
+/**
+ * An offset pointing outside the block is rejected.
+ */
+BOOST_AUTO_TEST_CASE( offset_out_of_bounds )
+{
+    vector<BYTE> bytes = cida_bytes(parent_folder(), three_items());
+    UINT offset = static_cast<UINT>(bytes.size());
+    std::memcpy(&bytes[sizeof(UINT) * 3], &offset, sizeof(offset));
+
+    unique_hglobal global = global_from_bytes(bytes);
+    BOOST_CHECK_THROW(cida_view(global.get()), std::runtime_error);
+}
+
+/**
+ * A PIDL running off the end of the block is rejected.
+ */
+BOOST_AUTO_TEST_CASE( truncated )
+{
+    vector<BYTE> bytes = cida_bytes(parent_folder(), three_items());
+    bytes.resize(bytes.size() - 3);
+
+    unique_hglobal global = global_from_bytes(bytes);
+    BOOST_CHECK_THROW(cida_view(global.get()), std::runtime_error);
+}
+
+/**
+ * A built CIDA is laid out exactly as one laid out by hand.
+ */
+BOOST_AUTO_TEST_CASE( make_from_range )
+{
+    vector<cpidl_t> items = three_items();
+    unique_hglobal global =
+        make_cida(parent_folder(), items.begin(), items.end());
+
+    vector<BYTE> expected = cida_bytes(parent_folder(), items);
+    BOOST_REQUIRE_EQUAL(::GlobalSize(global.get()), expected.size());
+
+    global_lock<BYTE> lock(global.get());
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        lock.get(), lock.get() + expected.size(),
+        expected.begin(), expected.end());
+}
+
+/**
+ * A CIDA can be built from a pidl_array.
+ */
+BOOST_AUTO_TEST_CASE( make_from_pidl_array )
+{
+    vector<cpidl_t> items = three_items();
+    pidl_array<cpidl_t> array(items.begin(), items.end());
+    unique_hglobal global = make_cida(parent_folder().get(), array);
+
+    cida_view cida(global.get());
+    BOOST_REQUIRE_EQUAL(cida.size(), 3U);
+    BOOST_CHECK(
+        binary_equal_pidls(cida.parent_pidl(), parent_folder().get()));
+    BOOST_CHECK(pidl_matches_text(cida.get(0), "one"));
+    BOOST_CHECK(pidl_matches_text(cida.get(2), "three"));
+}
+
+/**
+ * A CIDA's items can be copied into a new CIDA straight from its views.
+ */
+BOOST_AUTO_TEST_CASE( make_from_views )
+{
+    unique_hglobal original = test_cida();
+    cida_view source(original.get());
+
+    unique_hglobal copy =
+        make_cida(source.parent(), source.begin() + 1, source.end());
+    cida_view cida(copy.get());
+
+    BOOST_REQUIRE_EQUAL(cida.size(), 2U);
+    BOOST_CHECK(
+        binary_equal_pidls(cida.parent_pidl(), parent_folder().get()));
+    BOOST_CHECK(pidl_matches_text(cida.get(0), "two"));
+    BOOST_CHECK(pidl_matches_text(cida.get(1), "three"));
+}
+
+/**
+ * A built CIDA can be released from its owner, for example into an
+ * STGMEDIUM, after which the owner no longer frees it.
+ */
+BOOST_AUTO_TEST_CASE( make_and_release )
+{
+    vector<cpidl_t> items = three_items();
+    unique_hglobal owner =
+        make_cida(parent_folder(), items.begin(), items.end());
+
+    HGLOBAL released = owner.release();
+    BOOST_REQUIRE(released);
+    BOOST_CHECK(!owner.get());
+
+    {
+        cida_view cida(released);
+        BOOST_CHECK_EQUAL(cida.size(), 3U);
+    }
+
+    ::GlobalFree(released);
+}
+
+/**
+ * A CIDA can hold no items and the desktop as the parent.
+ */
+BOOST_AUTO_TEST_CASE( make_empty )
+{
+    vector<cpidl_t> items;
+    unique_hglobal global = make_cida(apidl_t(), items.begin(), items.end());
+
+    BOOST_CHECK_EQUAL(
+        ::GlobalSize(global.get()), sizeof(UINT) * 2 + sizeof(USHORT));
+
+    cida_view cida(global.get());
+    BOOST_CHECK(cida.empty());
+    BOOST_CHECK(raw_pidl::empty(cida.parent_pidl()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,227 @@
+/**
+    @file
+
+    Unit tests for display_name_cache.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // absolute_pidl_from_texts
+#include "wchar_output.hpp" // wstring output
+
+#include <washer/shell/display_name_cache.hpp> // test subject
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+#include <ShObjIdl.h> // SHGDN_*
+
+using washer::shell::display_name_cache;
+using washer::shell::display_name_cache_statistics;
+using washer::shell::pidl::apidl_t;
+using washer::test::absolute_pidl_from_texts;
+
+using std::string;
+using std::vector;
+using std::wstring;
+
+namespace {
+
+    apidl_t path(const string& a, const string& b="", const string& c="")
+    {
+        vector<string> texts;
+        texts.push_back(a);
+        if (!b.empty())
+            texts.push_back(b);
+        if (!c.empty())
+            texts.push_back(c);
+        return absolute_pidl_from_texts(texts);
+    }
+
+    wstring cached(
+        display_name_cache& cache, const apidl_t& pidl,
+        SHGDNF flags=SHGDN_NORMAL)
+    {
+        const wstring* name = cache.find(pidl, flags);
+        return (name) ? *name : L"<not cached>";
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(display_name_cache_tests)
+
+/**
+ * Names are found by PIDL and flags, and lookups are counted.
+ */
+BOOST_AUTO_TEST_CASE( hit_and_miss )
+{
+    display_name_cache cache(10);
+    cache.insert(path("C:", "file.txt"), SHGDN_NORMAL, L"file");
+    cache.insert(path("C:", "file.txt"), SHGDN_FORPARSING, L"C:\\file.txt");
+
+    BOOST_CHECK_EQUAL(cache.size(), 2U);
+    BOOST_CHECK_EQUAL(cached(cache, path("C:", "file.txt")), L"file");
+    BOOST_CHECK_EQUAL(
+        cached(cache, path("C:", "file.txt"), SHGDN_FORPARSING),
+        L"C:\\file.txt");
+    BOOST_CHECK(!cache.find(path("C:", "file.txt"), SHGDN_INFOLDER));
+    BOOST_CHECK(!cache.find(path("C:", "other.txt"), SHGDN_NORMAL));
+
+    display_name_cache_statistics stats = cache.statistics();
+    BOOST_CHECK_EQUAL(stats.hits, 2U);
+    BOOST_CHECK_EQUAL(stats.misses, 2U);
+    BOOST_CHECK_EQUAL(stats.evictions, 0U);
+}
+
+/**
+ * Inserting a name that is already cached replaces it.
+ */
+BOOST_AUTO_TEST_CASE( replace )
+{
+    display_name_cache cache(10);
+    cache.insert(path("C:", "a"), SHGDN_NORMAL, L"old");
+    cache.insert(path("C:", "a"), SHGDN_NORMAL, L"new");
+
+    BOOST_CHECK_EQUAL(cache.size(), 1U);
+    BOOST_CHECK_EQUAL(cached(cache, path("C:", "a")), L"new");
+}
+
+/**
+ * A full cache forgets the least recently used name.
+ */
+BOOST_AUTO_TEST_CASE( evict_least_recently_used )
+{
+    display_name_cache cache(2);
+    cache.insert(path("C:", "a"), SHGDN_NORMAL, L"a");
+    cache.insert(path("C:", "b"), SHGDN_NORMAL, L"b");
+
+    // Makes b the least recently used
+    BOOST_CHECK_EQUAL(cached(cache, path("C:", "a")), L"a");
+
+    cache.insert(path("C:", "c"), SHGDN_NORMAL, L"c");
+
+    BOOST_CHECK_EQUAL(cache.size(), 2U);
+    BOOST_CHECK(!cache.find(path("C:", "b"), SHGDN_NORMAL));
+    BOOST_CHECK_EQUAL(cached(cache, path("C:", "a")), L"a");
+    BOOST_CHECK_EQUAL(cached(cache, path("C:", "c")), L"c");
+    BOOST_CHECK_EQUAL(cache.statistics().evictions, 1U);
+}
+
+/**
+ * Evicting one name of a PIDL keeps its other names.
+ */
+BOOST_AUTO_TEST_CASE( evict_one_of_several_names )
+{
+    display_name_cache cache(2);
+    cache.insert(path("C:", "a"), SHGDN_NORMAL, L"a");
+    cache.insert(path("C:", "a"), SHGDN_FORPARSING, L"C:\\a");
+    cache.insert(path("C:", "b"), SHGDN_NORMAL, L"b");
+
+    BOOST_CHECK(!cache.find(path("C:", "a"), SHGDN_NORMAL));
+    BOOST_CHECK_EQUAL(
+        cached(cache, path("C:", "a"), SHGDN_FORPARSING), L"C:\\a");
+
+    BOOST_CHECK_EQUAL(cache.invalidate(path("C:", "a")), 1U);
+    BOOST_CHECK_EQUAL(cache.size(), 1U);
+}
+
+/**
+ * A cache with no capacity holds nothing.
+ */
+BOOST_AUTO_TEST_CASE( no_capacity )
+{
+    display_name_cache cache(0);
+    cache.insert(path("C:", "a"), SHGDN_NORMAL, L"a");
+
+    BOOST_CHECK(cache.empty());
+    BOOST_CHECK(!cache.find(path("C:", "a"), SHGDN_NORMAL));
+    BOOST_CHECK_EQUAL(cache.statistics().misses, 1U);
+}
+
+/**
+ * Invalidating an item forgets all its names but not those of the items
+ * below it.
+ */
+BOOST_AUTO_TEST_CASE( invalidate )
+{
+    display_name_cache cache(10);
+    cache.insert(path("C:", "dir"), SHGDN_NORMAL, L"dir");
+    cache.insert(path("C:", "dir"), SHGDN_FORPARSING, L"C:\\dir");
+    cache.insert(path("C:", "dir", "file"), SHGDN_NORMAL, L"file");
+
+    BOOST_CHECK_EQUAL(cache.invalidate(path("C:", "dir")), 2U);
+    BOOST_CHECK(!cache.find(path("C:", "dir"), SHGDN_NORMAL));
+    BOOST_CHECK(!cache.find(path("C:", "dir"), SHGDN_FORPARSING));
+    BOOST_CHECK_EQUAL(cached(cache, path("C:", "dir", "file")), L"file");
+
+    BOOST_CHECK_EQUAL(cache.invalidate(path("C:", "dir")), 0U);
+}
+
+/**
+ * Invalidating a subtree forgets the names of the item and everything
+ * below it, and nothing else.
+ */
+BOOST_AUTO_TEST_CASE( invalidate_subtree )
+{
+    display_name_cache cache(10);
+    cache.insert(path("C:"), SHGDN_NORMAL, L"Local Disk (C:)");
+    cache.insert(path("C:", "dir"), SHGDN_NORMAL, L"dir");
+    cache.insert(path("C:", "dir", "a"), SHGDN_NORMAL, L"a");
+    cache.insert(path("C:", "dir", "a"), SHGDN_FORPARSING, L"C:\\dir\\a");
+    cache.insert(path("C:", "dir", "b"), SHGDN_NORMAL, L"b");
+    cache.insert(path("C:", "other"), SHGDN_NORMAL, L"other");
+
+    BOOST_CHECK_EQUAL(cache.invalidate_subtree(path("C:", "dir")), 4U);
+    BOOST_CHECK_EQUAL(cache.size(), 2U);
+    BOOST_CHECK(!cache.find(path("C:", "dir", "a"), SHGDN_FORPARSING));
+    BOOST_CHECK_EQUAL(cached(cache, path("C:")), L"Local Disk (C:)");
+    BOOST_CHECK_EQUAL(cached(cache, path("C:", "other")), L"other");
+
+    // Forgotten names don't linger in the LRU order
+    cache.insert(path("C:", "dir"), SHGDN_NORMAL, L"dir");
+    BOOST_CHECK_EQUAL(cached(cache, path("C:", "dir")), L"dir");
+    BOOST_CHECK_EQUAL(cache.size(), 3U);
+}
+
+/**
+ * Clearing forgets every name but keeps the statistics.
+ */
+BOOST_AUTO_TEST_CASE( clear )
+{
+    display_name_cache cache(10);
+    cache.insert(path("C:", "a"), SHGDN_NORMAL, L"a");
+    cached(cache, path("C:", "a"));
+
+    cache.clear();
+
+    BOOST_CHECK(cache.empty());
+    BOOST_CHECK(!cache.find(path("C:", "a"), SHGDN_NORMAL));
+    BOOST_CHECK_EQUAL(cache.statistics().hits, 1U);
+    BOOST_CHECK_EQUAL(cache.statistics().misses, 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,224 @@
+/**
+    @file
+
+    Unit tests for the shared-list IEnumIDList implementation.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // child_pidl_from_text, pidl_matches_text
+
+#include <washer/shell/enum_id_list.hpp> // test subject
+#include <washer/shell/enum_items.hpp> // enum_item_iterator
+#include <washer/shell/pidl.hpp> // cpidl_t
+
+#include <comet/ptr.h> // com_ptr
+
+#include <boost/make_shared.hpp> // make_shared
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+using washer::shell::enum_id_list;
+using washer::shell::enum_item_iterator;
+using washer::shell::make_enum_id_list;
+using washer::shell::pidl::cpidl_t;
+using washer::shell::pidl::packed_pidl_array;
+using washer::test::child_pidl_from_text;
+using washer::test::pidl_matches_text;
+
+using comet::com_ptr;
+
+using boost::make_shared;
+
+using std::string;
+using std::vector;
+
+namespace {
+
+    vector<cpidl_t> items(const string& texts)
+    {
+        vector<cpidl_t> pidls;
+        for (string::size_type i = 0; i < texts.size(); ++i)
+        {
+            pidls.push_back(child_pidl_from_text(texts.substr(i, 1)));
+        }
+        return pidls;
+    }
+
+    com_ptr<IEnumIDList> enumerator(const string& texts)
+    {
+        vector<cpidl_t> pidls = items(texts);
+        return make_enum_id_list(pidls.begin(), pidls.end());
+    }
+
+    /**
+     * Text of each remaining item, using Next() with the given batch size.
+     */
+    string remaining(com_ptr<IEnumIDList> items, size_t batch_size=256)
+    {
+        string texts;
+        for (enum_item_iterator it(items, batch_size);
+             it != enum_item_iterator(); ++it)
+        {
+            const char* data =
+                reinterpret_cast<const char*>(it->get()) + sizeof(USHORT);
+            texts.append(data, it->get()->mkid.cb - sizeof(USHORT));
+        }
+        return texts;
+    }
+
+    void free_items(PITEMID_CHILD* items, ULONG count)
+    {
+        for (ULONG i = 0; i < count; ++i)
+        {
+            ::CoTaskMemFree(items[i]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(enum_id_list_tests)
+
+/**
+ * Asking for several items at once gets them all in order, and asking for
+ * more than remain gets the rest with S_FALSE.
+ */
+BOOST_AUTO_TEST_CASE( next_batch )
+{
+    com_ptr<IEnumIDList> e = enumerator("abcde");
+
+    PITEMID_CHILD batch[4];
+    ULONG fetched = 0;
+    BOOST_REQUIRE_EQUAL(e->Next(3, batch, &fetched), S_OK);
+    BOOST_REQUIRE_EQUAL(fetched, 3U);
+    BOOST_CHECK(pidl_matches_text(batch[0], "a"));
+    BOOST_CHECK(pidl_matches_text(batch[1], "b"));
+    BOOST_CHECK(pidl_matches_text(batch[2], "c"));
+    free_items(batch, fetched);
+
+    BOOST_REQUIRE_EQUAL(e->Next(4, batch, &fetched), S_FALSE);
+    BOOST_REQUIRE_EQUAL(fetched, 2U);
+    BOOST_CHECK(pidl_matches_text(batch[0], "d"));
+    BOOST_CHECK(pidl_matches_text(batch[1], "e"));
+    free_items(batch, fetched);
+
+    BOOST_CHECK_EQUAL(e->Next(1, batch, &fetched), S_FALSE);
+    BOOST_CHECK_EQUAL(fetched, 0U);
+}
+
+/**
+ * Every item is visited whatever the batch size.
+ */
+BOOST_AUTO_TEST_CASE( batch_sizes )
+{
+    BOOST_CHECK_EQUAL(remaining(enumerator("abcdefg"), 1), "abcdefg");
+    BOOST_CHECK_EQUAL(remaining(enumerator("abcdefg"), 3), "abcdefg");
+    BOOST_CHECK_EQUAL(remaining(enumerator("abcdefg")), "abcdefg");
+    BOOST_CHECK_EQUAL(remaining(enumerator("")), "");
+}
+
+/**
+ * Skipping moves past items; skipping past the end stops there.
+ */
+BOOST_AUTO_TEST_CASE( skip )
+{
+    com_ptr<IEnumIDList> e = enumerator("abcde");
+
+    BOOST_CHECK_EQUAL(e->Skip(2), S_OK);
+    BOOST_CHECK_EQUAL(remaining(e), "cde");
+
+    e->Reset();
+    BOOST_CHECK_EQUAL(e->Skip(6), S_FALSE);
+    BOOST_CHECK_EQUAL(remaining(e), "");
+}
+
+/**
+ * Reset starts again from the first item.
+ */
+BOOST_AUTO_TEST_CASE( reset )
+{
+    com_ptr<IEnumIDList> e = enumerator("abc");
+
+    BOOST_CHECK_EQUAL(remaining(e), "abc");
+    BOOST_CHECK_EQUAL(e->Reset(), S_OK);
+    BOOST_CHECK_EQUAL(remaining(e), "abc");
+}
+
+/**
+ * A clone starts where the original was and then moves independently.
+ */
+BOOST_AUTO_TEST_CASE( clone )
+{
+    com_ptr<IEnumIDList> e = enumerator("abcde");
+    e->Skip(1);
+
+    com_ptr<IEnumIDList> clone;
+    BOOST_REQUIRE_EQUAL(e->Clone(clone.out()), S_OK);
+    BOOST_REQUIRE(clone);
+
+    e->Skip(2);
+    BOOST_CHECK_EQUAL(remaining(clone), "bcde");
+    BOOST_CHECK_EQUAL(remaining(e), "de");
+}
+
+/**
+ * Enumerators made from the same list share it rather than copying it.
+ */
+BOOST_AUTO_TEST_CASE( shared_snapshot )
+{
+    vector<cpidl_t> pidls = items("xyz");
+    enum_id_list::snapshot snapshot =
+        make_shared<packed_pidl_array>(pidls.begin(), pidls.end());
+
+    com_ptr<IEnumIDList> first = make_enum_id_list(snapshot);
+    com_ptr<IEnumIDList> second = make_enum_id_list(snapshot);
+    pidls.clear();
+
+    BOOST_CHECK_EQUAL(remaining(first), "xyz");
+    BOOST_CHECK_EQUAL(remaining(second), "xyz");
+}
+
+/**
+ * Missing out-parameters are rejected as IEnumXXXX requires.
+ */
+BOOST_AUTO_TEST_CASE( invalid_arguments )
+{
+    com_ptr<IEnumIDList> e = enumerator("abc");
+
+    PITEMID_CHILD batch[2];
+    ULONG fetched = 0;
+    BOOST_CHECK_EQUAL(e->Next(1, NULL, &fetched), E_POINTER);
+    BOOST_CHECK_EQUAL(e->Next(2, batch, NULL), E_INVALIDARG);
+    BOOST_CHECK_EQUAL(e->Clone(NULL), E_POINTER);
+
+    // A single item may be fetched without a count
+    BOOST_REQUIRE_EQUAL(e->Next(1, batch, NULL), S_OK);
+    BOOST_CHECK(pidl_matches_text(batch[0], "a"));
+    free_items(batch, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,425 @@
+/**
+    @file
+
+    Unit tests for batched IEnumIDList iteration.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // child_pidl_from_text, pidl_matches_text
+#include "sandbox_fixture.hpp" // sandbox_fixture
+#include "wchar_output.hpp" // wstring output
+
+#include <washer/shell/enum_id_list.hpp> // make_enum_id_list
+#include <washer/shell/enum_items.hpp> // test subject
+#include <washer/shell/shell.hpp> // bind_to_handler_object
+#include <washer/shell/shell_item.hpp> // pidl_shell_item
+
+#include <comet/ptr.h> // com_ptr
+#include <comet/server.h> // simple_object
+#include <comet/util.h> // auto_coinit
+
+#include <boost/noncopyable.hpp> // noncopyable
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm> // sort
+#include <cstddef> // size_t
+#include <string>
+#include <vector>
+
+#include <ObjIdl.h> // IMallocSpy, CoRegisterMallocSpy
+
+using comet::auto_coinit;
+using comet::com_ptr;
+
+using namespace washer::shell;
+using washer::shell::pidl::apidl_t;
+using washer::shell::pidl::cpidl_t;
+using washer::test::child_pidl_from_text;
+using washer::test::pidl_matches_text;
+using washer::test::sandbox_fixture;
+
+using boost::iterator_range;
+
+using std::size_t;
+using std::sort;
+using std::string;
+using std::vector;
+using std::wstring;
+
+namespace {
+
+    class enum_items_fixture : public sandbox_fixture
+    {
+    public:
+
+        com_ptr<IShellFolder> sandbox_folder()
+        {
+            return bind_to_handler_object<IShellFolder>(sandbox_pidl());
+        }
+
+        /**
+         * Paths of every item in the sandbox, enumerated with the given batch
+         * size, sorted.
+         */
+        vector<wstring> enumerate(size_t batch_size)
+        {
+            apidl_t folder = sandbox_pidl();
+
+            vector<wstring> paths;
+            iterator_range<enum_item_iterator> items = enum_items(
+                sandbox_folder(), SHCONTF_FOLDERS | SHCONTF_NONFOLDERS, NULL,
+                batch_size);
+            for (enum_item_iterator it = items.begin(); it != items.end();
+                 ++it)
+            {
+                paths.push_back(pidl_shell_item(folder + *it).parsing_name());
+            }
+
+            sort(paths.begin(), paths.end());
+            return paths;
+        }
+    };
+
+    /**
+     * Task allocator spy counting the blocks allocated, and not yet freed,
+     * while it is registered.
+     *
+     * COM keeps hold of a revoked spy until every block allocated under it
+     * is freed, so there is only one and it lives as long as the process.
+     */
+    class allocation_spy : public IMallocSpy
+    {
+    public:
+
+        static allocation_spy& instance()
+        {
+            static allocation_spy spy;
+            return spy;
+        }
+
+        LONG outstanding() const
+        {
+            return m_outstanding;
+        }
+
+        virtual IFACEMETHODIMP QueryInterface(REFIID iid, void** object)
+        {
+            if (!object)
+                return E_POINTER;
+
+            if (iid == IID_IUnknown || iid == IID_IMallocSpy)
+            {
+                *object = this;
+                return S_OK;
+            }
+
+            *object = NULL;
+            return E_NOINTERFACE;
+        }
+
+        virtual IFACEMETHODIMP_(ULONG) AddRef() { return 1; }
+        virtual IFACEMETHODIMP_(ULONG) Release() { return 1; }
+
+        virtual IFACEMETHODIMP_(SIZE_T) PreAlloc(SIZE_T size)
+        { return size; }
+
+        virtual IFACEMETHODIMP_(void*) PostAlloc(void* block)
+        {
+            if (block)
+                ::InterlockedIncrement(&m_outstanding);
+            return block;
+        }
+
+        virtual IFACEMETHODIMP_(void*) PreFree(void* block, BOOL spied)
+        {
+            if (block && spied)
+                ::InterlockedDecrement(&m_outstanding);
+            return block;
+        }
+
+        virtual IFACEMETHODIMP_(void) PostFree(BOOL) {}
+
+        virtual IFACEMETHODIMP_(SIZE_T) PreRealloc(
+            void* block, SIZE_T size, void** new_block, BOOL)
+        {
+            *new_block = block;
+            return size;
+        }
+
+        virtual IFACEMETHODIMP_(void*) PostRealloc(void* block, BOOL)
+        { return block; }
+
+        virtual IFACEMETHODIMP_(void*) PreGetSize(void* block, BOOL)
+        { return block; }
+
+        virtual IFACEMETHODIMP_(SIZE_T) PostGetSize(SIZE_T size, BOOL)
+        { return size; }
+
+        virtual IFACEMETHODIMP_(void*) PreDidAlloc(void* block, BOOL)
+        { return block; }
+
+        virtual IFACEMETHODIMP_(int) PostDidAlloc(void*, BOOL, int result)
+        { return result; }
+
+        virtual IFACEMETHODIMP_(void) PreHeapMinimize() {}
+        virtual IFACEMETHODIMP_(void) PostHeapMinimize() {}
+
+    private:
+
+        allocation_spy() : m_outstanding(0) {}
+
+        LONG volatile m_outstanding;
+    };
+
+    /**
+     * Spy on the task allocator for the lifetime of this object.
+     */
+    class spy_on_allocations : private boost::noncopyable
+    {
+    public:
+
+        spy_on_allocations()
+        {
+            BOOST_REQUIRE_EQUAL(
+                ::CoRegisterMallocSpy(&allocation_spy::instance()), S_OK);
+        }
+
+        ~spy_on_allocations()
+        {
+            ::CoRevokeMallocSpy();
+        }
+    };
+
+    /**
+     * Enumerator over single-character items that, like some old
+     * enumerators, refuses requests for more than a given number of items.
+     *
+     * It counts the PIDLs it hands out and the requests it refuses.
+     */
+    class fake_enum_id_list : public comet::simple_object<IEnumIDList>
+    {
+    public:
+
+        typedef IEnumIDList interface_is;
+
+        fake_enum_id_list(const string& texts, ULONG max_request)
+            :
+        m_max_request(max_request), m_handed_out(0), m_refused(0)
+        {
+            vector<cpidl_t> pidls;
+            for (string::size_type i = 0; i < texts.size(); ++i)
+            {
+                pidls.push_back(child_pidl_from_text(texts.substr(i, 1)));
+            }
+            m_items = make_enum_id_list(pidls.begin(), pidls.end());
+        }
+
+        virtual IFACEMETHODIMP Next(
+            ULONG celt, PITEMID_CHILD* rgelt, ULONG* pceltFetched)
+        {
+            if (celt > m_max_request)
+            {
+                ++m_refused;
+                return E_INVALIDARG;
+            }
+
+            ULONG fetched = 0;
+            HRESULT hr = m_items->Next(celt, rgelt, &fetched);
+            m_handed_out += fetched;
+            if (pceltFetched)
+                *pceltFetched = fetched;
+            return hr;
+        }
+
+        virtual IFACEMETHODIMP Skip(ULONG celt)
+        { return m_items->Skip(celt); }
+
+        virtual IFACEMETHODIMP Reset()
+        { return m_items->Reset(); }
+
+        virtual IFACEMETHODIMP Clone(IEnumIDList**)
+        { return E_NOTIMPL; }
+
+        size_t handed_out() const { return m_handed_out; }
+        size_t refused() const { return m_refused; }
+
+    private:
+        com_ptr<IEnumIDList> m_items;
+        ULONG m_max_request;
+        size_t m_handed_out;
+        size_t m_refused;
+    };
+}
+
+BOOST_FIXTURE_TEST_SUITE(enum_items_tests, enum_items_fixture)
+
+/**
+ * An empty folder gives an empty range.
+ */
+BOOST_AUTO_TEST_CASE( empty_folder )
+{
+    auto_coinit com;
+
+    BOOST_CHECK(
+        enum_items(sandbox_folder(), SHCONTF_FOLDERS | SHCONTF_NONFOLDERS)
+        .empty());
+}
+
+/**
+ * Every item is visited once whether the batches hold one item, fewer
+ * items than the folder or more.
+ */
+BOOST_AUTO_TEST_CASE( batch_sizes )
+{
+    auto_coinit com;
+
+    vector<wstring> files = create_files(5);
+
+    vector<wstring> one_at_a_time = enumerate(1);
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        one_at_a_time.begin(), one_at_a_time.end(),
+        files.begin(), files.end());
+
+    vector<wstring> in_pairs = enumerate(2);
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        in_pairs.begin(), in_pairs.end(), files.begin(), files.end());
+
+    vector<wstring> all_at_once =
+        enumerate(enum_item_iterator::default_batch_size);
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        all_at_once.begin(), all_at_once.end(), files.begin(), files.end());
+}
+
+/**
+ * Items swapped out of the iterator stay valid after it moves on.
+ */
+BOOST_AUTO_TEST_CASE( keep_items )
+{
+    auto_coinit com;
+
+    vector<wstring> files = create_files(3);
+    apidl_t folder = sandbox_pidl();
+
+    vector<cpidl_t> kept;
+    iterator_range<enum_item_iterator> items = enum_items(
+        sandbox_folder(), SHCONTF_NONFOLDERS, NULL, 2);
+    for (enum_item_iterator it = items.begin(); it != items.end(); ++it)
+    {
+        kept.push_back(cpidl_t());
+        kept.back().swap(*it);
+    }
+
+    vector<wstring> paths;
+    for (size_t i = 0; i < kept.size(); ++i)
+    {
+        paths.push_back(pidl_shell_item(folder + kept[i]).parsing_name());
+    }
+    sort(paths.begin(), paths.end());
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        paths.begin(), paths.end(), files.begin(), files.end());
+}
+
+/**
+ * Stopping part way through a batch is fine.
+ */
+BOOST_AUTO_TEST_CASE( stop_early )
+{
+    auto_coinit com;
+
+    create_files(5);
+
+    size_t visited = 0;
+    {
+        iterator_range<enum_item_iterator> items = enum_items(
+            sandbox_folder(), SHCONTF_NONFOLDERS, NULL, 3);
+        for (enum_item_iterator it = items.begin(); it != items.end(); ++it)
+        {
+            BOOST_CHECK(!it->empty());
+            if (++visited == 2)
+                break;
+        }
+    }
+
+    BOOST_CHECK_EQUAL(visited, 2U);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
+
+BOOST_AUTO_TEST_SUITE(enum_items_fake_enumerator_tests)
+
+/**
+ * Stopping part way through a batch frees the items fetched but not
+ * visited, as well as those visited.
+ */
+BOOST_AUTO_TEST_CASE( stop_early_frees_items )
+{
+    auto_coinit com;
+    spy_on_allocations spy;
+
+    LONG before = allocation_spy::instance().outstanding();
+    {
+        fake_enum_id_list* fake = new fake_enum_id_list("abcde", 3);
+        com_ptr<IEnumIDList> items(fake);
+
+        enum_item_iterator it(items, 3);
+        BOOST_CHECK(pidl_matches_text(it->get(), "a"));
+        ++it;
+        BOOST_CHECK(pidl_matches_text(it->get(), "b"));
+
+        BOOST_CHECK_EQUAL(fake->handed_out(), 3U);
+
+        // The current item and the one still in the batch
+        BOOST_CHECK_EQUAL(allocation_spy::instance().outstanding() - before, 2);
+    }
+
+    BOOST_CHECK_EQUAL(allocation_spy::instance().outstanding(), before);
+}
+
+/**
+ * An enumerator that refuses to return more than one item per call is
+ * asked for one item at a time instead.
+ */
+BOOST_AUTO_TEST_CASE( one_item_per_call )
+{
+    fake_enum_id_list* fake = new fake_enum_id_list("abcde", 1);
+    com_ptr<IEnumIDList> items(fake);
+
+    string texts;
+    for (enum_item_iterator it(items, 3); it != enum_item_iterator(); ++it)
+    {
+        const char* data =
+            reinterpret_cast<const char*>(it->get()) + sizeof(USHORT);
+        texts.append(data, it->get()->mkid.cb - sizeof(USHORT));
+    }
+
+    BOOST_CHECK_EQUAL(texts, "abcde");
+    BOOST_CHECK_EQUAL(fake->handed_out(), 5U);
+    BOOST_CHECK_EQUAL(fake->refused(), 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
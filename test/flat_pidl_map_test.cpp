@@ -0,0 +1,187 @@
+/**
+    @file
+
+    Unit tests for basic_flat_pidl_map.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // child_pidl_from_text, pidl_matches_text
+
+#include <washer/shell/flat_pidl_map.hpp> // test subject
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept> // out_of_range
+#include <string>
+#include <utility> // pair, make_pair
+#include <vector>
+
+using namespace washer::shell::pidl;
+using washer::test::child_pidl_from_text;
+using washer::test::pidl_matches_text;
+
+using std::make_pair;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace {
+
+    typedef flat_pidl_map<int>::type int_map;
+
+    vector< pair<cpidl_t, int> > folder_contents()
+    {
+        vector< pair<cpidl_t, int> > items;
+        items.push_back(make_pair(child_pidl_from_text("lamb"), 1));
+        items.push_back(make_pair(child_pidl_from_text("Mary"), 2));
+        items.push_back(make_pair(child_pidl_from_text("had"), 3));
+        items.push_back(make_pair(child_pidl_from_text("a"), 4));
+        items.push_back(make_pair(child_pidl_from_text("little"), 5));
+        items.push_back(make_pair(child_pidl_from_text("lamb"), 6));
+        return items;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(flat_pidl_map_tests)
+
+/**
+ * An empty map finds nothing.
+ */
+BOOST_AUTO_TEST_CASE( empty )
+{
+    int_map map;
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.begin() == map.end());
+
+    cpidl_t key = child_pidl_from_text("Mary");
+    BOOST_CHECK(map.find(key) == map.end());
+    BOOST_CHECK_THROW(map.at(key), std::out_of_range);
+}
+
+/**
+ * Building a map sorts the entries by key, keeping the first value of any
+ * duplicate key.
+ */
+BOOST_AUTO_TEST_CASE( sorted_unique )
+{
+    vector< pair<cpidl_t, int> > items = folder_contents();
+    const int_map map(items.begin(), items.end());
+
+    BOOST_REQUIRE_EQUAL(map.size(), 5U);
+
+    const char* expected_keys[] = { "Mary", "a", "had", "lamb", "little" };
+    int expected_values[] = { 2, 4, 3, 1, 5 };
+
+    size_t i = 0;
+    for (int_map::const_iterator it = map.begin(); it != map.end(); ++it, ++i)
+    {
+        BOOST_CHECK(pidl_matches_text((*it).first, expected_keys[i]));
+        BOOST_CHECK_EQUAL((*it).second, expected_values[i]);
+    }
+    BOOST_CHECK_EQUAL(i, map.size());
+    BOOST_CHECK_EQUAL(map.end() - map.begin(), 5);
+}
+
+/**
+ * Values are found by raw or wrapped keys.
+ */
+BOOST_AUTO_TEST_CASE( lookup )
+{
+    vector< pair<cpidl_t, int> > items = folder_contents();
+    int_map map(items.begin(), items.end());
+
+    cpidl_t key = child_pidl_from_text("had");
+    PCUITEMID_CHILD raw_key = key.get();
+
+    BOOST_CHECK_EQUAL(map.at(raw_key), 3);
+    BOOST_CHECK_EQUAL(map.at(key), 3);
+    BOOST_CHECK_EQUAL(map.count(raw_key), 1U);
+
+    int_map::iterator it = map.find(raw_key);
+    BOOST_REQUIRE(it != map.end());
+    BOOST_CHECK(raw_pidl::equal((*it).first, raw_key));
+    BOOST_CHECK_EQUAL((*it).second, 3);
+
+    BOOST_CHECK(map.find(child_pidl_from_text("ham")) == map.end());
+    BOOST_CHECK_EQUAL(map.count(child_pidl_from_text("ham")), 0U);
+    BOOST_CHECK_THROW(
+        map.at(child_pidl_from_text("ham")), std::out_of_range);
+}
+
+/**
+ * Values can be changed in place, though keys cannot.
+ */
+BOOST_AUTO_TEST_CASE( modify_values )
+{
+    vector< pair<cpidl_t, int> > items = folder_contents();
+    int_map map(items.begin(), items.end());
+
+    cpidl_t key = child_pidl_from_text("little");
+    map.at(key) = 42;
+    (*map.find(key.get())).second += 1;
+
+    const int_map& const_map = map;
+    BOOST_CHECK_EQUAL(const_map.at(key), 43);
+
+    int_map::const_iterator it = map.find(key);
+    BOOST_CHECK(it == const_map.find(key));
+}
+
+/**
+ * The keys form a flat set in the same order as the values.
+ */
+BOOST_AUTO_TEST_CASE( keys )
+{
+    vector< pair<cpidl_t, int> > items = folder_contents();
+    int_map map(items.begin(), items.end());
+
+    const int_map::key_set_type& keys = map.keys();
+    BOOST_REQUIRE_EQUAL(keys.size(), map.size());
+
+    int_map::const_iterator it = map.begin();
+    for (size_t i = 0; i < keys.size(); ++i, ++it)
+    {
+        BOOST_CHECK((*it).first == keys[i]);
+    }
+}
+
+/**
+ * Copies are independent.
+ */
+BOOST_AUTO_TEST_CASE( copy )
+{
+    vector< pair<cpidl_t, int> > items = folder_contents();
+    int_map map(items.begin(), items.end());
+    int_map copy(map);
+
+    cpidl_t key = child_pidl_from_text("a");
+    copy.at(key) = 7;
+    BOOST_CHECK_EQUAL(map.at(key), 4);
+    BOOST_CHECK((*copy.find(key)).first != (*map.find(key)).first);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,279 @@
+/**
+    @file
+
+    Unit tests for basic_flat_pidl_set.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // child_pidl_from_text, pidl_matches_text
+
+#include <washer/shell/flat_pidl_set.hpp> // test subject
+
+#include <boost/test/unit_test.hpp>
+
+#include <cctype> // tolower
+#include <list>
+#include <string>
+#include <vector>
+
+using namespace washer::shell::pidl;
+using washer::test::child_pidl_from_text;
+using washer::test::pidl_matches_text;
+
+using std::list;
+using std::string;
+using std::vector;
+
+namespace {
+
+    vector<cpidl_t> folder_contents()
+    {
+        vector<cpidl_t> pidls;
+        pidls.push_back(child_pidl_from_text("lamb"));
+        pidls.push_back(child_pidl_from_text("Mary"));
+        pidls.push_back(child_pidl_from_text("had"));
+        pidls.push_back(child_pidl_from_text("a"));
+        pidls.push_back(child_pidl_from_text("little"));
+        pidls.push_back(child_pidl_from_text("lamb"));
+        return pidls;
+    }
+
+    string item_text(PCUITEMID_CHILD pidl)
+    {
+        const char* data = reinterpret_cast<const char*>(pidl->mkid.abID);
+        return string(data, data + pidl->mkid.cb - sizeof(USHORT));
+    }
+
+    /**
+     * Orders items by their text ignoring case, as a folder's CompareIDs
+     * might.
+     */
+    struct case_insensitive_less
+    {
+        bool operator()(PCUITEMID_CHILD lhs, PCUITEMID_CHILD rhs) const
+        {
+            string l = item_text(lhs);
+            string r = item_text(rhs);
+            for (size_t i = 0; i < l.size() && i < r.size(); ++i)
+            {
+                int lc = std::tolower(static_cast<unsigned char>(l[i]));
+                int rc = std::tolower(static_cast<unsigned char>(r[i]));
+                if (lc != rc)
+                    return lc < rc;
+            }
+            return l.size() < r.size();
+        }
+    };
+}
+
+BOOST_AUTO_TEST_SUITE(flat_pidl_set_tests)
+
+/**
+ * An empty set finds nothing.
+ */
+BOOST_AUTO_TEST_CASE( empty )
+{
+    flat_pidl_set set;
+    BOOST_CHECK(set.empty());
+    BOOST_CHECK_EQUAL(set.size(), 0U);
+    BOOST_CHECK(set.begin() == set.end());
+
+    cpidl_t item = child_pidl_from_text("Mary");
+    BOOST_CHECK(set.find(item) == set.end());
+    BOOST_CHECK_EQUAL(set.count(item.get()), 0U);
+}
+
+/**
+ * Building a set sorts the PIDLs bytewise and drops duplicates.
+ */
+BOOST_AUTO_TEST_CASE( sorted_unique )
+{
+    vector<cpidl_t> pidls = folder_contents();
+    flat_pidl_set set(pidls.begin(), pidls.end());
+
+    BOOST_REQUIRE_EQUAL(set.size(), 5U);
+    BOOST_CHECK(pidl_matches_text(set[0], "Mary"));
+    BOOST_CHECK(pidl_matches_text(set[1], "a"));
+    BOOST_CHECK(pidl_matches_text(set[2], "had"));
+    BOOST_CHECK(pidl_matches_text(set[3], "lamb"));
+    BOOST_CHECK(pidl_matches_text(set[4], "little"));
+}
+
+/**
+ * The set holds its own copies of the PIDLs one after another in a single
+ * block.
+ */
+BOOST_AUTO_TEST_CASE( contiguous_copies )
+{
+    flat_pidl_set set;
+    {
+        vector<cpidl_t> pidls = folder_contents();
+        flat_pidl_set(pidls.begin(), pidls.end()).swap(set);
+    }
+
+    for (size_t i = 0; i + 1 < set.size(); ++i)
+    {
+        BOOST_CHECK(
+            set[i + 1] == raw_pidl::skip(set[i], raw_pidl::size(set[i])));
+    }
+
+    BOOST_CHECK(pidl_matches_text(set[0], "Mary"));
+}
+
+/**
+ * Raw and wrapped PIDLs are found by value.
+ */
+BOOST_AUTO_TEST_CASE( find )
+{
+    vector<cpidl_t> pidls = folder_contents();
+    flat_pidl_set set(pidls.begin(), pidls.end());
+
+    cpidl_t key = child_pidl_from_text("lamb");
+    PCUITEMID_CHILD raw_key = key.get();
+
+    flat_pidl_set::const_iterator it = set.find(raw_key);
+    BOOST_REQUIRE(it != set.end());
+    BOOST_CHECK(*it != raw_key);
+    BOOST_CHECK(raw_pidl::equal(*it, raw_key));
+    BOOST_CHECK_EQUAL(set.index_of(raw_key), 3U);
+
+    BOOST_CHECK(set.find(key) == it);
+    BOOST_CHECK_EQUAL(set.count(key), 1U);
+}
+
+/**
+ * PIDLs not in the set, including prefixes of those that are, aren't
+ * found.
+ */
+BOOST_AUTO_TEST_CASE( find_missing )
+{
+    vector<cpidl_t> pidls = folder_contents();
+    flat_pidl_set set(pidls.begin(), pidls.end());
+
+    BOOST_CHECK(set.find(child_pidl_from_text("lam")) == set.end());
+    BOOST_CHECK(set.find(child_pidl_from_text("zebra")) == set.end());
+    BOOST_CHECK(set.find(child_pidl_from_text("")) == set.end());
+    BOOST_CHECK_EQUAL(
+        set.index_of(child_pidl_from_text("Lamb").get()), set.size());
+}
+
+/**
+ * Bounds locate where missing PIDLs would go.
+ */
+BOOST_AUTO_TEST_CASE( bounds )
+{
+    vector<cpidl_t> pidls = folder_contents();
+    flat_pidl_set set(pidls.begin(), pidls.end());
+
+    cpidl_t missing = child_pidl_from_text("ham");
+    BOOST_CHECK(set.lower_bound(missing.get()) == set.begin() + 3);
+    BOOST_CHECK(set.upper_bound(missing.get()) == set.begin() + 3);
+
+    cpidl_t present = child_pidl_from_text("had");
+    std::pair<flat_pidl_set::const_iterator, flat_pidl_set::const_iterator>
+        range = set.equal_range(present.get());
+    BOOST_CHECK(range.first == set.begin() + 2);
+    BOOST_CHECK(range.second == set.begin() + 3);
+}
+
+/**
+ * A caller-supplied comparator orders the set and decides which PIDLs are
+ * duplicates.
+ */
+BOOST_AUTO_TEST_CASE( custom_order )
+{
+    typedef basic_flat_pidl_set<
+        ITEMID_CHILD, cotaskmem_alloc<ITEMID_CHILD>, case_insensitive_less>
+        case_insensitive_set;
+
+    vector<cpidl_t> pidls = folder_contents();
+    pidls.push_back(child_pidl_from_text("MARY"));
+    case_insensitive_set set(pidls.begin(), pidls.end());
+
+    BOOST_REQUIRE_EQUAL(set.size(), 5U);
+    BOOST_CHECK(pidl_matches_text(set[0], "a"));
+    BOOST_CHECK(pidl_matches_text(set[1], "had"));
+    BOOST_CHECK(pidl_matches_text(set[2], "lamb"));
+    BOOST_CHECK(pidl_matches_text(set[3], "little"));
+    // The first of the equivalent PIDLs is kept
+    BOOST_CHECK(pidl_matches_text(set[4], "Mary"));
+
+    BOOST_CHECK_EQUAL(set.index_of(child_pidl_from_text("LAMB").get()), 2U);
+}
+
+/**
+ * Sets can be built from raw PIDLs in a non-random-access container.
+ */
+BOOST_AUTO_TEST_CASE( build_from_raw )
+{
+    vector<cpidl_t> pidls = folder_contents();
+    list<PCUITEMID_CHILD> raw_pidls;
+    for (size_t i = 0; i < pidls.size(); ++i)
+    {
+        raw_pidls.push_back(pidls[i].get());
+    }
+
+    flat_pidl_set set(raw_pidls.begin(), raw_pidls.end());
+    BOOST_CHECK_EQUAL(set.size(), 5U);
+    BOOST_CHECK(set.find(pidls[2]) != set.end());
+}
+
+/**
+ * Ranges already in order are copied as they are.
+ */
+BOOST_AUTO_TEST_CASE( ordered_unique )
+{
+    vector<cpidl_t> pidls = folder_contents();
+    flat_pidl_set sorted(pidls.begin(), pidls.end());
+
+    flat_pidl_set set(ordered_unique_range, sorted.begin(), sorted.end());
+    BOOST_REQUIRE_EQUAL(set.size(), sorted.size());
+    for (size_t i = 0; i < set.size(); ++i)
+    {
+        BOOST_CHECK(raw_pidl::equal(set[i], sorted[i]));
+        BOOST_CHECK_EQUAL(set.index_of(sorted[i]), i);
+    }
+}
+
+/**
+ * Copies are independent.
+ */
+BOOST_AUTO_TEST_CASE( copy )
+{
+    vector<cpidl_t> pidls = folder_contents();
+    flat_pidl_set copy;
+    {
+        flat_pidl_set set(pidls.begin(), pidls.end());
+        copy = set;
+        BOOST_CHECK(copy[0] != set[0]);
+    }
+
+    BOOST_CHECK_EQUAL(copy.size(), 5U);
+    BOOST_CHECK(copy.find(pidls[0]) != copy.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
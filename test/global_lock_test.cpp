@@ -31,10 +31,12 @@
 
 #include <washer/global_lock.hpp> // test subject
 
-#include <boost/shared_ptr.hpp> // shared_ptr
 #include <boost/system/system_error.hpp> // system_error
 #include <boost/test/unit_test.hpp>
-#include <boost/type_traits/remove_pointer.hpp> // remove_pointer
+#include <boost/version.hpp>
+#if (BOOST_VERSION >= 104800)
+#include <boost/move/move.hpp> // move
+#endif
 
 #include <cstring> // memcpy
 #include <string>
@@ -44,17 +46,11 @@ BOOST_AUTO_TEST_SUITE(global_lock_tests)
 namespace {
     std::string test_data = "Mary had a little lamb";
 
-    typedef boost::shared_ptr<boost::remove_pointer<HGLOBAL>::type> hglobal;
-
-    hglobal test_global()
+    void write_test_data(HGLOBAL global)
     {
-        hglobal global(
-            ::GlobalAlloc(GMEM_MOVEABLE, test_data.size()), ::GlobalFree);
-        void* p = ::GlobalLock(global.get());
+        void* p = ::GlobalLock(global);
         std::memcpy(p, &test_data[0], test_data.size());
-        ::GlobalUnlock(global.get());
-
-        return global;
+        ::GlobalUnlock(global);
     }
 }
 
@@ -63,7 +59,10 @@ namespace {
  */
 BOOST_AUTO_TEST_CASE( lock_memory )
 {
-    hglobal global = test_global();
+    washer::unique_hglobal global = washer::unique_global_alloc(
+        GMEM_MOVEABLE, test_data.size());
+    write_test_data(global.get());
+
     washer::global_lock<char> lock(global.get());
     BOOST_REQUIRE(lock.get());
 
@@ -81,4 +80,42 @@ BOOST_AUTO_TEST_CASE( invalid_lock )
         washer::global_lock<char>(NULL), boost::system::system_error);
 }
 
+/**
+ * A unique owner frees its memory unless it is released.
+ */
+BOOST_AUTO_TEST_CASE( unique_allocate_and_release )
+{
+    washer::unique_hglobal global = washer::unique_global_alloc(
+        GMEM_MOVEABLE, test_data.size());
+    BOOST_CHECK_EQUAL(::GlobalSize(global.get()), test_data.size());
+
+    HGLOBAL memory = global.get();
+    BOOST_CHECK_EQUAL(global.release(), memory);
+    BOOST_CHECK(!global.get());
+
+    ::GlobalFree(memory);
+}
+
+#if (BOOST_VERSION >= 104800)
+
+/**
+ * Moving a unique owner hands the memory over without copying it.
+ */
+BOOST_AUTO_TEST_CASE( unique_move )
+{
+    washer::unique_hglobal global = washer::unique_global_alloc(
+        GMEM_MOVEABLE, test_data.size());
+    HGLOBAL memory = global.get();
+
+    washer::unique_hglobal moved(boost::move(global));
+    BOOST_CHECK(!global.get());
+    BOOST_CHECK_EQUAL(moved.get(), memory);
+
+    global = boost::move(moved);
+    BOOST_CHECK(!moved.get());
+    BOOST_CHECK_EQUAL(global.get(), memory);
+}
+
+#endif
+
 BOOST_AUTO_TEST_SUITE_END();
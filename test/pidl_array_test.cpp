@@ -0,0 +1,201 @@
+/**
+    @file
+
+    Unit tests for PIDL arrays.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // child_pidl_from_text, absolute_pidl_from_texts
+
+#include <washer/shell/pidl_array.hpp> // test subject
+#include <washer/shell/pidl_iterator.hpp> // pidl_view_iterator
+
+#include <boost/test/unit_test.hpp>
+
+#include <list>
+#include <string>
+#include <vector>
+
+using namespace washer::shell::pidl;
+using washer::test::absolute_pidl_from_texts;
+using washer::test::child_pidl_from_text;
+using washer::test::pidl_matches_text;
+
+using std::list;
+using std::string;
+using std::vector;
+
+namespace {
+
+    vector<string> selection_texts()
+    {
+        vector<string> texts;
+        texts.push_back("Mary");
+        texts.push_back("had");
+        texts.push_back("a");
+        texts.push_back("little");
+        texts.push_back("lamb");
+        return texts;
+    }
+
+    vector<cpidl_t> selection()
+    {
+        vector<string> texts = selection_texts();
+
+        vector<cpidl_t> pidls;
+        for (size_t i = 0; i < texts.size(); ++i)
+        {
+            pidls.push_back(child_pidl_from_text(texts[i]));
+        }
+        return pidls;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(packed_pidl_array_tests)
+
+/**
+ * An empty array has no arena.
+ */
+BOOST_AUTO_TEST_CASE( empty )
+{
+    packed_pidl_array array;
+    BOOST_CHECK(array.empty());
+    BOOST_CHECK_EQUAL(array.size(), 0U);
+    BOOST_CHECK(!array.as_array());
+
+    vector<cpidl_t> pidls;
+    packed_pidl_array empty_range(pidls.begin(), pidls.end());
+    BOOST_CHECK(empty_range.empty());
+    BOOST_CHECK(!empty_range.as_array());
+}
+
+/**
+ * The array holds copies of the PIDLs, in order, each null-terminated.
+ */
+BOOST_AUTO_TEST_CASE( pack_wrapped )
+{
+    vector<cpidl_t> pidls = selection();
+    packed_pidl_array array(pidls.begin(), pidls.end());
+
+    BOOST_REQUIRE_EQUAL(array.size(), pidls.size());
+
+    PCUITEMID_CHILD_ARRAY raw_array = array.as_array();
+    for (size_t i = 0; i < pidls.size(); ++i)
+    {
+        BOOST_CHECK(raw_array[i] != pidls[i].get());
+        BOOST_CHECK(raw_pidl::equal(raw_array[i], pidls[i].get()));
+        BOOST_CHECK_EQUAL(raw_pidl::size(array[i]), pidls[i].size());
+    }
+}
+
+/**
+ * The PIDLs sit one after another, following the pointer table, in a
+ * single arena.
+ */
+BOOST_AUTO_TEST_CASE( contiguous )
+{
+    vector<cpidl_t> pidls = selection();
+    packed_pidl_array array(pidls.begin(), pidls.end());
+
+    size_t expected_offset = pidls.size() * sizeof(PCUITEMID_CHILD);
+    for (size_t i = 0; i < pidls.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(array.offset(i), expected_offset);
+        expected_offset += pidls[i].size();
+    }
+
+    BOOST_CHECK_EQUAL(array.bytes(), expected_offset);
+}
+
+/**
+ * Arrays can be packed from raw PIDLs in a non-random-access container.
+ */
+BOOST_AUTO_TEST_CASE( pack_raw )
+{
+    vector<cpidl_t> pidls = selection();
+    list<PCUITEMID_CHILD> raw_pidls;
+    for (size_t i = 0; i < pidls.size(); ++i)
+    {
+        raw_pidls.push_back(pidls[i].get());
+    }
+
+    packed_pidl_array array(raw_pidls.begin(), raw_pidls.end());
+
+    BOOST_REQUIRE_EQUAL(array.size(), pidls.size());
+    BOOST_CHECK(pidl_matches_text(array[4], "lamb"));
+}
+
+/**
+ * Arrays can be packed from the items of a PIDL without copying them
+ * individually first.
+ */
+BOOST_AUTO_TEST_CASE( pack_views )
+{
+    apidl_t pidl = absolute_pidl_from_texts(selection_texts());
+
+    packed_pidl_array array(
+        pidl_view_iterator(pidl), pidl_view_iterator::end(pidl));
+
+    BOOST_REQUIRE_EQUAL(array.size(), 5U);
+    BOOST_CHECK(pidl_matches_text(array[0], "Mary"));
+    BOOST_CHECK(pidl_matches_text(array[3], "little"));
+    BOOST_CHECK_EQUAL(raw_pidl::size(array[0]), 8U);
+}
+
+/**
+ * Copies have their own arena with the table pointing into it.
+ */
+BOOST_AUTO_TEST_CASE( copy )
+{
+    vector<cpidl_t> pidls = selection();
+    packed_pidl_array array(pidls.begin(), pidls.end());
+    packed_pidl_array copy(array);
+
+    BOOST_REQUIRE_EQUAL(copy.size(), array.size());
+    for (size_t i = 0; i < array.size(); ++i)
+    {
+        BOOST_CHECK(copy[i] != array[i]);
+        BOOST_CHECK_EQUAL(copy.offset(i), array.offset(i));
+        BOOST_CHECK(raw_pidl::equal(copy[i], array[i]));
+    }
+}
+
+/**
+ * The array outlives the PIDLs it was packed from.
+ */
+BOOST_AUTO_TEST_CASE( outlive_source )
+{
+    packed_pidl_array array;
+    {
+        vector<cpidl_t> pidls = selection();
+        packed_pidl_array(pidls.begin(), pidls.end()).swap(array);
+    }
+
+    BOOST_CHECK(pidl_matches_text(array[1], "had"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
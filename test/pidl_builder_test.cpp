@@ -0,0 +1,201 @@
+/**
+    @file
+
+    Unit tests for basic_pidl_builder.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // child_pidl_from_text, binary_equal_pidls
+
+#include <washer/shell/pidl_builder.hpp> // test subject
+
+#include <boost/test/unit_test.hpp>
+
+#include <ShlObj.h> // ILCombine, ILFree
+
+using namespace washer::shell::pidl;
+using washer::test::binary_equal_pidls;
+using washer::test::child_pidl_from_text;
+
+BOOST_AUTO_TEST_SUITE(pidl_builder_tests)
+
+/**
+ * A new builder holds nothing and allocates nothing.
+ */
+BOOST_AUTO_TEST_CASE( create )
+{
+    apidl_builder builder;
+    BOOST_CHECK(!builder.get());
+    BOOST_CHECK(builder.empty());
+    BOOST_CHECK_EQUAL(builder.size(), 0U);
+    BOOST_CHECK_EQUAL(builder.capacity(), 0U);
+    BOOST_CHECK(!builder.release());
+}
+
+/**
+ * Appending items one at a time should give the same PIDL as joining them.
+ */
+BOOST_AUTO_TEST_CASE( append_items )
+{
+    cpidl_t a = child_pidl_from_text("Mary");
+    cpidl_t b = child_pidl_from_text("had");
+    cpidl_t c = child_pidl_from_text("a little lamb");
+
+    apidl_builder builder;
+    builder += a;
+    builder += b.get();
+    builder.append(c);
+
+    apidl_t expected = apidl_t() + a + b + c;
+
+    BOOST_CHECK(binary_equal_pidls(builder.get(), expected.get()));
+    BOOST_CHECK_EQUAL(builder.size(), ::ILGetSize(expected.get()));
+    BOOST_CHECK(!builder.empty());
+}
+
+/**
+ * Appending a multi-item relative PIDL should append all its items.
+ */
+BOOST_AUTO_TEST_CASE( append_relative )
+{
+    pidl_t relative =
+        pidl_t() + child_pidl_from_text("Mary") + child_pidl_from_text("had");
+
+    apidl_builder builder(apidl_t() + child_pidl_from_text("root"));
+    builder += relative;
+
+    apidl_t expected = apidl_t() + child_pidl_from_text("root") + relative;
+
+    BOOST_CHECK(binary_equal_pidls(builder.get(), expected.get()));
+}
+
+/**
+ * Appending an empty PIDL should leave the PIDL unchanged but terminated.
+ */
+BOOST_AUTO_TEST_CASE( append_empty )
+{
+    SHITEMID empty = {0, {0}};
+
+    apidl_builder builder;
+    builder += reinterpret_cast<PCUIDLIST_RELATIVE>(&empty);
+
+    BOOST_REQUIRE(builder.get());
+    BOOST_CHECK(builder.empty());
+    BOOST_CHECK_EQUAL(builder.size(), sizeof(USHORT));
+}
+
+/**
+ * Once enough space is reserved, appending must not move the buffer.
+ */
+BOOST_AUTO_TEST_CASE( reserve )
+{
+    cpidl_t item = child_pidl_from_text("Elizabeth");
+
+    apidl_builder builder;
+    builder.reserve(10 * item.size());
+    const ITEMIDLIST_ABSOLUTE* buffer = builder.get();
+
+    for (int i = 0; i < 9; ++i)
+    {
+        builder += item;
+        BOOST_CHECK_EQUAL(builder.get(), buffer);
+    }
+}
+
+/**
+ * The buffer should grow geometrically rather than item by item.
+ */
+BOOST_AUTO_TEST_CASE( amortised_growth )
+{
+    cpidl_t item = child_pidl_from_text("Elizabeth");
+
+    apidl_builder builder;
+    int reallocations = 0;
+    size_t capacity = builder.capacity();
+    for (int i = 0; i < 1000; ++i)
+    {
+        builder += item;
+        if (builder.capacity() != capacity)
+        {
+            ++reallocations;
+            capacity = builder.capacity();
+        }
+    }
+
+    BOOST_CHECK_LT(reallocations, 20);
+}
+
+/**
+ * A builder can append its own PIDL, or the tail of it, even when that
+ * moves the buffer the appended items are read from.
+ */
+BOOST_AUTO_TEST_CASE( append_self )
+{
+    cpidl_t a = child_pidl_from_text("Mary");
+    cpidl_t b = child_pidl_from_text("had");
+
+    pidl_builder builder(pidl_t() + a + b);
+    size_t capacity = builder.capacity();
+
+    builder += builder.get();
+    BOOST_CHECK_NE(builder.capacity(), capacity);
+
+    pidl_t expected = pidl_t() + a + b + a + b;
+    BOOST_CHECK(binary_equal_pidls(builder.get(), expected.get()));
+
+    pidl_builder tail_builder(pidl_t() + a + b);
+    capacity = tail_builder.capacity();
+
+    PCUIDLIST_RELATIVE tail = reinterpret_cast<PCUIDLIST_RELATIVE>(
+        reinterpret_cast<const BYTE*>(tail_builder.get()) + a.get()->mkid.cb);
+    tail_builder += tail;
+    BOOST_CHECK_NE(tail_builder.capacity(), capacity);
+
+    expected = pidl_t() + a + b + b;
+    BOOST_CHECK(binary_equal_pidls(tail_builder.get(), expected.get()));
+}
+
+/**
+ * Releasing hands over the buffer without copying and empties the builder.
+ */
+BOOST_AUTO_TEST_CASE( release )
+{
+    apidl_builder builder;
+    builder += child_pidl_from_text("Mary");
+    builder += child_pidl_from_text("had");
+    const ITEMIDLIST_ABSOLUTE* buffer = builder.get();
+    size_t size = builder.size();
+
+    apidl_t pidl = builder.release();
+
+    BOOST_CHECK_EQUAL(pidl.get(), buffer);
+    BOOST_CHECK_EQUAL(pidl.size(), size);
+    BOOST_CHECK(!builder.get());
+    BOOST_CHECK(builder.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,114 @@
+/**
+    @file
+
+    Fixtures used in PIDL tests.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#ifndef WASHER_TEST_PIDL_FIXTURES_HPP
+#define WASHER_TEST_PIDL_FIXTURES_HPP
+#pragma once
+
+#include <washer/shell/pidl.hpp> // cpidl_t
+
+#include <boost/numeric/conversion/cast.hpp> // numeric_cast
+#include <boost/test/test_tools.hpp> // predicate_result
+
+#include <algorithm> // copy
+#include <cstring> // strlen
+#include <string>
+#include <vector>
+
+#include <ShTypes.h> // Raw PIDL types
+
+namespace washer {
+namespace test {
+
+/**
+ * Create a dummy child PIDL using some predefined text that we can later
+ * use to compare with.
+ */
+inline washer::shell::pidl::cpidl_t child_pidl_from_text(
+    const std::string& text)
+{
+    size_t pidl_length =
+        // size field + string length + terminator
+        sizeof(USHORT) + text.size() + sizeof(SHITEMID);
+    std::vector<char> buffer(pidl_length, '\0');
+
+    std::copy(text.begin(), text.end(), buffer.begin() + sizeof(USHORT));
+
+    PUITEMID_CHILD pidl = reinterpret_cast<PUITEMID_CHILD>(&buffer[0]);
+    pidl->mkid.cb = boost::numeric_cast<USHORT>(
+        pidl_length - sizeof(SHITEMID));
+    return washer::shell::pidl::cpidl_t(pidl);
+}
+
+/**
+ * Create a dummy absolute PIDL with one item per given text.
+ */
+inline washer::shell::pidl::apidl_t absolute_pidl_from_texts(
+    const std::vector<std::string>& texts)
+{
+    washer::shell::pidl::apidl_t pidl;
+    for (size_t i = 0; i < texts.size(); ++i)
+    {
+        pidl += child_pidl_from_text(texts[i]);
+    }
+    return pidl;
+}
+
+/**
+ * Check that the first item of the PIDL contains the text we expect.
+ */
+inline boost::test_tools::predicate_result pidl_matches_text(
+    PCUIDLIST_RELATIVE pidl, const std::string& text)
+{
+    size_t data_length =
+        (pidl->mkid.cb < sizeof(USHORT)) ? 0 : pidl->mkid.cb - sizeof(USHORT);
+    const char* data = reinterpret_cast<const char*>(pidl) + sizeof(USHORT);
+    return boost::test_tools::tt_detail::equal_coll_impl(
+        data, data + data_length, text.c_str(), text.c_str() + text.size());
+}
+
+/**
+ * Compare two PIDLs as a sequence of bytes.  Display mismatch as though
+ * the were streams of characters.
+ */
+inline boost::test_tools::predicate_result binary_equal_pidls(
+    PCUIDLIST_RELATIVE pidl1, PCUIDLIST_RELATIVE pidl2)
+{
+    const char* lhs = reinterpret_cast<const char*>(pidl1);
+    const char* rhs = reinterpret_cast<const char*>(pidl2);
+    return boost::test_tools::tt_detail::equal_coll_impl(
+        lhs, lhs + washer::shell::pidl::raw_pidl::size(pidl1),
+        rhs, rhs + washer::shell::pidl::raw_pidl::size(pidl2));
+}
+
+}} // namespace washer::test
+
+#endif
@@ -0,0 +1,152 @@
+/**
+    @file
+
+    Unit tests for basic_pidl_index.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // child_pidl_from_text, pidl_matches_text
+
+#include <washer/shell/pidl_index.hpp> // test subject
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept> // logic_error, out_of_range
+
+using namespace washer::shell::pidl;
+using washer::test::child_pidl_from_text;
+using washer::test::pidl_matches_text;
+
+namespace {
+
+    apidl_t mary_had_a_little_lamb()
+    {
+        return apidl_t() + child_pidl_from_text("Mary") +
+            child_pidl_from_text("had") + child_pidl_from_text("a") +
+            child_pidl_from_text("little") + child_pidl_from_text("lamb");
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(pidl_index_tests)
+
+/**
+ * Indexing an empty or NULL PIDL gives no items.
+ */
+BOOST_AUTO_TEST_CASE( empty )
+{
+    apidl_index null_index((apidl_t()));
+    BOOST_CHECK_EQUAL(null_index.depth(), 0U);
+    BOOST_CHECK(null_index.empty());
+    BOOST_CHECK_THROW(null_index.at(0), std::out_of_range);
+
+    SHITEMID empty = {0, {0}};
+    apidl_index empty_index(reinterpret_cast<PCIDLIST_ABSOLUTE>(&empty));
+    BOOST_CHECK_EQUAL(empty_index.depth(), 0U);
+    BOOST_CHECK(empty_index.empty());
+}
+
+/**
+ * Each item is accessible by position.
+ */
+BOOST_AUTO_TEST_CASE( random_access )
+{
+    apidl_t pidl = mary_had_a_little_lamb();
+    apidl_index index(pidl);
+
+    BOOST_REQUIRE_EQUAL(index.depth(), 5U);
+    BOOST_CHECK(pidl_matches_text(index[4].get(), "lamb"));
+    BOOST_CHECK(pidl_matches_text(index[0].data(), "Mary"));
+    BOOST_CHECK(pidl_matches_text(index.at(2).data(), "a"));
+    BOOST_CHECK(!index[3].is_terminated());
+    BOOST_CHECK(index[4].is_terminated());
+    BOOST_CHECK_THROW(index.at(5), std::out_of_range);
+}
+
+/**
+ * Prefixes and ancestors are views of the first N items.
+ */
+BOOST_AUTO_TEST_CASE( prefix_and_ancestor )
+{
+    apidl_t pidl = mary_had_a_little_lamb();
+    apidl_index index(pidl);
+
+    BOOST_CHECK(index.prefix(0).empty());
+    BOOST_CHECK(index.prefix(5) == apidl_view(pidl));
+    BOOST_CHECK(index.prefix(5).is_terminated());
+    BOOST_CHECK(index.ancestor(0) == apidl_view(pidl));
+    BOOST_CHECK(index.ancestor(1) == apidl_view(pidl.parent()));
+    BOOST_CHECK(
+        pidl_matches_text(index.ancestor(3).last_item().data(), "had"));
+    BOOST_CHECK(index.ancestor(5).empty());
+    BOOST_CHECK_THROW(index.prefix(6), std::out_of_range);
+    BOOST_CHECK_THROW(index.ancestor(6), std::out_of_range);
+}
+
+/**
+ * Suffixes are terminated relative views of the remaining items.
+ */
+BOOST_AUTO_TEST_CASE( suffix )
+{
+    apidl_t pidl = mary_had_a_little_lamb();
+    apidl_index index(pidl);
+
+    pidl_view rest = index.suffix(3);
+    BOOST_CHECK(rest.is_terminated());
+    BOOST_CHECK_EQUAL(rest.depth(), 2U);
+    BOOST_CHECK(pidl_matches_text(rest.get(), "little"));
+    BOOST_CHECK(pidl_matches_text(rest.last_item().get(), "lamb"));
+    BOOST_CHECK(index.suffix(5).empty());
+}
+
+/**
+ * Raw iterators can start part way through the PIDL.
+ */
+BOOST_AUTO_TEST_CASE( raw_iterator )
+{
+    apidl_t pidl = mary_had_a_little_lamb();
+    apidl_index index(pidl);
+
+    raw_pidl_iterator it = index.raw_iterator_at(3);
+    BOOST_CHECK_EQUAL(std::distance(it, raw_pidl_iterator()), 2);
+    BOOST_CHECK(pidl_matches_text(*it, "little"));
+    BOOST_CHECK(index.raw_iterator_at(5) == raw_pidl_iterator());
+}
+
+/**
+ * Indexing a bounded view stops at the end of the view.
+ */
+BOOST_AUTO_TEST_CASE( index_bounded_view )
+{
+    apidl_t pidl = mary_had_a_little_lamb();
+    apidl_index index(apidl_view(pidl).prefix(2));
+
+    BOOST_CHECK_EQUAL(index.depth(), 2U);
+    BOOST_CHECK(!index[1].is_terminated());
+    BOOST_CHECK_THROW(index.raw_iterator_at(1), std::logic_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
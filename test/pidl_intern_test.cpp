@@ -0,0 +1,220 @@
+/**
+    @file
+
+    Unit tests for PIDL interning.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // child_pidl_from_text, absolute_pidl_from_texts
+
+#include <washer/shell/pidl_intern.hpp> // test subject
+
+#include <boost/test/unit_test.hpp>
+#include <boost/version.hpp>
+#if (BOOST_VERSION >= 104800)
+#include <boost/move/move.hpp> // move
+#endif
+
+#include <string>
+#include <vector>
+
+using namespace washer::shell::pidl;
+using washer::test::absolute_pidl_from_texts;
+
+using std::string;
+using std::vector;
+
+namespace {
+
+    apidl_t folder_pidl()
+    {
+        vector<string> texts;
+        texts.push_back("Computer");
+        texts.push_back("C:");
+        texts.push_back("Windows");
+        return absolute_pidl_from_texts(texts);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(pidl_intern_tests)
+
+/**
+ * Interning separate copies of the same PIDL shares a single copy.
+ */
+BOOST_AUTO_TEST_CASE( intern_duplicates )
+{
+    apidl_intern_table table;
+    apidl_t pidl1 = folder_pidl();
+    apidl_t pidl2 = folder_pidl();
+
+    interned_apidl handle1 = table.intern(pidl1);
+    interned_apidl handle2 = table.intern(pidl2.get());
+
+    BOOST_CHECK_EQUAL(table.size(), 1U);
+    BOOST_CHECK(handle1.shares_storage_with(handle2));
+    BOOST_CHECK_EQUAL(handle1.get(), handle2.get());
+    BOOST_CHECK(handle1.get() != pidl1.get());
+    BOOST_CHECK(handle1 == handle2);
+    BOOST_CHECK_EQUAL(handle1.size(), pidl1.size());
+    BOOST_CHECK(raw_pidl::equal(handle1.get(), pidl1.get()));
+}
+
+/**
+ * Different PIDLs get their own storage.
+ */
+BOOST_AUTO_TEST_CASE( intern_different )
+{
+    apidl_intern_table table;
+    apidl_t pidl = folder_pidl();
+
+    interned_apidl folder = table.intern(pidl);
+    interned_apidl parent = table.intern(pidl.parent());
+
+    BOOST_CHECK_EQUAL(table.size(), 2U);
+    BOOST_CHECK(folder != parent);
+    BOOST_CHECK(parent < folder);
+    BOOST_CHECK_NE(hash_value(folder), hash_value(parent));
+}
+
+/**
+ * Interning a view finds the same PIDL as interning a copy of its items.
+ */
+BOOST_AUTO_TEST_CASE( intern_view )
+{
+    apidl_intern_table table;
+    apidl_t pidl = folder_pidl();
+
+    interned_apidl parent = table.intern(pidl.parent());
+    interned_apidl from_view = table.intern(apidl_view(pidl).parent());
+
+    BOOST_CHECK(parent.shares_storage_with(from_view));
+    BOOST_CHECK_EQUAL(table.size(), 1U);
+}
+
+/**
+ * NULL PIDLs are not stored.
+ */
+BOOST_AUTO_TEST_CASE( intern_null )
+{
+    apidl_intern_table table;
+
+    interned_apidl handle = table.intern(apidl_t());
+
+    BOOST_CHECK(!handle);
+    BOOST_CHECK(handle.empty());
+    BOOST_CHECK(table.empty());
+    BOOST_CHECK(handle == interned_apidl());
+}
+
+#if (BOOST_VERSION >= 104800)
+
+/**
+ * Interning a PIDL by moving it in adopts its memory if it is new.
+ */
+BOOST_AUTO_TEST_CASE( intern_move )
+{
+    apidl_intern_table table;
+    apidl_t pidl = folder_pidl();
+    PCIDLIST_ABSOLUTE raw = pidl.get();
+
+    interned_apidl handle = table.intern(boost::move(pidl));
+
+    BOOST_CHECK(!pidl);
+    BOOST_CHECK_EQUAL(handle.get(), raw);
+}
+
+#endif
+
+/**
+ * Handles keep their PIDL alive after the table has gone.
+ */
+BOOST_AUTO_TEST_CASE( outlive_table )
+{
+    interned_apidl handle;
+    {
+        apidl_intern_table table;
+        handle = table.intern(folder_pidl());
+    }
+
+    BOOST_CHECK(raw_pidl::equal(handle.get(), folder_pidl().get()));
+}
+
+/**
+ * Handles from different tables compare by value.
+ */
+BOOST_AUTO_TEST_CASE( compare_across_tables )
+{
+    apidl_intern_table table1;
+    apidl_intern_table table2;
+
+    interned_apidl handle1 = table1.intern(folder_pidl());
+    interned_apidl handle2 = table2.intern(folder_pidl());
+
+    BOOST_CHECK(!handle1.shares_storage_with(handle2));
+    BOOST_CHECK(handle1 == handle2);
+    BOOST_CHECK_EQUAL(hash_value(handle1), hash_value(handle2));
+}
+
+/**
+ * Purging frees only the PIDLs without handles.
+ */
+BOOST_AUTO_TEST_CASE( purge )
+{
+    apidl_intern_table table;
+    apidl_t pidl = folder_pidl();
+
+    interned_apidl kept = table.intern(pidl);
+    table.intern(pidl.parent());
+
+    BOOST_CHECK_EQUAL(table.purge(), 1U);
+    BOOST_CHECK_EQUAL(table.size(), 1U);
+    BOOST_CHECK(table.intern(pidl).shares_storage_with(kept));
+}
+
+/**
+ * Statistics count the bytes that sharing saves.
+ */
+BOOST_AUTO_TEST_CASE( statistics )
+{
+    apidl_intern_table table;
+    apidl_t pidl = folder_pidl();
+
+    vector<interned_apidl> handles;
+    for (int i = 0; i < 10; ++i)
+    {
+        handles.push_back(table.intern(pidl));
+    }
+    interned_apidl parent = table.intern(pidl.parent());
+
+    pidl_intern_statistics stats = table.statistics();
+    BOOST_CHECK_EQUAL(stats.unique_pidls, 2U);
+    BOOST_CHECK_EQUAL(stats.handles, 11U);
+    BOOST_CHECK_EQUAL(stats.stored_bytes, pidl.size() + parent.size());
+    BOOST_CHECK_EQUAL(stats.saved_bytes, 9 * pidl.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
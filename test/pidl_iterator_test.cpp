@@ -35,11 +35,13 @@
 
 #include <washer/shell/shell.hpp> // special_folder_pidl
 
+#include <boost/lexical_cast.hpp> // lexical_cast
 #include <boost/numeric/conversion/cast.hpp> // numeric_cast
 #include <boost/test/unit_test.hpp>
 
 #include <algorithm> // copy
 #include <cstring> // strlen
+#include <stdexcept> // logic_error, range_error
 #include <vector>
 
 using namespace washer::shell::pidl;
@@ -398,3 +400,192 @@ BOOST_AUTO_TEST_CASE( mixed_equality )
 }
 
 BOOST_AUTO_TEST_SUITE_END()
+
+
+BOOST_AUTO_TEST_SUITE(pidl_view_iterator_tests)
+
+/**
+ * Default constructor should result in an end iterator.
+ */
+BOOST_AUTO_TEST_CASE( default_construct )
+{
+    pidl_view_iterator it;
+    BOOST_CHECK(it == pidl_view_iterator());
+    BOOST_CHECK_EQUAL(std::distance(it, pidl_view_iterator()), 0);
+}
+
+/**
+ * Iterating over the desktop PIDL should give no items.
+ */
+BOOST_AUTO_TEST_CASE( desktop_root )
+{
+    apidl_t desktop = special_folder_pidl(CSIDL_DESKTOP);
+    pidl_view_iterator it(desktop);
+    BOOST_CHECK(it == pidl_view_iterator());
+    BOOST_CHECK_EQUAL(std::distance(it, pidl_view_iterator()), 0);
+}
+
+/**
+ * Each item should be a view into the original PIDL rather than a copy.
+ */
+BOOST_AUTO_TEST_CASE( iterate_over_multi_item_pidl )
+{
+    apidl_t p =
+        apidl_t() + child_pidl_from_text("Mary") + child_pidl_from_text("had")
+        + child_pidl_from_text("a") + child_pidl_from_text("little")
+        + child_pidl_from_text("lamb");
+
+    pidl_view_iterator it(p);
+    BOOST_CHECK_EQUAL(std::distance(it, pidl_view_iterator()), 5);
+    BOOST_CHECK_EQUAL(
+        reinterpret_cast<const void*>((*it).data()),
+        reinterpret_cast<const void*>(p.get()));
+    BOOST_CHECK(pidl_matches_text((*it++).data(), "Mary"));
+    BOOST_CHECK(pidl_matches_text((*it++).data(), "had"));
+    BOOST_CHECK(pidl_matches_text((*it++).data(), "a"));
+    BOOST_CHECK(pidl_matches_text((*it++).data(), "little"));
+    BOOST_CHECK((*it).is_terminated());
+    BOOST_CHECK(pidl_matches_text((*it++).get(), "lamb"));
+    BOOST_CHECK(it == pidl_view_iterator());
+    BOOST_CHECK_THROW(*it, std::logic_error);
+    BOOST_CHECK_THROW(++it, std::range_error);
+}
+
+/**
+ * Only the last item of a terminated PIDL is itself terminated.
+ */
+BOOST_AUTO_TEST_CASE( item_termination )
+{
+    apidl_t p =
+        apidl_t() + child_pidl_from_text("Mary") + child_pidl_from_text("had");
+
+    pidl_view_iterator it(p);
+    BOOST_CHECK(!(*it).is_terminated());
+    BOOST_CHECK_THROW((*it).get(), std::logic_error);
+    ++it;
+    BOOST_CHECK((*it).is_terminated());
+}
+
+/**
+ * Copying the items out of the views should rebuild the original PIDL.
+ */
+BOOST_AUTO_TEST_CASE( deep_copy_on_request )
+{
+    apidl_t p =
+        apidl_t() + child_pidl_from_text("Mary") + child_pidl_from_text("had")
+        + child_pidl_from_text("a") + child_pidl_from_text("little")
+        + child_pidl_from_text("lamb");
+
+    apidl_t q;
+    for (pidl_view_iterator it(p); it != pidl_view_iterator(); ++it)
+    {
+        q += cpidl_t(*it);
+    }
+
+    BOOST_CHECK(::ILIsEqual(p.get(), q.get()));
+}
+
+/**
+ * The iterator should be able to walk backwards from the end.
+ */
+BOOST_AUTO_TEST_CASE( iterate_backwards )
+{
+    apidl_t p =
+        apidl_t() + child_pidl_from_text("Mary") + child_pidl_from_text("had")
+        + child_pidl_from_text("a");
+
+    pidl_view_iterator begin(p);
+    pidl_view_iterator it = pidl_view_iterator::end(p);
+    BOOST_CHECK(it == pidl_view_iterator());
+
+    BOOST_CHECK(pidl_matches_text((*--it).data(), "a"));
+    BOOST_CHECK(pidl_matches_text((*--it).data(), "had"));
+    BOOST_CHECK(pidl_matches_text((*--it).data(), "Mary"));
+    BOOST_CHECK(it == begin);
+    BOOST_CHECK_THROW(--it, std::range_error);
+}
+
+/**
+ * Walking backwards must work even for PIDLs with many more items than the
+ * iterator has checkpoints.
+ */
+BOOST_AUTO_TEST_CASE( iterate_backwards_deep_pidl )
+{
+    apidl_t p;
+    for (int i = 0; i < 300; ++i)
+    {
+        p += child_pidl_from_text(boost::lexical_cast<std::string>(i));
+    }
+
+    pidl_view_iterator it = pidl_view_iterator::end(p);
+    for (int i = 299; i >= 0; --i)
+    {
+        --it;
+        BOOST_CHECK(
+            pidl_matches_text(
+                (*it).data(), boost::lexical_cast<std::string>(i)));
+    }
+    BOOST_CHECK(it == pidl_view_iterator(p));
+}
+
+/**
+ * Stepping back and forth repeatedly must keep the iterator's checkpoints
+ * consistent with where it is.
+ */
+BOOST_AUTO_TEST_CASE( iterate_back_and_forth_deep_pidl )
+{
+    apidl_t p;
+    for (int i = 0; i < 200; ++i)
+    {
+        p += child_pidl_from_text(boost::lexical_cast<std::string>(i));
+    }
+
+    pidl_view_iterator it(p);
+    int index = 0;
+    for (int round = 0; round < 10; ++round)
+    {
+        for (int i = 0; i < 37; ++i, ++index)
+        {
+            ++it;
+        }
+        for (int i = 0; i < 23; ++i, --index)
+        {
+            --it;
+        }
+
+        BOOST_CHECK(
+            pidl_matches_text(
+                (*it).data(), boost::lexical_cast<std::string>(index)));
+    }
+
+    while (index > 0)
+    {
+        --it;
+        --index;
+        BOOST_CHECK(
+            pidl_matches_text(
+                (*it).data(), boost::lexical_cast<std::string>(index)));
+    }
+    BOOST_CHECK(it == pidl_view_iterator(p));
+}
+
+/**
+ * Iterating over a bounded view must stop at the end of the view, not at
+ * the end of the memory it points into.
+ */
+BOOST_AUTO_TEST_CASE( iterate_over_bounded_view )
+{
+    apidl_t p =
+        apidl_t() + child_pidl_from_text("Mary") + child_pidl_from_text("had")
+        + child_pidl_from_text("a");
+
+    apidl_view parent = apidl_view(p).parent();
+
+    pidl_view_iterator it(parent);
+    BOOST_CHECK_EQUAL(std::distance(it, pidl_view_iterator()), 2);
+    ++it;
+    BOOST_CHECK(pidl_matches_text((*it).data(), "had"));
+    BOOST_CHECK(!(*it).is_terminated());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
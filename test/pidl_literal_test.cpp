@@ -0,0 +1,181 @@
+/**
+    @file
+
+    Unit tests for PIDL literals.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // child_pidl_from_text, binary_equal_pidls
+
+#include <washer/shell/pidl_literal.hpp> // test subject
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace washer::shell::pidl;
+using washer::test::absolute_pidl_from_texts;
+using washer::test::binary_equal_pidls;
+using washer::test::child_pidl_from_text;
+using washer::test::pidl_matches_text;
+
+using std::string;
+using std::vector;
+
+namespace {
+
+    struct four_chars
+    {
+        char text[4];
+    };
+
+    struct five_chars
+    {
+        char text[5];
+    };
+
+    const child_pidl_literal<four_chars>::type root_literal =
+    { {
+        WASHER_PIDL_LITERAL_ITEM(four_chars, { { 'r', 'o', 'o', 't' } }),
+        { 0 }
+    } };
+
+    const relative_pidl_literal<four_chars, five_chars>::type
+        relative_literal =
+    { {
+        WASHER_PIDL_LITERAL_ITEM(four_chars, { { 'r', 'o', 'o', 't' } }),
+        {
+            WASHER_PIDL_LITERAL_ITEM(
+                five_chars, { { 'c', 'h', 'i', 'l', 'd' } }),
+            { 0 }
+        }
+    } };
+
+    const absolute_pidl_literal<four_chars, five_chars>::type
+        absolute_literal =
+    { {
+        WASHER_PIDL_LITERAL_ITEM(four_chars, { { 'r', 'o', 'o', 't' } }),
+        {
+            WASHER_PIDL_LITERAL_ITEM(
+                five_chars, { { 'c', 'h', 'i', 'l', 'd' } }),
+            { 0 }
+        }
+    } };
+
+    size_t measure(PCUIDLIST_RELATIVE pidl)
+    {
+        return raw_pidl::size(pidl);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(pidl_literal_tests)
+
+/**
+ * A literal is laid out exactly as the PIDL it represents.
+ */
+BOOST_AUTO_TEST_CASE( layout )
+{
+    BOOST_CHECK_EQUAL(sizeof(root_literal), 2U + 4U + 2U);
+    BOOST_CHECK_EQUAL(sizeof(relative_literal), 2U + 4U + 2U + 5U + 2U);
+    BOOST_CHECK_EQUAL(root_literal.items.head.cb, 2U + 4U);
+    BOOST_CHECK_EQUAL(relative_literal.items.tail.head.cb, 2U + 5U);
+    BOOST_CHECK_EQUAL(root_literal.size(), sizeof(root_literal));
+    BOOST_CHECK_EQUAL(
+        raw_pidl::size(relative_literal.get()), relative_literal.size());
+}
+
+/**
+ * A child literal is the same PIDL as one built at run time.
+ */
+BOOST_AUTO_TEST_CASE( child )
+{
+    BOOST_CHECK_EQUAL(root_literal.depth(), 1U);
+    BOOST_CHECK(
+        binary_equal_pidls(
+            root_literal.get(), child_pidl_from_text("root").get()));
+    BOOST_CHECK(pidl_matches_text(root_literal.get(), "root"));
+}
+
+/**
+ * A multi-item literal is the same PIDL as one built at run time.
+ */
+BOOST_AUTO_TEST_CASE( multiple_items )
+{
+    BOOST_CHECK_EQUAL(relative_literal.depth(), 2U);
+
+    vector<string> texts;
+    texts.push_back("root");
+    texts.push_back("child");
+    apidl_t expected = absolute_pidl_from_texts(texts);
+
+    BOOST_CHECK(binary_equal_pidls(relative_literal.get(), expected.get()));
+    BOOST_CHECK(binary_equal_pidls(absolute_literal.get(), expected.get()));
+    BOOST_CHECK(
+        pidl_matches_text(raw_pidl::next(relative_literal.get()), "child"));
+}
+
+/**
+ * Literals convert to raw PIDLs implicitly, including a child literal to
+ * a relative PIDL.
+ */
+BOOST_AUTO_TEST_CASE( conversion )
+{
+    PCUITEMID_CHILD child = root_literal;
+    PCIDLIST_ABSOLUTE absolute = absolute_literal;
+
+    BOOST_CHECK_EQUAL(child, root_literal.get());
+    BOOST_CHECK_EQUAL(raw_pidl::size(absolute), absolute_literal.size());
+    BOOST_CHECK_EQUAL(measure(root_literal), root_literal.size());
+    BOOST_CHECK_EQUAL(measure(relative_literal), relative_literal.size());
+}
+
+/**
+ * Literals can be copied into and appended to allocated PIDLs.
+ */
+BOOST_AUTO_TEST_CASE( with_allocated_pidls )
+{
+    cpidl_t copy(root_literal);
+    BOOST_CHECK(binary_equal_pidls(copy.get(), root_literal.get()));
+
+    apidl_t combined = apidl_t(absolute_literal) + root_literal.get();
+    BOOST_CHECK_EQUAL(
+        combined.size(), absolute_literal.size() + root_literal.size() - 2U);
+}
+
+/**
+ * Literals pass validation.
+ */
+BOOST_AUTO_TEST_CASE( validate )
+{
+    raw_pidl::measurement m = raw_pidl::validate(
+        relative_literal.get(), relative_literal.size());
+    BOOST_CHECK_EQUAL(m.size, relative_literal.size());
+    BOOST_CHECK_EQUAL(m.depth, 2U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
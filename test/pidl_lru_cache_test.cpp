@@ -0,0 +1,185 @@
+/**
+    @file
+
+    Unit tests for the PIDL-keyed LRU cache.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // absolute_pidl_from_texts
+
+#include <washer/shell/pidl.hpp> // apidl_t, apidl_view
+#include <washer/shell/pidl_lru_cache.hpp> // test subject
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <utility> // pair
+#include <vector>
+
+using washer::shell::pidl::apidl_t;
+using washer::shell::pidl::apidl_view;
+using washer::shell::pidl_lru_cache;
+using washer::shell::pidl_lru_cache_statistics;
+using washer::test::absolute_pidl_from_texts;
+
+using std::make_pair;
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace {
+
+    typedef pidl_lru_cache<int, string> cache_type;
+    typedef vector< pair<int, string> > removal_list;
+
+    apidl_t path(const string& a, const string& b="", const string& c="")
+    {
+        vector<string> texts;
+        texts.push_back(a);
+        if (!b.empty())
+            texts.push_back(b);
+        if (!c.empty())
+            texts.push_back(c);
+        return absolute_pidl_from_texts(texts);
+    }
+
+    /**
+     * Records the values the cache removes.
+     */
+    class record_removals
+    {
+    public:
+        explicit record_removals(removal_list& removed) : m_removed(&removed)
+        {}
+
+        void operator()(int key, string& value)
+        {
+            m_removed->push_back(make_pair(key, value));
+        }
+
+    private:
+        removal_list* m_removed;
+    };
+
+    bool is_odd(int key)
+    {
+        return key % 2 != 0;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(pidl_lru_cache_tests)
+
+/**
+ * A view of part of a PIDL finds the value cached for a PIDL with the same
+ * items.
+ */
+BOOST_AUTO_TEST_CASE( find_by_view )
+{
+    cache_type cache(10);
+    cache.insert(path("C:", "dir"), 1, "dir");
+
+    apidl_t file = path("C:", "dir", "file.txt");
+    string* value = cache.find(apidl_view(file).parent(), 1);
+    BOOST_REQUIRE(value);
+    BOOST_CHECK_EQUAL(*value, "dir");
+
+    BOOST_CHECK(!cache.find(apidl_view(file), 1));
+    BOOST_CHECK(!cache.find(apidl_view(file).parent(), 2));
+}
+
+/**
+ * Replacing a value and evicting one both hand the old value to the
+ * callback.
+ */
+BOOST_AUTO_TEST_CASE( removed_on_replace_and_evict )
+{
+    removal_list removed;
+    cache_type cache(2);
+    cache.insert(path("C:", "a").get(), 1, "a1", record_removals(removed));
+    cache.insert(path("C:", "a").get(), 1, "a2", record_removals(removed));
+
+    BOOST_REQUIRE_EQUAL(removed.size(), 1U);
+    BOOST_CHECK_EQUAL(removed[0].first, 1);
+    BOOST_CHECK_EQUAL(removed[0].second, "a1");
+
+    cache.insert(path("C:", "b").get(), 2, "b", record_removals(removed));
+    cache.insert(path("C:", "c").get(), 3, "c", record_removals(removed));
+
+    BOOST_REQUIRE_EQUAL(removed.size(), 2U);
+    BOOST_CHECK_EQUAL(removed[1].first, 1);
+    BOOST_CHECK_EQUAL(removed[1].second, "a2");
+
+    pidl_lru_cache_statistics stats = cache.statistics();
+    BOOST_CHECK_EQUAL(stats.evictions, 1U);
+}
+
+/**
+ * Invalidating, and clearing, hand every forgotten value to the callback.
+ */
+BOOST_AUTO_TEST_CASE( removed_on_invalidate_and_clear )
+{
+    removal_list removed;
+    cache_type cache(10);
+    cache.insert(path("C:", "dir"), 1, "dir");
+    cache.insert(path("C:", "dir", "file"), 2, "file");
+    cache.insert(path("D:"), 3, "drive");
+
+    BOOST_CHECK_EQUAL(
+        cache.invalidate_subtree(
+            path("C:").get(), record_removals(removed)), 2U);
+    BOOST_CHECK_EQUAL(removed.size(), 2U);
+
+    cache.clear(record_removals(removed));
+    BOOST_REQUIRE_EQUAL(removed.size(), 3U);
+    BOOST_CHECK_EQUAL(removed[2].second, "drive");
+    BOOST_CHECK(cache.empty());
+}
+
+/**
+ * Values can be forgotten by their secondary key wherever they are.
+ */
+BOOST_AUTO_TEST_CASE( erase_if )
+{
+    removal_list removed;
+    cache_type cache(10);
+    cache.insert(path("C:"), 1, "one");
+    cache.insert(path("C:"), 2, "two");
+    cache.insert(path("C:", "dir"), 3, "three");
+
+    BOOST_CHECK_EQUAL(cache.erase_if(is_odd, record_removals(removed)), 2U);
+    BOOST_CHECK_EQUAL(removed.size(), 2U);
+    BOOST_CHECK_EQUAL(cache.size(), 1U);
+    BOOST_CHECK(cache.find(path("C:"), 2));
+    BOOST_CHECK(!cache.find(path("C:"), 1));
+    BOOST_CHECK(!cache.find(path("C:", "dir"), 3));
+
+    // Forgotten values are no longer reachable from the PIDL either
+    BOOST_CHECK_EQUAL(cache.invalidate_subtree(path("C:")), 1U);
+    BOOST_CHECK(cache.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END();
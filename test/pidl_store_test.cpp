@@ -0,0 +1,223 @@
+/**
+    @file
+
+    Unit tests for memory-mapped PIDL stores.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // absolute_pidl_from_texts, pidl_matches_text
+#include "sandbox_fixture.hpp" // sandbox_fixture
+
+#include <washer/shell/pidl_iterator.hpp> // raw_pidl_iterator
+#include <washer/shell/pidl_store.hpp> // test subject
+
+#include <boost/filesystem.hpp> // path
+#include <boost/filesystem/fstream.hpp> // fstream
+#include <boost/test/unit_test.hpp>
+
+#include <ios> // ios_base
+#include <iterator> // distance
+#include <stdexcept> // logic_error, out_of_range, runtime_error
+#include <string>
+#include <vector>
+
+using washer::test::absolute_pidl_from_texts;
+using washer::test::pidl_matches_text;
+using washer::test::sandbox_fixture;
+
+using namespace washer::shell::pidl;
+
+using boost::filesystem::path;
+
+using std::string;
+using std::vector;
+
+namespace {
+
+    apidl_t mary_had_a_little_lamb()
+    {
+        vector<string> texts;
+        texts.push_back("Mary");
+        texts.push_back("had");
+        texts.push_back("a");
+        texts.push_back("little");
+        texts.push_back("lamb");
+        return absolute_pidl_from_texts(texts);
+    }
+
+    /**
+     * Write a store of the given PIDL and all its ancestors, longest first.
+     */
+    void write_ancestors(const path& file, apidl_t pidl)
+    {
+        apidl_store_writer writer(file);
+        while (!pidl.empty())
+        {
+            writer.append(pidl);
+            pidl = pidl.parent();
+        }
+        writer.commit();
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(pidl_store_tests, sandbox_fixture)
+
+/**
+ * PIDLs read back match those written.
+ */
+BOOST_AUTO_TEST_CASE( round_trip )
+{
+    path file = new_file_in_sandbox();
+    apidl_t pidl = mary_had_a_little_lamb();
+    write_ancestors(file, pidl);
+
+    apidl_store_reader reader(file);
+    BOOST_REQUIRE_EQUAL(reader.size(), 5U);
+
+    BOOST_CHECK(raw_pidl::equal(reader.get(0), pidl.get()));
+    BOOST_CHECK_EQUAL(reader.pidl_size(0), pidl.size());
+    BOOST_CHECK(reader[1] == apidl_view(pidl.parent()));
+    BOOST_CHECK_EQUAL(reader.at(4).depth(), 1U);
+    BOOST_CHECK(pidl_matches_text(reader.at(4).get(), "Mary"));
+    BOOST_CHECK_THROW(reader.at(5), std::out_of_range);
+}
+
+/**
+ * The PIDLs are views into the store that iterate like any other PIDL.
+ */
+BOOST_AUTO_TEST_CASE( iterate )
+{
+    path file = new_file_in_sandbox();
+    write_ancestors(file, mary_had_a_little_lamb());
+
+    apidl_store_reader reader(file);
+    BOOST_CHECK_EQUAL(std::distance(reader.begin(), reader.end()), 5);
+
+    size_t depth = 5;
+    for (apidl_store_reader::const_iterator it = reader.begin();
+         it != reader.end(); ++it, --depth)
+    {
+        BOOST_CHECK(it->is_terminated());
+        BOOST_CHECK_EQUAL(
+            std::distance(raw_pidl_iterator(it->get()), raw_pidl_iterator()),
+            static_cast<std::ptrdiff_t>(depth));
+    }
+}
+
+/**
+ * Views of part of a PIDL are written with a terminator.
+ */
+BOOST_AUTO_TEST_CASE( append_view )
+{
+    path file = new_file_in_sandbox();
+    apidl_t pidl = mary_had_a_little_lamb();
+
+    apidl_store_writer writer(file);
+    writer.append(apidl_view(pidl).prefix(2));
+    writer.append(static_cast<PCIDLIST_ABSOLUTE>(NULL));
+    writer.commit();
+
+    apidl_store_reader reader(file);
+    BOOST_REQUIRE_EQUAL(reader.size(), 2U);
+    BOOST_CHECK_EQUAL(reader[0].depth(), 2U);
+    BOOST_CHECK(reader[0].is_terminated());
+    BOOST_CHECK(reader[1].empty());
+}
+
+/**
+ * A store with no PIDLs is valid.
+ */
+BOOST_AUTO_TEST_CASE( empty_store )
+{
+    path file = new_file_in_sandbox();
+    apidl_store_writer(file).commit();
+
+    apidl_store_reader reader(file);
+    BOOST_CHECK(reader.empty());
+    BOOST_CHECK(reader.begin() == reader.end());
+}
+
+/**
+ * Appending after committing is an error.
+ */
+BOOST_AUTO_TEST_CASE( append_after_commit )
+{
+    apidl_store_writer writer(new_file_in_sandbox());
+    writer.commit();
+
+    BOOST_CHECK_THROW(
+        writer.append(mary_had_a_little_lamb()), std::logic_error);
+}
+
+/**
+ * A store that was never committed won't open.
+ */
+BOOST_AUTO_TEST_CASE( uncommitted )
+{
+    path file = new_file_in_sandbox();
+    {
+        apidl_store_writer writer(file);
+        writer.append(mary_had_a_little_lamb());
+    }
+
+    BOOST_CHECK_THROW(apidl_store_reader reader(file), std::runtime_error);
+}
+
+/**
+ * Files that aren't stores won't open.
+ */
+BOOST_AUTO_TEST_CASE( not_a_store )
+{
+    path file = new_file_in_sandbox();
+    BOOST_CHECK_THROW(apidl_store_reader reader(file), std::runtime_error);
+
+    boost::filesystem::ofstream(file) << "Some other file";
+    BOOST_CHECK_THROW(apidl_store_reader reader(file), std::runtime_error);
+}
+
+/**
+ * A PIDL whose items run past its slot is detected when opening the store.
+ */
+BOOST_AUTO_TEST_CASE( corrupt_pidl )
+{
+    path file = new_file_in_sandbox();
+    write_ancestors(file, mary_had_a_little_lamb());
+
+    {
+        // Lengthen the first item of the first PIDL
+        boost::filesystem::fstream stream(
+            file, std::ios_base::in | std::ios_base::out |
+            std::ios_base::binary);
+        stream.seekp(sizeof(detail::pidl_store_header));
+        USHORT cb = 0xFFF0;
+        stream.write(reinterpret_cast<const char*>(&cb), sizeof(cb));
+    }
+
+    BOOST_CHECK_THROW(apidl_store_reader reader(file), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
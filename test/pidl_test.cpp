@@ -35,13 +35,20 @@
 #include <boost/test/test_case_template.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/mpl/list.hpp>
+#include <boost/version.hpp>
+#if (BOOST_VERSION >= 104800)
+#include <boost/container/vector.hpp> // vector with emulated moves
+#include <boost/move/move.hpp> // move
+#endif
 #include <boost/shared_ptr.hpp>  // shared_ptr
+#include <boost/unordered_set.hpp>  // unordered_set
 #include <boost/numeric/conversion/cast.hpp>  // numeric_cast
 
 #include <ShlObj.h>  // ILClone etc.
 
 #include <cstring> // memset, memcpy
-#include <stdexcept> // logic_error
+#include <set>
+#include <stdexcept> // invalid_argument, logic_error
 #include <string>
 #include <vector>
 
@@ -98,6 +105,55 @@ namespace {
 
     // @}
 
+    /**
+     * Number of PIDLs allocated by counting_alloc since the counter was last
+     * reset.
+     */
+    int allocation_count = 0;
+
+    /**
+     * Allocator that counts the allocations it makes so tests can check
+     * that operations don't copy PIDLs unnecessarily.
+     */
+    template<typename T>
+    struct counting_alloc
+    {
+        static T* allocate(size_t size)
+        {
+            ++allocation_count;
+            return newdelete_alloc<T>::allocate(size);
+        }
+
+        static void deallocate(T* mem) throw()
+        {
+            newdelete_alloc<T>::deallocate(mem);
+        }
+
+        template<class Other>
+        struct rebind
+        {
+            typedef counting_alloc<Other> other;
+        };
+    };
+
+    template<typename T, typename U>
+    inline bool operator==(const counting_alloc<T>&, const counting_alloc<U>&)
+    {
+        return true;
+    }
+
+    template<typename T, typename U>
+    inline bool operator!=(const counting_alloc<T>&, const counting_alloc<U>&)
+    {
+        return false;
+    }
+
+    template<typename T>
+    struct counted_pidl
+    {
+        typedef basic_pidl<T, counting_alloc<T> > type;
+    };
+
     const std::string data = "Lorem ipsum dolor sit amet.";
 
     class PidlFixture
@@ -260,6 +316,101 @@ BOOST_AUTO_TEST_CASE_TEMPLATE( size_raw_empty, T, pidl_types )
     BOOST_REQUIRE_EQUAL(raw_pidl::size(pidl), ::ILGetSize(pidl));
 }
 
+/**
+ * Validating a PIDL measures its size and depth.
+ */
+BOOST_AUTO_TEST_CASE_TEMPLATE( validate, T, adult_pidl_types )
+{
+    shared_ptr<T> pidl(
+        reinterpret_cast<T*>(
+            ::ILCombine(fake_pidl<IDABSOLUTE>(), fake_pidl<IDRELATIVE>())),
+        ::ILFree);
+    size_t size = ::ILGetSize(pidl.get());
+
+    raw_pidl::measurement measured = raw_pidl::validate(pidl.get(), size);
+    BOOST_CHECK_EQUAL(measured.size, size);
+    BOOST_CHECK_EQUAL(measured.depth, 2U);
+
+    measured = raw_pidl::validate(pidl.get(), size + 100);
+    BOOST_CHECK_EQUAL(measured.size, size);
+}
+
+/**
+ * NULL and empty PIDLs are valid.
+ */
+BOOST_AUTO_TEST_CASE_TEMPLATE( validate_null_and_empty, T, pidl_types )
+{
+    raw_pidl::measurement measured =
+        raw_pidl::validate(static_cast<const T*>(NULL), 0);
+    BOOST_CHECK_EQUAL(measured.size, 0U);
+    BOOST_CHECK_EQUAL(measured.depth, 0U);
+
+    SHITEMID empty = {0, {0}};
+    measured = raw_pidl::validate(
+        reinterpret_cast<const T*>(&empty), sizeof(empty.cb));
+    BOOST_CHECK_EQUAL(measured.size, sizeof(empty.cb));
+    BOOST_CHECK_EQUAL(measured.depth, 0U);
+}
+
+/**
+ * PIDLs that don't end within the bounds are rejected, whether the bounds
+ * cut through an item or through the null-terminator.
+ */
+BOOST_AUTO_TEST_CASE_TEMPLATE( validate_out_of_bounds, T, pidl_types )
+{
+    const T* pidl = fake_pidl<T>();
+    size_t size = ::ILGetSize(pidl);
+
+    BOOST_CHECK_THROW(
+        raw_pidl::validate(pidl, size - 1), std::invalid_argument);
+    BOOST_CHECK_THROW(
+        raw_pidl::validate(pidl, size / 2), std::invalid_argument);
+    BOOST_CHECK_THROW(raw_pidl::validate(pidl, 0), std::invalid_argument);
+}
+
+/**
+ * Items too short to hold their own length are rejected.
+ */
+BOOST_AUTO_TEST_CASE_TEMPLATE( validate_short_item, T, pidl_types )
+{
+    BYTE bytes[] = {1, 0, 0, 0};
+    BOOST_CHECK_THROW(
+        raw_pidl::validate(reinterpret_cast<const T*>(bytes), sizeof(bytes)),
+        std::invalid_argument);
+}
+
+/**
+ * Multi-item PIDLs masquerading as children are rejected.
+ */
+BOOST_AUTO_TEST_CASE( validate_type_violation )
+{
+    shared_ptr<IDCHILD> invalid_child(
+        reinterpret_cast<IDCHILD*>(
+            ::ILCombine(fake_pidl<IDABSOLUTE>(), fake_pidl<IDRELATIVE>())),
+        ::ILFree);
+
+    BOOST_CHECK_THROW(
+        raw_pidl::validate(
+            invalid_child.get(), ::ILGetSize(invalid_child.get())),
+        std::invalid_argument);
+}
+
+/**
+ * A validated PIDL can be copied without measuring it again.
+ */
+BOOST_AUTO_TEST_CASE_TEMPLATE( create_validated, T, pidl_types )
+{
+    counted_pidl<T>::type source(fake_pidl<T>());
+    raw_pidl::measurement measured =
+        raw_pidl::validate(source.get(), source.size());
+
+    allocation_count = 0;
+    counted_pidl<T>::type pidl(source.get(), measured);
+
+    BOOST_CHECK_EQUAL(allocation_count, 1);
+    BOOST_CHECK(binary_equal_pidls(pidl.get(), source.get()));
+}
+
 template<typename T, typename U>
 inline void do_combine_test(const T* pidl1, const U* pidl2)
 {
@@ -459,7 +610,7 @@ BOOST_AUTO_TEST_CASE_TEMPLATE( attach, T, pidl_types )
 {
     heap_pidl<T>::type pidl;
 
-    T* raw = raw_pidl::clone<newdelete_alloc<T>>(fake_pidl<T>());
+    T* raw = raw_pidl::clone<newdelete_alloc<T> >(fake_pidl<T>());
     pidl.attach(raw);
 
     BOOST_REQUIRE_EQUAL(pidl.get(), raw);
@@ -792,6 +943,270 @@ BOOST_AUTO_TEST_CASE_TEMPLATE( last_item_of_null_pidl, T, pidl_types )
     BOOST_CHECK_THROW(pidl.last_item(), std::logic_error);
 }
 
+#if (BOOST_VERSION >= 104800)
+
+/**
+ * Move-construct.
+ * The new basic_pidl must take over the original's PIDL without copying it
+ * and the original must be left holding NULL.
+ */
+BOOST_AUTO_TEST_CASE_TEMPLATE( move_construct, T, pidl_types )
+{
+    counted_pidl<T>::type pidl(fake_pidl<T>());
+    const T* raw = pidl.get();
+
+    allocation_count = 0;
+    counted_pidl<T>::type moved(boost::move(pidl));
+
+    BOOST_CHECK_EQUAL(allocation_count, 0);
+    BOOST_CHECK_EQUAL(moved.get(), raw);
+    BOOST_CHECK(!pidl);
+}
+
+/**
+ * Move-assign.
+ * The target must take over the original's PIDL without copying it.
+ */
+BOOST_AUTO_TEST_CASE_TEMPLATE( move_assign, T, pidl_types )
+{
+    counted_pidl<T>::type pidl(fake_pidl<T>());
+    counted_pidl<T>::type target(fake_pidl<T>());
+    const T* raw = pidl.get();
+
+    allocation_count = 0;
+    target = boost::move(pidl);
+
+    BOOST_CHECK_EQUAL(allocation_count, 0);
+    BOOST_CHECK_EQUAL(target.get(), raw);
+    BOOST_CHECK(!pidl);
+}
+
+/**
+ * Assigning a temporary moves it rather than copying it.
+ */
+BOOST_AUTO_TEST_CASE( move_assign_temporary )
+{
+    counted_pidl<IDABSOLUTE>::type target;
+
+    allocation_count = 0;
+    target = counted_pidl<IDABSOLUTE>::type(fake_pidl<IDABSOLUTE>());
+
+    BOOST_CHECK_EQUAL(allocation_count, 1);
+}
+
+/**
+ * A container that moves its elements when it grows, as Boost.Container
+ * does even without compiler support for moves, must not copy any PIDLs.
+ */
+BOOST_AUTO_TEST_CASE( move_on_container_growth )
+{
+    vector<counted_pidl<IDABSOLUTE>::type> pidls(
+        10, counted_pidl<IDABSOLUTE>::type(fake_pidl<IDABSOLUTE>()));
+
+    allocation_count = 0;
+    boost::container::vector<counted_pidl<IDABSOLUTE>::type> moved;
+    for (size_t i = 0; i < pidls.size(); ++i)
+    {
+        moved.push_back(boost::move(pidls[i]));
+    }
+
+    BOOST_CHECK_EQUAL(allocation_count, 0);
+    BOOST_CHECK_EQUAL(moved.size(), 10U);
+}
+
+#ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+
+/**
+ * The standard vector only moves elements when it grows if their move
+ * constructor can't throw.
+ */
+BOOST_AUTO_TEST_CASE( move_on_vector_growth )
+{
+    vector<counted_pidl<IDABSOLUTE>::type> pidls(
+        10, counted_pidl<IDABSOLUTE>::type(fake_pidl<IDABSOLUTE>()));
+
+    allocation_count = 0;
+    vector<counted_pidl<IDABSOLUTE>::type> moved;
+    for (size_t i = 0; i < pidls.size(); ++i)
+    {
+        moved.push_back(boost::move(pidls[i]));
+    }
+
+    BOOST_CHECK_EQUAL(allocation_count, 0);
+    BOOST_CHECK_EQUAL(moved.size(), 10U);
+}
+
+#endif
+
+#endif
+
+/**
+ * Joining two basic_pidls must allocate exactly once: for the result.
+ */
+BOOST_AUTO_TEST_CASE_TEMPLATE( join_allocation_count, T, relative_pidl_types )
+{
+    counted_pidl<IDABSOLUTE>::type pidl1(fake_pidl<IDABSOLUTE>());
+    counted_pidl<T>::type pidl2(fake_pidl<T>());
+
+    allocation_count = 0;
+    counted_pidl<IDABSOLUTE>::type joined = pidl1 + pidl2;
+
+    BOOST_CHECK_EQUAL(allocation_count, 1);
+}
+
+/**
+ * Joining a raw PIDL to a basic_pidl must not clone the raw PIDL first.
+ */
+BOOST_AUTO_TEST_CASE_TEMPLATE(
+    join_raw_allocation_count, T, relative_pidl_types )
+{
+    counted_pidl<IDABSOLUTE>::type pidl(fake_pidl<IDABSOLUTE>());
+
+    allocation_count = 0;
+    counted_pidl<IDABSOLUTE>::type joined = pidl + fake_pidl<T>();
+
+    BOOST_CHECK_EQUAL(allocation_count, 1);
+}
+
+/**
+ * Appending must allocate exactly once and the left-hand PIDL must end up
+ * owning that allocation rather than a copy of it.
+ */
+BOOST_AUTO_TEST_CASE_TEMPLATE( append_allocation_count, T, relative_pidl_types )
+{
+    counted_pidl<IDABSOLUTE>::type pidl1(fake_pidl<IDABSOLUTE>());
+    counted_pidl<T>::type pidl2(fake_pidl<T>());
+
+    allocation_count = 0;
+    pidl1 += pidl2;
+    pidl1 += fake_pidl<T>();
+
+    BOOST_CHECK_EQUAL(allocation_count, 2);
+}
+
+/**
+ * Joining a parent to many children must give the same PIDLs as joining
+ * each one with +.
+ */
+BOOST_AUTO_TEST_CASE_TEMPLATE( join_all_matches_join, T, relative_pidl_types )
+{
+    ahpidl_t parent(fake_pidl<IDABSOLUTE>());
+    vector<heap_pidl<T>::type> children;
+    for (int i = 0; i < 5; ++i)
+    {
+        children.push_back(fake_pidl<T>());
+    }
+
+    vector<ahpidl_t> joined;
+    join_all(parent, children.begin(), children.end(), joined);
+
+    BOOST_REQUIRE_EQUAL(joined.size(), children.size());
+    for (size_t i = 0; i < children.size(); ++i)
+    {
+        BOOST_CHECK(binary_equal_pidls(
+            joined[i].get(), (parent + children[i]).get()));
+    }
+}
+
+/**
+ * Joining in bulk must allocate once per child and nothing else.
+ */
+BOOST_AUTO_TEST_CASE( join_all_allocation_count )
+{
+    counted_pidl<IDABSOLUTE>::type parent(fake_pidl<IDABSOLUTE>());
+    vector<const IDCHILD*> children;
+    for (int i = 0; i < 5; ++i)
+    {
+        children.push_back(fake_pidl<IDCHILD>());
+    }
+
+    vector<counted_pidl<IDABSOLUTE>::type> joined;
+    allocation_count = 0;
+    join_all(parent, children.begin(), children.end(), joined);
+
+    BOOST_CHECK_EQUAL(allocation_count, 5);
+}
+
+/**
+ * Growing a container that already holds PIDLs must not clone them.
+ */
+BOOST_AUTO_TEST_CASE( join_all_into_non_empty_allocation_count )
+{
+    counted_pidl<IDABSOLUTE>::type parent(fake_pidl<IDABSOLUTE>());
+    vector<const IDCHILD*> children;
+    for (int i = 0; i < 5; ++i)
+    {
+        children.push_back(fake_pidl<IDCHILD>());
+    }
+
+    vector<counted_pidl<IDABSOLUTE>::type> joined(3, parent);
+    const ITEMIDLIST_ABSOLUTE* first = joined[0].get();
+
+    allocation_count = 0;
+    join_all(parent, children.begin(), children.end(), joined);
+
+    BOOST_CHECK_EQUAL(allocation_count, 5);
+    BOOST_REQUIRE_EQUAL(joined.size(), 8U);
+    BOOST_CHECK_EQUAL(joined[0].get(), first);
+    BOOST_CHECK(joined[2] == parent);
+}
+
+/**
+ * Results are appended after what was already in the container.
+ */
+BOOST_AUTO_TEST_CASE( join_all_appends )
+{
+    ahpidl_t parent(fake_pidl<IDABSOLUTE>());
+    vector<const IDCHILD*> children(1, fake_pidl<IDCHILD>());
+
+    vector<ahpidl_t> joined(1, parent);
+    join_all(parent.get(), children.begin(), children.end(), joined);
+
+    BOOST_REQUIRE_EQUAL(joined.size(), 2U);
+    BOOST_CHECK(joined[0] == parent);
+    BOOST_CHECK(joined[1].parent() == parent);
+}
+
+/**
+ * A view of part of a PIDL can be the parent.
+ */
+BOOST_AUTO_TEST_CASE( join_all_to_view )
+{
+    ahpidl_t grandparent(fake_pidl<IDABSOLUTE>());
+    ahpidl_t parent = grandparent + fake_pidl<IDCHILD>();
+    vector<const IDCHILD*> children(1, fake_pidl<IDCHILD>());
+
+    vector<ahpidl_t> joined;
+    join_all(
+        apidl_view(parent).parent(), children.begin(), children.end(),
+        joined);
+
+    BOOST_REQUIRE_EQUAL(joined.size(), 1U);
+    BOOST_CHECK(joined[0] == grandparent + children[0]);
+}
+
+/**
+ * An invalid child leaves the results untouched.
+ */
+BOOST_AUTO_TEST_CASE( join_all_invalid_child )
+{
+    ahpidl_t parent(fake_pidl<IDABSOLUTE>());
+    shared_ptr<IDCHILD> invalid_child(
+        reinterpret_cast<IDCHILD*>(
+            ::ILCombine(fake_pidl<IDABSOLUTE>(), fake_pidl<IDRELATIVE>())),
+        ::ILFree);
+
+    vector<const IDCHILD*> children;
+    children.push_back(fake_pidl<IDCHILD>());
+    children.push_back(invalid_child.get());
+
+    vector<ahpidl_t> joined(1, parent);
+    BOOST_CHECK_THROW(
+        join_all(parent, children.begin(), children.end(), joined),
+        std::invalid_argument);
+    BOOST_CHECK_EQUAL(joined.size(), 1U);
+}
+
 
 BOOST_AUTO_TEST_SUITE_END()
 #pragma endregion
@@ -908,3 +1323,291 @@ BOOST_AUTO_TEST_CASE( cast_raw_to_wrapped  )
 
 BOOST_AUTO_TEST_SUITE_END()
 #pragma endregion
+
+#pragma region PIDL comparison and hashing tests
+BOOST_FIXTURE_TEST_SUITE(pidl_comparison_tests, PidlFixture)
+
+/**
+ * PIDLs with the same items are equal even if they are separate copies.
+ */
+BOOST_AUTO_TEST_CASE_TEMPLATE( equal_copies, T, pidl_types )
+{
+    heap_pidl<T>::type pidl1(fake_pidl<T>());
+    heap_pidl<T>::type pidl2(pidl1.get());
+    BOOST_CHECK(pidl1.get() != pidl2.get());
+
+    BOOST_CHECK(raw_pidl::equal(pidl1.get(), pidl2.get()));
+    BOOST_CHECK(pidl1 == pidl2);
+    BOOST_CHECK(!(pidl1 != pidl2));
+    BOOST_CHECK(!(pidl1 < pidl2));
+    BOOST_CHECK(!(pidl2 < pidl1));
+    BOOST_CHECK_EQUAL(raw_pidl::compare(pidl1.get(), pidl2.get()), 0);
+}
+
+/**
+ * PIDLs with different items are not equal and order one way round only.
+ */
+BOOST_AUTO_TEST_CASE_TEMPLATE( unequal, T, pidl_types )
+{
+    heap_pidl<T>::type pidl1(fake_pidl<T>());
+    heap_pidl<T>::type pidl2(fake_pidl<T>());
+
+    BOOST_CHECK(pidl1 != pidl2);
+    BOOST_CHECK((pidl1 < pidl2) != (pidl2 < pidl1));
+}
+
+/**
+ * NULL and empty PIDLs both represent the desktop so are equal.
+ */
+BOOST_AUTO_TEST_CASE_TEMPLATE( null_equals_empty, T, pidl_types )
+{
+    SHITEMID empty = {0, {0}};
+    heap_pidl<T>::type empty_pidl(reinterpret_cast<const T*>(&empty));
+    heap_pidl<T>::type null_pidl;
+
+    BOOST_CHECK(empty_pidl == null_pidl);
+    BOOST_CHECK_EQUAL(hash_value(empty_pidl), hash_value(null_pidl));
+    BOOST_CHECK(empty_pidl != heap_pidl<T>::type(fake_pidl<T>()));
+}
+
+/**
+ * Allocation scheme plays no part in equality.
+ */
+BOOST_AUTO_TEST_CASE( equal_across_allocators )
+{
+    ahpidl_t pidl1(fake_pidl<IDABSOLUTE>());
+    apidl_t pidl2(pidl1.get());
+
+    BOOST_CHECK(pidl1 == pidl2);
+    BOOST_CHECK_EQUAL(hash_value(pidl1), hash_value(pidl2));
+}
+
+/**
+ * A PIDL orders before the PIDLs it is the parent of and the parent's
+ * siblings order around the whole subtree.
+ */
+BOOST_AUTO_TEST_CASE( order_parent_first )
+{
+    ahpidl_t parent(fake_pidl<IDABSOLUTE>());
+    ahpidl_t child = parent + fake_pidl<IDCHILD>();
+    ahpidl_t sibling(fake_pidl<IDABSOLUTE>());
+
+    BOOST_CHECK(parent < child);
+    BOOST_CHECK(!(child < parent));
+    BOOST_CHECK_EQUAL(parent < sibling, child < sibling);
+}
+
+/**
+ * Prefixes are ancestors or the PIDL itself.
+ */
+BOOST_AUTO_TEST_CASE( prefix )
+{
+    ahpidl_t parent(fake_pidl<IDABSOLUTE>());
+    ahpidl_t child = parent + fake_pidl<IDCHILD>();
+    ahpidl_t grandchild = child + fake_pidl<IDCHILD>();
+    ahpidl_t sibling(fake_pidl<IDABSOLUTE>());
+
+    BOOST_CHECK(is_prefix_of(parent, grandchild));
+    BOOST_CHECK(is_prefix_of(child, grandchild));
+    BOOST_CHECK(is_prefix_of(grandchild, grandchild));
+    BOOST_CHECK(!is_prefix_of(grandchild, child));
+    BOOST_CHECK(!is_prefix_of(sibling, grandchild));
+    BOOST_CHECK(is_prefix_of(ahpidl_t(), grandchild));
+    BOOST_CHECK(raw_pidl::is_prefix_of(parent.get(), child.get()));
+}
+
+/**
+ * The common prefix covers the shared items and ends on an item boundary.
+ */
+BOOST_AUTO_TEST_CASE( common_prefix_length )
+{
+    ahpidl_t parent(fake_pidl<IDABSOLUTE>());
+    ahpidl_t child = parent + fake_pidl<IDCHILD>();
+    ahpidl_t sibling = parent + fake_pidl<IDCHILD>();
+    ahpidl_t other(fake_pidl<IDABSOLUTE>());
+
+    size_t parent_items = parent.size() - sizeof(USHORT);
+    BOOST_CHECK_EQUAL(
+        raw_pidl::common_prefix_length(child.get(), sibling.get()),
+        parent_items);
+    BOOST_CHECK_EQUAL(
+        raw_pidl::common_prefix_length(parent.get(), child.get()),
+        parent_items);
+    BOOST_CHECK_EQUAL(
+        raw_pidl::common_prefix_length(child.get(), child.get()),
+        child.size() - sizeof(USHORT));
+    BOOST_CHECK_EQUAL(
+        raw_pidl::common_prefix_length(child.get(), other.get()), 0U);
+    BOOST_CHECK_EQUAL(
+        raw_pidl::common_prefix_length(
+            child.get(), static_cast<PCIDLIST_ABSOLUTE>(NULL)), 0U);
+
+
+    PCUIDLIST_RELATIVE difference = reinterpret_cast<PCUIDLIST_RELATIVE>(
+        raw_pidl::skip(
+            child.get(),
+            raw_pidl::common_prefix_length(child.get(), sibling.get())));
+    BOOST_CHECK(binary_equal_pidls(difference, child.last_item().get()));
+}
+
+/**
+ * The part of a PIDL below a root is viewed without allocating.
+ */
+BOOST_AUTO_TEST_CASE( relative_to )
+{
+    ahpidl_t root(fake_pidl<IDABSOLUTE>());
+    hpidl_t tail = hpidl_t(fake_pidl<IDCHILD>()) + fake_pidl<IDCHILD>();
+    ahpidl_t pidl = root + tail;
+
+    pidl_view relative = raw_pidl::relative_to(pidl.get(), root.get());
+    BOOST_CHECK(relative == pidl_view(tail));
+    BOOST_CHECK(relative.is_terminated());
+    BOOST_CHECK(binary_equal_pidls(pidl_t(relative).get(), tail.get()));
+
+    BOOST_CHECK(raw_pidl::relative_to(pidl.get(), pidl.get()).empty());
+    BOOST_CHECK(
+        raw_pidl::relative_to(pidl.get(), ahpidl_t().get()) ==
+        pidl_view(pidl.get()));
+}
+
+/**
+ * Only PIDLs below the root can be made relative to it.
+ */
+BOOST_AUTO_TEST_CASE( relative_to_outside_root )
+{
+    ahpidl_t root(fake_pidl<IDABSOLUTE>());
+    ahpidl_t child = root + fake_pidl<IDCHILD>();
+    ahpidl_t other = ahpidl_t(fake_pidl<IDABSOLUTE>()) + fake_pidl<IDCHILD>();
+
+    BOOST_CHECK_THROW(
+        raw_pidl::relative_to(other.get(), root.get()),
+        std::invalid_argument);
+    BOOST_CHECK_THROW(
+        raw_pidl::relative_to(root.get(), child.get()),
+        std::invalid_argument);
+}
+
+/**
+ * Rebasing swaps the root items in one allocation.
+ */
+BOOST_AUTO_TEST_CASE( rebase )
+{
+    ahpidl_t old_root(fake_pidl<IDABSOLUTE>());
+    counted_pidl<IDABSOLUTE>::type new_root(fake_pidl<IDABSOLUTE>());
+    hpidl_t tail = hpidl_t(fake_pidl<IDCHILD>()) + fake_pidl<IDCHILD>();
+    ahpidl_t pidl = old_root + tail;
+
+    allocation_count = 0;
+    counted_pidl<IDABSOLUTE>::type rebased;
+    rebased.attach(
+        raw_pidl::rebase<counting_alloc<IDABSOLUTE> >(
+            pidl.get(), old_root.get(), new_root.get()));
+
+    BOOST_CHECK_EQUAL(allocation_count, 1);
+    BOOST_CHECK(binary_equal_pidls(rebased.get(), (new_root + tail).get()));
+}
+
+/**
+ * Rebasing onto a child gives a relative PIDL and rebasing onto nothing
+ * gives just the part below the old root.
+ */
+BOOST_AUTO_TEST_CASE( rebase_types )
+{
+    ahpidl_t old_root(fake_pidl<IDABSOLUTE>());
+    chpidl_t child(fake_pidl<IDCHILD>());
+    ahpidl_t pidl = old_root + fake_pidl<IDCHILD>();
+
+    hpidl_t relative;
+    relative.attach(
+        raw_pidl::rebase<newdelete_alloc<IDABSOLUTE> >(
+            pidl.get(), old_root.get(), child.get()));
+    BOOST_CHECK(binary_equal_pidls(
+            relative.get(), (child + pidl.last_item()).get()));
+
+    hpidl_t tail;
+    tail.attach(
+        raw_pidl::rebase<newdelete_alloc<IDRELATIVE> >(
+            pidl.get(), old_root.get(),
+            static_cast<PCUIDLIST_RELATIVE>(NULL)));
+    BOOST_CHECK(binary_equal_pidls(tail.get(), pidl.last_item().get()));
+
+    BOOST_CHECK(
+        !raw_pidl::rebase<newdelete_alloc<IDRELATIVE> >(
+            static_cast<PCIDLIST_ABSOLUTE>(NULL),
+            static_cast<PCIDLIST_ABSOLUTE>(NULL),
+            static_cast<PCUIDLIST_RELATIVE>(NULL)));
+}
+
+/**
+ * Equal PIDLs hash the same and a view hashes the same as the PIDL it
+ * views.
+ */
+BOOST_AUTO_TEST_CASE( hash_equal )
+{
+    ahpidl_t pidl = ahpidl_t(fake_pidl<IDABSOLUTE>()) + fake_pidl<IDCHILD>();
+    ahpidl_t copy(pidl.get());
+
+    BOOST_CHECK_EQUAL(hash_value(pidl), hash_value(copy));
+    BOOST_CHECK_EQUAL(raw_pidl::hash(pidl.get()), hash_value(pidl));
+    BOOST_CHECK_EQUAL(hash_value(apidl_view(pidl)), hash_value(pidl));
+    BOOST_CHECK_EQUAL(
+        hash_value(apidl_view(pidl).parent()), hash_value(pidl.parent()));
+    BOOST_CHECK_NE(hash_value(pidl), hash_value(pidl.parent()));
+}
+
+/**
+ * Changing any single byte of a PIDL changes its hash.
+ *
+ * The items are an odd size so that they end in a partial word and later
+ * words land in different hash lanes.
+ */
+BOOST_AUTO_TEST_CASE( hash_single_byte_changes )
+{
+    const size_t item_size = 45;
+    std::vector<BYTE> bytes(2 * item_size + sizeof(USHORT));
+    bytes[0] = item_size;
+    bytes[item_size] = item_size;
+
+    std::set<size_t> hashes;
+    size_t hashed = 0;
+    for (size_t i = 0; i < 2 * item_size; ++i)
+    {
+        if (i == 0 || i == 1 || i == item_size || i == item_size + 1)
+            continue; // Item sizes
+
+        for (int value = 1; value < 256; value += 17)
+        {
+            BYTE original = bytes[i];
+            bytes[i] = static_cast<BYTE>(value);
+
+            hashes.insert(
+                raw_pidl::hash(
+                    reinterpret_cast<PCUIDLIST_RELATIVE>(&bytes[0])));
+            ++hashed;
+
+            bytes[i] = original;
+        }
+    }
+
+    BOOST_CHECK_EQUAL(hashes.size(), hashed);
+}
+
+/**
+ * Wrapped PIDLs can be used as keys in hashed containers.
+ */
+BOOST_AUTO_TEST_CASE( hashed_container )
+{
+    ahpidl_t pidl1(fake_pidl<IDABSOLUTE>());
+    ahpidl_t pidl2(fake_pidl<IDABSOLUTE>());
+
+    boost::unordered_set<ahpidl_t> pidls;
+    pidls.insert(pidl1);
+    pidls.insert(ahpidl_t(pidl1.get()));
+    pidls.insert(pidl2);
+
+    BOOST_CHECK_EQUAL(pidls.size(), 2U);
+    BOOST_CHECK(pidls.find(ahpidl_t(pidl2.get())) != pidls.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+#pragma endregion
@@ -0,0 +1,371 @@
+/**
+    @file
+
+    Unit tests for basic_pidl_trie.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // absolute_pidl_from_texts
+
+#include <washer/shell/pidl_trie.hpp> // test subject
+
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+#include <stdexcept> // runtime_error
+#include <string>
+#include <vector>
+
+using namespace washer::shell::pidl;
+using washer::test::absolute_pidl_from_texts;
+
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+    typedef apidl_trie<int>::type int_trie;
+
+    apidl_t path(const string& a)
+    {
+        vector<string> texts;
+        texts.push_back(a);
+        return absolute_pidl_from_texts(texts);
+    }
+
+    apidl_t path(const string& a, const string& b)
+    {
+        vector<string> texts;
+        texts.push_back(a);
+        texts.push_back(b);
+        return absolute_pidl_from_texts(texts);
+    }
+
+    apidl_t path(const string& a, const string& b, const string& c)
+    {
+        vector<string> texts;
+        texts.push_back(a);
+        texts.push_back(b);
+        texts.push_back(c);
+        return absolute_pidl_from_texts(texts);
+    }
+
+    /**
+     * Trie holding a small folder hierarchy with the values 1-6.
+     */
+    class trie_fixture
+    {
+    public:
+        trie_fixture()
+        {
+            trie.insert(path("C:"), 1);
+            trie.insert(path("C:", "Windows"), 2);
+            trie.insert(path("C:", "Windows", "System32"), 3);
+            trie.insert(path("C:", "Windows", "Fonts"), 4);
+            trie.insert(path("C:", "Users", "me"), 5);
+            trie.insert(path("D:", "Windows"), 6);
+        }
+
+        int_trie trie;
+    };
+
+    /**
+     * Collects the PIDLs and values visited.
+     */
+    class collector
+    {
+    public:
+        collector(vector<apidl_t>& pidls, vector<int>& values)
+            : m_pidls(&pidls), m_values(&values) {}
+
+        void operator()(PCIDLIST_ABSOLUTE pidl, int& value)
+        {
+            m_pidls->push_back(pidl);
+            m_values->push_back(value);
+        }
+
+    private:
+        vector<apidl_t>* m_pidls;
+        vector<int>* m_values;
+    };
+
+    struct throwing_visitor
+    {
+        void operator()(PCIDLIST_ABSOLUTE, int&)
+        {
+            throw std::runtime_error("visitor failed");
+        }
+    };
+}
+
+BOOST_AUTO_TEST_SUITE(pidl_trie_tests)
+
+/**
+ * A new trie holds nothing but its root.
+ */
+BOOST_AUTO_TEST_CASE( empty )
+{
+    int_trie trie;
+    BOOST_CHECK(trie.empty());
+    BOOST_CHECK_EQUAL(trie.size(), 0U);
+    BOOST_CHECK_EQUAL(trie.node_count(), 1U);
+    BOOST_CHECK(!trie.find(path("C:")));
+    BOOST_CHECK(!trie.find(static_cast<PCIDLIST_ABSOLUTE>(NULL)));
+}
+
+/**
+ * Values are found by PIDL, and PIDLs that only lead to values have none
+ * themselves.
+ */
+BOOST_FIXTURE_TEST_CASE( find, trie_fixture )
+{
+    BOOST_CHECK_EQUAL(trie.size(), 6U);
+
+    BOOST_REQUIRE(trie.find(path("C:", "Windows", "Fonts")));
+    BOOST_CHECK_EQUAL(*trie.find(path("C:", "Windows", "Fonts")), 4);
+    BOOST_CHECK_EQUAL(*trie.find(path("D:", "Windows").get()), 6);
+
+    BOOST_CHECK(!trie.find(path("C:", "Users")));
+    BOOST_CHECK(!trie.find(path("C:", "Program Files")));
+    BOOST_CHECK(!trie.find(path("C:", "Program Files", "x")));
+    BOOST_CHECK(!trie.find(apidl_t()));
+}
+
+/**
+ * PIDLs sharing a prefix share its nodes.
+ */
+BOOST_FIXTURE_TEST_CASE( shared_nodes, trie_fixture )
+{
+    // root, C:, Windows, System32, Fonts, Users, me, D:, Windows
+    BOOST_CHECK_EQUAL(trie.node_count(), 9U);
+}
+
+/**
+ * Inserting doesn't replace an existing value but operator[] can.
+ */
+BOOST_FIXTURE_TEST_CASE( insert_existing, trie_fixture )
+{
+    BOOST_CHECK(!trie.insert(path("C:", "Windows"), 42));
+    BOOST_CHECK_EQUAL(*trie.find(path("C:", "Windows")), 2);
+
+    trie[path("C:", "Windows")] = 42;
+    BOOST_CHECK_EQUAL(*trie.find(path("C:", "Windows")), 42);
+    BOOST_CHECK_EQUAL(trie.size(), 6U);
+}
+
+/**
+ * operator[] adds a default value to PIDLs without one, including
+ * intermediate ones.
+ */
+BOOST_FIXTURE_TEST_CASE( subscript_insert, trie_fixture )
+{
+    BOOST_CHECK_EQUAL(trie[path("C:", "Users")], 0);
+    BOOST_CHECK_EQUAL(trie.size(), 7U);
+    BOOST_CHECK_EQUAL(trie.node_count(), 9U);
+}
+
+/**
+ * The empty PIDL is the root and can hold a value too.
+ */
+BOOST_FIXTURE_TEST_CASE( root_value, trie_fixture )
+{
+    BOOST_CHECK(trie.insert(apidl_t(), 0));
+    BOOST_CHECK_EQUAL(*trie.find(static_cast<PCIDLIST_ABSOLUTE>(NULL)), 0);
+    BOOST_CHECK_EQUAL(trie.size(), 7U);
+}
+
+/**
+ * Erasing a value keeps the values below it.
+ */
+BOOST_FIXTURE_TEST_CASE( erase, trie_fixture )
+{
+    BOOST_CHECK(trie.erase(path("C:", "Windows")));
+    BOOST_CHECK(!trie.find(path("C:", "Windows")));
+    BOOST_CHECK_EQUAL(*trie.find(path("C:", "Windows", "Fonts")), 4);
+    BOOST_CHECK_EQUAL(trie.size(), 5U);
+    BOOST_CHECK_EQUAL(trie.node_count(), 9U);
+
+    BOOST_CHECK(!trie.erase(path("C:", "Windows")));
+    BOOST_CHECK(!trie.erase(path("E:")));
+}
+
+/**
+ * Erasing the last value below a node frees the nodes that only led to
+ * it.
+ */
+BOOST_FIXTURE_TEST_CASE( erase_prunes, trie_fixture )
+{
+    BOOST_CHECK(trie.erase(path("C:", "Users", "me")));
+    BOOST_CHECK_EQUAL(trie.node_count(), 7U);
+}
+
+/**
+ * Invalidating a PIDL removes it and everything below it, and nothing
+ * else.
+ */
+BOOST_FIXTURE_TEST_CASE( invalidate, trie_fixture )
+{
+    BOOST_CHECK_EQUAL(trie.invalidate(path("C:", "Windows")), 3U);
+
+    BOOST_CHECK(!trie.find(path("C:", "Windows")));
+    BOOST_CHECK(!trie.find(path("C:", "Windows", "System32")));
+    BOOST_CHECK(!trie.find(path("C:", "Windows", "Fonts")));
+    BOOST_CHECK_EQUAL(*trie.find(path("C:")), 1);
+    BOOST_CHECK_EQUAL(*trie.find(path("C:", "Users", "me")), 5);
+    BOOST_CHECK_EQUAL(*trie.find(path("D:", "Windows")), 6);
+
+    BOOST_CHECK_EQUAL(trie.size(), 3U);
+    BOOST_CHECK_EQUAL(trie.node_count(), 6U);
+}
+
+/**
+ * Invalidating a PIDL with no value of its own removes the values below it
+ * and frees the nodes leading to it.
+ */
+BOOST_FIXTURE_TEST_CASE( invalidate_valueless, trie_fixture )
+{
+    BOOST_CHECK_EQUAL(trie.invalidate(path("D:")), 1U);
+    BOOST_CHECK_EQUAL(trie.size(), 5U);
+    BOOST_CHECK_EQUAL(trie.node_count(), 7U);
+
+    BOOST_CHECK_EQUAL(trie.invalidate(path("E:")), 0U);
+}
+
+/**
+ * Invalidating the root empties the trie, after which it can be reused.
+ */
+BOOST_FIXTURE_TEST_CASE( invalidate_all, trie_fixture )
+{
+    BOOST_CHECK_EQUAL(trie.invalidate(apidl_t()), 6U);
+    BOOST_CHECK(trie.empty());
+    BOOST_CHECK_EQUAL(trie.node_count(), 1U);
+
+    trie.insert(path("C:", "Windows"), 2);
+    BOOST_CHECK_EQUAL(*trie.find(path("C:", "Windows")), 2);
+}
+
+/**
+ * Clearing empties the trie.
+ */
+BOOST_FIXTURE_TEST_CASE( clear, trie_fixture )
+{
+    trie.clear();
+    BOOST_CHECK(trie.empty());
+    BOOST_CHECK(!trie.find(path("C:")));
+
+    trie.insert(path("C:"), 1);
+    BOOST_CHECK_EQUAL(trie.size(), 1U);
+}
+
+/**
+ * Enumerating a subtree visits every value at or below the PIDL with the
+ * PIDL it is stored under.
+ */
+BOOST_FIXTURE_TEST_CASE( for_each_subtree, trie_fixture )
+{
+    vector<apidl_t> pidls;
+    vector<int> values;
+    trie.for_each(path("C:", "Windows"), collector(pidls, values));
+
+    BOOST_REQUIRE_EQUAL(pidls.size(), 3U);
+    BOOST_CHECK_EQUAL(values[0], 2);
+    BOOST_CHECK(pidls[0] == path("C:", "Windows"));
+
+    set<int> seen(values.begin(), values.end());
+    BOOST_CHECK_EQUAL(seen.size(), 3U);
+    for (size_t i = 0; i < pidls.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(*trie.find(pidls[i]), values[i]);
+    }
+}
+
+/**
+ * Enumerating from the root visits everything.
+ */
+BOOST_FIXTURE_TEST_CASE( for_each_all, trie_fixture )
+{
+    vector<apidl_t> pidls;
+    vector<int> values;
+    trie.for_each(
+        static_cast<PCIDLIST_ABSOLUTE>(NULL), collector(pidls, values));
+
+    BOOST_REQUIRE_EQUAL(pidls.size(), 6U);
+    for (size_t i = 0; i < pidls.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(*trie.find(pidls[i]), values[i]);
+    }
+}
+
+/**
+ * Enumerating below a PIDL that isn't in the trie visits nothing.
+ */
+BOOST_FIXTURE_TEST_CASE( for_each_missing, trie_fixture )
+{
+    vector<apidl_t> pidls;
+    vector<int> values;
+    trie.for_each(path("E:"), collector(pidls, values));
+    BOOST_CHECK(pidls.empty());
+}
+
+/**
+ * Exceptions from the visitor leave the trie intact.
+ */
+BOOST_FIXTURE_TEST_CASE( for_each_throws, trie_fixture )
+{
+    BOOST_CHECK_THROW(
+        trie.for_each(path("C:"), throwing_visitor()), std::runtime_error);
+    BOOST_CHECK_EQUAL(trie.size(), 6U);
+}
+
+/**
+ * Items of very different sizes are kept in nodes of different sizes.
+ */
+BOOST_AUTO_TEST_CASE( varied_item_sizes )
+{
+    int_trie trie;
+    for (size_t i = 1; i <= 300; i += 7)
+    {
+        trie.insert(path("C:", string(i, 'x')), static_cast<int>(i));
+    }
+
+    for (size_t i = 1; i <= 300; i += 7)
+    {
+        int* value = trie.find(path("C:", string(i, 'x')));
+        BOOST_REQUIRE(value);
+        BOOST_CHECK_EQUAL(*value, static_cast<int>(i));
+    }
+    BOOST_CHECK(!trie.find(path("C:", string(2, 'x'))));
+
+    BOOST_CHECK_EQUAL(trie.invalidate(path("C:")), 43U);
+    BOOST_CHECK_EQUAL(trie.node_count(), 1U);
+
+    trie.insert(path("C:", string(150, 'y')), 1);
+    BOOST_CHECK_EQUAL(*trie.find(path("C:", string(150, 'y'))), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,193 @@
+/**
+    @file
+
+    Unit tests for basic_pidl_view.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // child_pidl_from_text, pidl_matches_text
+
+#include <washer/shell/pidl.hpp> // test subject
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept> // logic_error, out_of_range
+
+#include <ShlObj.h> // ILGetSize
+
+using namespace washer::shell::pidl;
+using washer::test::binary_equal_pidls;
+using washer::test::child_pidl_from_text;
+using washer::test::pidl_matches_text;
+
+namespace {
+
+    apidl_t mary_had_a_little_lamb()
+    {
+        return apidl_t() + child_pidl_from_text("Mary") +
+            child_pidl_from_text("had") + child_pidl_from_text("a") +
+            child_pidl_from_text("little") + child_pidl_from_text("lamb");
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(pidl_view_tests)
+
+/**
+ * Default view is NULL and empty.
+ */
+BOOST_AUTO_TEST_CASE( create )
+{
+    apidl_view view;
+    BOOST_CHECK(!view);
+    BOOST_CHECK(!view.get());
+    BOOST_CHECK(view.empty());
+    BOOST_CHECK_EQUAL(view.size(), 0U);
+}
+
+/**
+ * A view of a whole PIDL points at it and measures the same.
+ */
+BOOST_AUTO_TEST_CASE( view_whole_pidl )
+{
+    apidl_t pidl = mary_had_a_little_lamb();
+    apidl_view view(pidl);
+
+    BOOST_CHECK_EQUAL(view.get(), pidl.get());
+    BOOST_CHECK_EQUAL(view.size(), ::ILGetSize(pidl.get()));
+    BOOST_CHECK_EQUAL(view.depth(), 5U);
+    BOOST_CHECK(view.is_terminated());
+}
+
+/**
+ * The last item is viewed in place and is terminated.
+ */
+BOOST_AUTO_TEST_CASE( last_item )
+{
+    apidl_t pidl = mary_had_a_little_lamb();
+    cpidl_view item = apidl_view(pidl).last_item();
+
+    BOOST_CHECK(item.is_terminated());
+    BOOST_CHECK(pidl_matches_text(item.get(), "lamb"));
+    BOOST_CHECK_EQUAL(item.get(), ::ILFindLastID(pidl.get()));
+    BOOST_CHECK_EQUAL(item.depth(), 1U);
+}
+
+/**
+ * The parent is a bounded view of the same memory.
+ */
+BOOST_AUTO_TEST_CASE( parent )
+{
+    apidl_t pidl = mary_had_a_little_lamb();
+    apidl_view parent = apidl_view(pidl).parent();
+
+    BOOST_CHECK_EQUAL(parent.data(), pidl.get());
+    BOOST_CHECK_EQUAL(parent.depth(), 4U);
+    BOOST_CHECK(!parent.is_terminated());
+    BOOST_CHECK_THROW(parent.get(), std::logic_error);
+
+    BOOST_CHECK(pidl_matches_text(parent.last_item().data(), "little"));
+    BOOST_CHECK(binary_equal_pidls(apidl_t(parent).get(), pidl.parent().get()));
+}
+
+/**
+ * Repeatedly taking the parent ends at an empty view, which can be used
+ * as the desktop PIDL.
+ */
+BOOST_AUTO_TEST_CASE( parent_to_root )
+{
+    apidl_t pidl = mary_had_a_little_lamb();
+    apidl_view view(pidl);
+    for (int i = 0; i < 5; ++i)
+    {
+        view = view.parent();
+    }
+
+    BOOST_CHECK(view.empty());
+    BOOST_REQUIRE(view.get());
+    BOOST_CHECK_EQUAL(view.get()->mkid.cb, 0U);
+    BOOST_CHECK_THROW(view.parent(), std::logic_error);
+    BOOST_CHECK_THROW(view.last_item(), std::logic_error);
+}
+
+/**
+ * Prefixes contain the first N items.
+ */
+BOOST_AUTO_TEST_CASE( prefix )
+{
+    apidl_t pidl = mary_had_a_little_lamb();
+    apidl_view view(pidl);
+
+    BOOST_CHECK(view.prefix(0).empty());
+    BOOST_CHECK(pidl_matches_text(view.prefix(2).last_item().data(), "had"));
+    BOOST_CHECK(view.prefix(5) == view);
+    BOOST_CHECK(view.prefix(5).is_terminated());
+    BOOST_CHECK_THROW(view.prefix(6), std::out_of_range);
+}
+
+/**
+ * Views compare equal when their items are bytewise equal, wherever they
+ * are in memory.
+ */
+BOOST_AUTO_TEST_CASE( equality )
+{
+    apidl_t pidl1 = mary_had_a_little_lamb();
+    apidl_t pidl2 = mary_had_a_little_lamb();
+
+    BOOST_CHECK(apidl_view(pidl1) == apidl_view(pidl2));
+    BOOST_CHECK(apidl_view(pidl1).parent() != apidl_view(pidl2));
+    BOOST_CHECK(apidl_view(pidl1).parent() == apidl_view(pidl2.parent()));
+    BOOST_CHECK(apidl_view() == apidl_view(apidl_view(pidl1).prefix(0)));
+}
+
+/**
+ * Converting a bounded view back to a PIDL copies and terminates it.
+ */
+BOOST_AUTO_TEST_CASE( convert_to_pidl )
+{
+    apidl_t pidl = mary_had_a_little_lamb();
+    apidl_t copy(apidl_view(pidl).prefix(3));
+
+    BOOST_CHECK_NE(copy.get(), pidl.get());
+    BOOST_CHECK_EQUAL(copy.size(), apidl_view(pidl).prefix(3).size());
+    BOOST_CHECK(pidl_matches_text(copy.last_item().get(), "a"));
+
+    cpidl_t item(apidl_view(pidl).last_item());
+    BOOST_CHECK(pidl_matches_text(item.get(), "lamb"));
+}
+
+/**
+ * Child views can be upcast to relative views.
+ */
+BOOST_AUTO_TEST_CASE( upcast )
+{
+    apidl_t pidl = mary_had_a_little_lamb();
+    pidl_view view = apidl_view(pidl).last_item();
+
+    BOOST_CHECK(pidl_matches_text(view.get(), "lamb"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
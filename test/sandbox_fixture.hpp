@@ -34,12 +34,16 @@
 #pragma once
 
 #include <washer/filesystem.hpp> // temporary_directory_path, unique_path
+#include <washer/shell/pidl.hpp> // apidl_t
+#include <washer/shell/shell.hpp> // pidl_from_parsing_name
 
 #include <boost/filesystem.hpp> // wpath
 #include <boost/filesystem/fstream.hpp> // wofstream
 #include <boost/shared_ptr.hpp>
 #include <boost/test/unit_test.hpp> // BOOST_REQUIRE etc.
 
+#include <algorithm> // sort
+#include <cstddef> // size_t
 #include <cstdio> // _wtempnam
 #include <string>
 #include <vector>
@@ -169,6 +173,47 @@ public:
         return new_directory_in_sandbox(sandbox());
     }
 
+    /**
+     * Fill the sandbox with new empty files and return their paths, sorted.
+     */
+    std::vector<std::wstring> create_files(std::size_t count)
+    {
+        std::vector<std::wstring> paths;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            boost::filesystem::wpath file = new_file_in_sandbox();
+#if defined(BOOST_FILESYSTEM_VERSION) && BOOST_FILESYSTEM_VERSION < 3
+            paths.push_back(file.string());
+#else
+            paths.push_back(file.wstring());
+#endif
+        }
+
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    /**
+     * Absolute PIDL of an item in the filesystem.
+     */
+    washer::shell::pidl::apidl_t path_pidl(
+        const boost::filesystem::wpath& path)
+    {
+#if defined(BOOST_FILESYSTEM_VERSION) && BOOST_FILESYSTEM_VERSION < 3
+        return washer::shell::pidl_from_parsing_name(path.string());
+#else
+        return washer::shell::pidl_from_parsing_name(path.wstring());
+#endif
+    }
+
+    /**
+     * Absolute PIDL of the sandbox directory.
+     */
+    washer::shell::pidl::apidl_t sandbox_pidl()
+    {
+        return path_pidl(sandbox());
+    }
+
 private:
     boost::filesystem::wpath m_sandbox;
 };
@@ -0,0 +1,198 @@
+/**
+    @file
+
+    Unit tests for basic_shared_pidl.
+
+    @if license
+
+    Copyright (C) 2026  Alexander Lamaison <awl03@doc.ic.ac.uk>
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    If you modify this Program, or any covered work, by linking or
+    combining it with the OpenSSL project's OpenSSL library (or a
+    modified version of that library), containing parts covered by the
+    terms of the OpenSSL or SSLeay licenses, the licensors of this
+    Program grant you additional permission to convey the resulting work.
+
+    @endif
+*/
+
+#include "pidl_fixtures.hpp" // child_pidl_from_text, absolute_pidl_from_texts
+
+#include <washer/shell/shared_pidl.hpp> // test subject
+
+#include <boost/test/unit_test.hpp>
+#include <boost/version.hpp>
+#if (BOOST_VERSION >= 104800)
+#include <boost/move/move.hpp> // move
+#endif
+
+#include <stdexcept> // logic_error
+#include <string>
+#include <vector>
+
+using namespace washer::shell::pidl;
+using washer::test::absolute_pidl_from_texts;
+using washer::test::child_pidl_from_text;
+using washer::test::pidl_matches_text;
+
+using std::string;
+using std::vector;
+
+namespace {
+
+    apidl_t folder_pidl()
+    {
+        vector<string> texts;
+        texts.push_back("Computer");
+        texts.push_back("C:");
+        texts.push_back("Windows");
+        return absolute_pidl_from_texts(texts);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(shared_pidl_tests)
+
+/**
+ * Default construction gives a NULL PIDL.
+ */
+BOOST_AUTO_TEST_CASE( create )
+{
+    shared_apidl_t pidl;
+    BOOST_CHECK(!pidl.get());
+    BOOST_CHECK(!pidl);
+    BOOST_CHECK(pidl.empty());
+    BOOST_CHECK(pidl.unique());
+}
+
+/**
+ * Constructing from a raw PIDL copies it.
+ */
+BOOST_AUTO_TEST_CASE( create_from_raw )
+{
+    apidl_t source = folder_pidl();
+    shared_apidl_t pidl(source.get());
+
+    BOOST_CHECK(pidl.get() != source.get());
+    BOOST_CHECK(raw_pidl::equal(pidl.get(), source.get()));
+    BOOST_CHECK_EQUAL(pidl.size(), source.size());
+}
+
+/**
+ * Copies share the same PIDL.
+ */
+BOOST_AUTO_TEST_CASE( copy_shares )
+{
+    shared_apidl_t pidl(folder_pidl().get());
+    shared_apidl_t copy = pidl;
+
+    BOOST_CHECK_EQUAL(copy.get(), pidl.get());
+    BOOST_CHECK(!pidl.unique());
+    BOOST_CHECK(pidl == copy);
+
+    vector<shared_apidl_t> pidls(10, pidl);
+    BOOST_CHECK_EQUAL(pidls.back().get(), pidl.get());
+}
+
+/**
+ * Appending to a copy leaves the other copies unchanged.
+ */
+BOOST_AUTO_TEST_CASE( append_detaches )
+{
+    apidl_t source = folder_pidl();
+    shared_apidl_t pidl(source.get());
+    shared_apidl_t copy = pidl;
+
+    copy += child_pidl_from_text("System32").get();
+
+    BOOST_CHECK(copy.get() != pidl.get());
+    BOOST_CHECK(pidl.unique());
+    BOOST_CHECK(raw_pidl::equal(pidl.get(), source.get()));
+    BOOST_CHECK(pidl_matches_text(copy.last_item().get(), "System32"));
+    BOOST_CHECK(copy.parent() == pidl);
+}
+
+/**
+ * Writing through out() leaves the other copies unchanged.
+ */
+BOOST_AUTO_TEST_CASE( out_detaches )
+{
+    shared_apidl_t pidl(folder_pidl().get());
+    shared_apidl_t copy = pidl;
+
+    PIDLIST_ABSOLUTE* out = copy.out();
+    BOOST_CHECK(!copy);
+    BOOST_CHECK(pidl);
+
+    folder_pidl().parent().copy_to(*out);
+    BOOST_CHECK(copy == pidl.parent());
+}
+
+/**
+ * Joining shared PIDLs gives a new PIDL.
+ */
+BOOST_AUTO_TEST_CASE( join )
+{
+    shared_apidl_t parent(folder_pidl().get());
+    shared_cpidl_t child(child_pidl_from_text("System32").get());
+
+    shared_apidl_t pidl = parent + child;
+
+    BOOST_CHECK_EQUAL(pidl.size(), parent.size() + child.size() - 2);
+    BOOST_CHECK(pidl.last_item() == child);
+    BOOST_CHECK(pidl.parent() == parent);
+}
+
+/**
+ * Empty PIDLs have no parent or last item.
+ */
+BOOST_AUTO_TEST_CASE( empty_navigation )
+{
+    shared_apidl_t pidl;
+    BOOST_CHECK_THROW(pidl.parent(), std::logic_error);
+    BOOST_CHECK_THROW(pidl.last_item(), std::logic_error);
+}
+
+/**
+ * Converting to basic_pidl gives an unshared copy.
+ */
+BOOST_AUTO_TEST_CASE( convert_to_basic_pidl )
+{
+    shared_apidl_t pidl(folder_pidl().get());
+    apidl_t copy = pidl;
+
+    BOOST_CHECK(copy.get() != pidl.get());
+    BOOST_CHECK(raw_pidl::equal(copy.get(), pidl.get()));
+}
+
+#if (BOOST_VERSION >= 104800)
+
+/**
+ * Moving a basic_pidl in adopts its memory.
+ */
+BOOST_AUTO_TEST_CASE( adopt_basic_pidl )
+{
+    apidl_t source = folder_pidl();
+    PCIDLIST_ABSOLUTE raw = source.get();
+
+    shared_apidl_t pidl(boost::move(source));
+
+    BOOST_CHECK_EQUAL(pidl.get(), raw);
+    BOOST_CHECK(!source);
+}
+
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -331,3 +331,102 @@ BOOST_AUTO_TEST_CASE( relative_friendly_name )
 }
 
 BOOST_AUTO_TEST_SUITE_END();
+
+namespace {
+
+    pidl::apidl_t pidl_from_path(const wpath& path)
+    {
+#if defined(BOOST_FILESYSTEM_VERSION) && BOOST_FILESYSTEM_VERSION > 2
+        return pidl_from_parsing_name(path.wstring());
+#else
+        return pidl_from_parsing_name(path.string());
+#endif
+    }
+
+    /**
+     * Context with an empty name cache.
+     */
+    shell_context name_cache_context()
+    {
+        shell_context context;
+        context.names.reset(new display_name_cache(16));
+        return context;
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(shell_item_cached_name_tests, sandbox_fixture)
+
+/**
+ * Asking for the same name again is answered by the cache.
+ */
+BOOST_AUTO_TEST_CASE( repeated_name )
+{
+    wpath file = new_file_in_sandbox();
+    shell_context context = name_cache_context();
+    pidl_shell_item item(pidl_from_path(file), context);
+
+    wstring first = item.parsing_name(shell_item::parsing_name_type::relative);
+    wstring second = item.parsing_name(
+        shell_item::parsing_name_type::relative);
+
+    BOOST_CHECK_EQUAL(first, file.filename());
+    BOOST_CHECK_EQUAL(second, first);
+    BOOST_CHECK_EQUAL(context.names->statistics().misses, 1U);
+    BOOST_CHECK_EQUAL(context.names->statistics().hits, 1U);
+}
+
+/**
+ * Different kinds of name are cached separately.
+ */
+BOOST_AUTO_TEST_CASE( different_names )
+{
+    wpath file = new_file_in_sandbox(sandbox(), L".txt");
+    shell_context context = name_cache_context();
+    pidl_shell_item item(pidl_from_path(file), context);
+
+    item.parsing_name(shell_item::parsing_name_type::relative);
+    wstring name = item.friendly_name(
+        shell_item::friendly_name_type::editable);
+
+    BOOST_CHECK_EQUAL(name, file.stem()); // no extension
+    BOOST_CHECK_EQUAL(context.names->size(), 2U);
+    BOOST_CHECK_EQUAL(context.names->statistics().hits, 0U);
+}
+
+/**
+ * Items for the same PIDL share cached names.
+ */
+BOOST_AUTO_TEST_CASE( shared_between_items )
+{
+    wpath file = new_file_in_sandbox();
+    shell_context context = name_cache_context();
+
+    wstring first =
+        pidl_shell_item(pidl_from_path(file), context).parsing_name();
+    wstring second =
+        pidl_shell_item(pidl_from_path(file), context).parsing_name();
+
+    BOOST_CHECK_EQUAL(second, first);
+
+    BOOST_CHECK_EQUAL(context.names->statistics().hits, 1U);
+}
+
+/**
+ * Invalidated names are fetched again.
+ */
+BOOST_AUTO_TEST_CASE( invalidated_name )
+{
+    wpath file = new_file_in_sandbox();
+    pidl::apidl_t pidl = pidl_from_path(file);
+    shell_context context = name_cache_context();
+    pidl_shell_item item(pidl, context);
+
+    item.parsing_name();
+    context.names->invalidate_subtree(pidl_from_path(sandbox()));
+    item.parsing_name();
+
+    BOOST_CHECK_EQUAL(context.names->statistics().misses, 2U);
+    BOOST_CHECK_EQUAL(context.names->statistics().hits, 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
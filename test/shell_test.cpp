@@ -32,6 +32,9 @@
 #include "wchar_output.hpp" // wstring output
 #include "sandbox_fixture.hpp" // sandbox_fixture
 
+#include <washer/shell/display_name_list.hpp> // display_names
+#include <washer/shell/enum_items.hpp> // enum_items
+#include <washer/shell/parent_folder_cache.hpp> // parent_folder_cache
 #include <washer/shell/shell.hpp> // test subject
 #include <washer/shell/shell_item.hpp> // pidl_shell_item
 
@@ -40,8 +43,10 @@
 
 #include <boost/filesystem/path.hpp> // wpath
 #include <boost/filesystem/fstream.hpp> // ofstream
+#include <boost/make_shared.hpp> // make_shared
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm> // sort
 #include <string>
 #include <vector>
 
@@ -50,12 +55,16 @@ using comet::com_ptr;
 
 using namespace washer::shell;
 using washer::shell::pidl::apidl_t;
+using washer::shell::pidl::cpidl_t;
 using washer::test::sandbox_fixture;
 
 using boost::filesystem::ofstream;
 using boost::filesystem::wpath;
+using boost::iterator_range;
+using boost::make_shared;
 using boost::test_tools::predicate_result;
 
+using std::sort;
 using std::string;
 using std::wstring;
 using std::vector;
@@ -185,6 +194,155 @@ BOOST_AUTO_TEST_CASE( handler_object )
     BOOST_REQUIRE_NE(enum_items->Next(1, &child_pidl, NULL), S_OK);
 }
 
+/**
+ * Binding to the parents of two items in the same folder through a context
+ * binds the folder once and reuses it.
+ */
+BOOST_AUTO_TEST_CASE( bind_to_parent_with_context )
+{
+    auto_coinit com;
+
+    wpath first = new_file_in_sandbox();
+    wpath second = new_file_in_sandbox();
+
+    shell_context context;
+    context.folders = make_shared<parent_folder_cache>(10);
+
+    apidl_t first_pidl = path_pidl(first);
+    apidl_t second_pidl = path_pidl(second);
+
+    com_ptr<IShellFolder> first_parent =
+        bind_to_parent<IShellFolder>(first_pidl, context);
+    com_ptr<IShellFolder> second_parent =
+        bind_to_parent<IShellFolder>(second_pidl, context);
+
+    BOOST_CHECK(first_parent.get() == second_parent.get());
+    BOOST_CHECK_EQUAL(context.folders->size(), 1U);
+    BOOST_CHECK_EQUAL(context.folders->statistics().hits, 1U);
+
+    BOOST_CHECK(pidl_path_equivalence(first_pidl, first));
+    BOOST_CHECK(
+        second == pidl_shell_item(second_pidl, context).parsing_name());
+    BOOST_CHECK_EQUAL(context.folders->statistics().hits, 2U);
+
+    context.folders->release_apartment();
+    BOOST_CHECK_EQUAL(context.folders->size(), 0U);
+}
+
+/**
+ * Interfaces other than IShellFolder are bound without the folder cache.
+ */
+BOOST_AUTO_TEST_CASE( bind_to_parent_other_interface_with_context )
+{
+    auto_coinit com;
+
+    wpath file = new_file_in_sandbox();
+
+    shell_context context;
+    context.folders = make_shared<parent_folder_cache>(10);
+
+    apidl_t pidl = path_pidl(file);
+
+    BOOST_CHECK(bind_to_parent<IPersistFolder2>(pidl, context));
+    BOOST_CHECK_EQUAL(context.folders->size(), 0U);
+    BOOST_CHECK_EQUAL(context.folders->statistics().misses, 0U);
+}
+
+/**
+ * A stream bound through a context is the same as one bound without.
+ */
+BOOST_AUTO_TEST_CASE( stream_from_file_pidl_with_context )
+{
+    auto_coinit com;
+
+    wpath test_file_path = new_file_in_sandbox();
+
+    shell_context context;
+    context.folders = make_shared<parent_folder_cache>(10);
+
+    apidl_t pidl = path_pidl(test_file_path);
+
+    BOOST_CHECK(stream_from_pidl(pidl, context));
+    BOOST_CHECK(stream_from_pidl(pidl, context));
+    BOOST_CHECK_EQUAL(context.folders->statistics().hits, 1U);
+
+    context.folders->release_apartment();
+}
+
+/**
+ * The names of several items in a folder fetched together match the names
+ * fetched one at a time.
+ */
+BOOST_AUTO_TEST_CASE( display_names_of_files )
+{
+    auto_coinit com;
+
+    vector<wstring> files = create_files(3);
+    apidl_t folder = sandbox_pidl();
+
+    vector<cpidl_t> items;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        items.push_back(pidl_from_parsing_name(files[i]).last_item());
+    }
+
+    display_name_list names = display_names(
+        folder, items.begin(), items.end(), SHGDN_FORPARSING);
+
+    BOOST_REQUIRE_EQUAL(names.size(), files.size());
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        BOOST_CHECK_EQUAL(names[i], files[i]);
+        BOOST_CHECK_EQUAL(names.length(i), names[i].size());
+        BOOST_CHECK_EQUAL(
+            names[i], pidl_shell_item(folder + items[i]).parsing_name());
+    }
+}
+
+/**
+ * Names can be fetched straight from an enumeration of the folder, whose
+ * items can only be read once.
+ */
+BOOST_AUTO_TEST_CASE( display_names_of_enumeration )
+{
+    auto_coinit com;
+
+    vector<wstring> files = create_files(3);
+
+    iterator_range<enum_item_iterator> items = enum_items(
+        bind_to_handler_object<IShellFolder>(sandbox_pidl()),
+        SHCONTF_FOLDERS | SHCONTF_NONFOLDERS);
+
+    display_name_list names = display_names(
+        sandbox_pidl(), items.begin(), items.end(), SHGDN_FORPARSING);
+
+    BOOST_REQUIRE_EQUAL(names.size(), files.size());
+
+    vector<wstring> fetched;
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        fetched.push_back(names[i]);
+    }
+    sort(fetched.begin(), fetched.end());
+
+    BOOST_CHECK_EQUAL_COLLECTIONS(
+        fetched.begin(), fetched.end(), files.begin(), files.end());
+}
+
+/**
+ * Fetching the names of no items gives an empty list.
+ */
+BOOST_AUTO_TEST_CASE( display_names_of_nothing )
+{
+    auto_coinit com;
+
+    vector<cpidl_t> items;
+    display_name_list names = display_names(
+        sandbox_pidl(), items.begin(), items.end(), SHGDN_NORMAL);
+
+    BOOST_CHECK(names.empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END();
 
 /**